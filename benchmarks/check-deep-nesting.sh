@@ -0,0 +1,58 @@
+#!/bin/sh
+# Generates deeply nested sources for each recursive production of the parser, and checks
+# that the interpreter reports them as too deeply nested instead of crashing.
+
+INTERPRETER=${INTERPRETER:-build/bootstrap-interpreter}
+DEPTH=${DEPTH:-100000}
+WORKING_DIRECTORY=$(mktemp -d)
+trap 'rm -rf "$WORKING_DIRECTORY"' EXIT
+
+generate() {
+    awk -v depth="$1" -v prefix="$2" -v middle="$3" -v suffix="$4" 'BEGIN {
+        for(i = 0; i < depth; ++i) printf "%s", prefix;
+        printf "%s", middle;
+        for(i = 0; i < depth; ++i) printf "%s", suffix;
+        printf "\n";
+    }'
+}
+
+failures=0
+check() {
+    name=$1
+    expected=$2
+    shift 2
+    generate "$@" > "$WORKING_DIRECTORY/$name.sysmel"
+    output=$("$INTERPRETER" "$WORKING_DIRECTORY/$name.sysmel" 2>&1)
+    status=$?
+    if [ $status -ge 128 ]; then
+        echo "FAILED $name: crashed with status $status"
+        failures=$((failures + 1))
+    elif [ -n "$expected" ] && ! echo "$output" | grep -q "$expected"; then
+        echo "FAILED $name: expected \"$expected\""
+        failures=$((failures + 1))
+    elif [ -z "$expected" ] && [ $status -ne 0 ]; then
+        echo "FAILED $name: failed a nesting below the limit"
+        failures=$((failures + 1))
+    else
+        echo "ok $name"
+    fi
+}
+
+TOO_DEEP="Maximum nesting depth exceeded"
+check parentheses "$TOO_DEEP" "$DEPTH" "(" "1" ")"
+check blocks "$TOO_DEEP" "$DEPTH" "{" "1" "}"
+check block-types "$TOO_DEEP" "$DEPTH" "{| " "a" "| 1}"
+check arrays "$TOO_DEEP" "$DEPTH" "[" "1" "]"
+check dictionaries "$TOO_DEEP" "$DEPTH" "#{a: " "1" "}"
+check dictionary-keys "$TOO_DEEP" "$DEPTH" "#{" "1" "}"
+check associations "$TOO_DEEP" "$DEPTH" "a : " "1" ""
+check keyword-arguments "$TOO_DEEP" "$DEPTH" "a foo: [" "1" "]"
+check assignments "$TOO_DEEP" "$DEPTH" "a := " "1" ""
+check bind-chains "$TOO_DEEP" "$DEPTH" "a <- " "1" ""
+check functional-types "$TOO_DEEP" "$DEPTH" "a :: " "b" ""
+check quotes "$TOO_DEEP" "$DEPTH" "\`'" "a" ""
+check shallow-parentheses "" 500 "(" "1" ")"
+check shallow-blocks "" 500 "{" "1" "}"
+check shallow-assignments "" 1000 ":!a := " "1" ""
+
+[ $failures -eq 0 ]
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Applies random edits to the samples and the benchmarks with the incremental parser, and checks
+# that its tokens, parse tree and source positions match a full parse of the text after each edit.
+
+INTERPRETER=${INTERPRETER:-build/bootstrap-interpreter}
+EDITS=${EDITS:-3000}
+
+failures=0
+for source in samples/*.sysmel benchmarks/*.sysmel; do
+    if ! "$INTERPRETER" -check-edits "$EDITS" "$source"; then
+        echo "FAILED $source"
+        failures=$((failures + 1))
+    fi
+done
+
+[ $failures -eq 0 ]
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Runs every benchmark with the message send and allocation statistics enabled.
+# The instruction count is also reported when perf is available.
+
+INTERPRETER=${INTERPRETER:-build/bootstrap-interpreter}
+for benchmark in benchmarks/*.sysmel; do
+    echo "== $benchmark"
+    if command -v perf > /dev/null 2>&1; then
+        perf stat -e instructions "$INTERPRETER" -stats "$@" "$benchmark"
+    else
+        "$INTERPRETER" -stats "$@" "$benchmark"
+    fi
+done
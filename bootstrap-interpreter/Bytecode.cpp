@@ -0,0 +1,66 @@
+#include "Bytecode.hpp"
+#include <string.h>
+
+namespace Sysmel
+{
+
+static const char *BytecodeOpcodeNames[] = {
+#define BytecodeOpcodeName(name) #name,
+#include "BytecodeOpcode.inc"
+#undef BytecodeOpcodeName
+};
+
+const char *getBytecodeOpcodeName(BytecodeOpcode opcode)
+{
+    return BytecodeOpcodeNames[int(opcode)];
+}
+
+void BytecodeFunction::printStringOn(std::ostream &out) const
+{
+    out << "BytecodeFunction(" << registerCount << " registers, " << unboxedRegisterCount << " unboxed registers)\n";
+    for(size_t i = 0; i < instructions.size(); ++i)
+    {
+        auto &instruction = instructions[i];
+        out << "    " << i << ": " << getBytecodeOpcodeName(instruction.opcode)
+            << " " << instruction.a << " " << instruction.b << " " << instruction.c;
+        if(instruction.count)
+            out << " #" << int(instruction.count);
+        if(instruction.opcode == BytecodeOpcode::Send)
+            out << " " << inlineCaches[instruction.c].selector->printString();
+        out << "\n";
+    }
+}
+
+static EvaluationEngine currentEvaluationEngine = EvaluationEngine::Bytecode;
+
+EvaluationEngine getEvaluationEngine()
+{
+    return currentEvaluationEngine;
+}
+
+void setEvaluationEngine(EvaluationEngine engine)
+{
+    currentEvaluationEngine = engine;
+}
+
+bool parseEvaluationEngineName(const char *name, EvaluationEngine &result)
+{
+    if(!strcmp(name, "tree"))
+        result = EvaluationEngine::TreeWalker;
+    else if(!strcmp(name, "bytecode"))
+        result = EvaluationEngine::Bytecode;
+    else
+        return false;
+    return true;
+}
+
+ValuePtr evaluateAnalyzedValueInEnvironment(const ValuePtr &analyzedValue, const EnvironmentPtr &environment)
+{
+    if(currentEvaluationEngine == EvaluationEngine::TreeWalker || !analyzedValue->isSemanticValue())
+        return analyzedValue->evaluateInEnvironment(environment);
+
+    auto function = BytecodeCompiler::compileFunctionBody(analyzedValue);
+    return evaluateBytecodeFunctionInEnvironment(*function, environment);
+}
+
+} // End of namespace Sysmel
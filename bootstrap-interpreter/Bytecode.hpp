@@ -0,0 +1,131 @@
+#ifndef SYSMEL_BYTECODE_HPP
+#define SYSMEL_BYTECODE_HPP
+
+#pragma once
+
+#include "Value.hpp"
+#include "InlineCache.hpp"
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace Sysmel
+{
+
+/**
+ * BytecodeOpcode. The different instructions of the register machine.
+ */
+enum class BytecodeOpcode : uint8_t
+{
+#define BytecodeOpcodeName(name) name,
+#include "BytecodeOpcode.inc"
+#undef BytecodeOpcodeName
+};
+
+const char *getBytecodeOpcodeName(BytecodeOpcode opcode);
+
+/**
+ * PrimitiveNumberKind. The primitive number types whose values can live in unboxed registers.
+ */
+enum class PrimitiveNumberKind : uint8_t
+{
+#define PrimitiveIntegerKindName(name) name,
+#define PrimitiveFloatKindName(name) name,
+#include "PrimitiveNumberKind.inc"
+#undef PrimitiveIntegerKindName
+#undef PrimitiveFloatKindName
+};
+
+/**
+ * I am a register machine instruction. The meaning of the a, b and c operands depends on the opcode.
+ * Sends, applications and aggregate constructions take their operands from count contiguous registers.
+ * The c operand of a send is the index of its inline cache.
+ * Unboxed instructions operate on a separate register file of raw primitive numbers, whose kind is given by count.
+ */
+struct BytecodeInstruction
+{
+    BytecodeOpcode opcode;
+    uint8_t count;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+};
+
+/**
+ * I am a semantic tree body lowered into register machine code.
+ */
+class BytecodeFunction : public Value
+{
+public:
+    virtual void printStringOn(std::ostream &out) const override;
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(constants);
+    }
+
+    std::vector<BytecodeInstruction> instructions;
+    std::vector<ValuePtr> constants;
+    mutable std::vector<InlineCache> inlineCaches;
+    size_t registerCount = 0;
+    size_t unboxedRegisterCount = 0;
+};
+
+/**
+ * The strategy used for evaluating analyzed semantic values.
+ */
+enum class EvaluationEngine : uint8_t
+{
+    TreeWalker,
+    Bytecode,
+};
+
+EvaluationEngine getEvaluationEngine();
+void setEvaluationEngine(EvaluationEngine engine);
+bool parseEvaluationEngineName(const char *name, EvaluationEngine &result);
+
+/**
+ * I lower semantic trees into bytecode functions. Nodes without a specific lowering are evaluated by the tree walker.
+ */
+class BytecodeCompiler
+{
+public:
+    static BytecodeFunctionPtr compileFunctionBody(const ValuePtr &body);
+
+    void compileValueInto(const ValuePtr &value, uint16_t resultRegister);
+    void compileEvaluateTreeInto(const ValuePtr &value, uint16_t resultRegister);
+    void compileConstantInto(const ValuePtr &constant, uint16_t resultRegister);
+    uint16_t compileValuesIntoNewRegisters(const std::vector<ValuePtr> &values);
+    void compileValueForEffect(const ValuePtr &value);
+    void compileUnboxedValueInto(const ValuePtr &value, uint16_t unboxedRegister, PrimitiveNumberKind kind);
+
+    static bool getPrimitiveNumberKindOfType(const ValuePtr &type, PrimitiveNumberKind &kind);
+
+    uint16_t allocateRegisters(size_t count);
+    uint16_t getRegisterMark() const;
+    void releaseRegistersDownTo(uint16_t mark);
+
+    uint16_t allocateUnboxedRegisters(size_t count);
+    uint16_t getUnboxedRegisterMark() const;
+    void releaseUnboxedRegistersDownTo(uint16_t mark);
+
+    uint16_t addConstant(const ValuePtr &constant);
+    uint16_t addInlineCache(const ValuePtr &selector);
+    size_t emit(BytecodeOpcode opcode, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, uint8_t count = 0);
+    size_t getNextInstructionIndex() const;
+    void patchJumpTargetToNextInstruction(size_t jumpInstructionIndex);
+
+private:
+    BytecodeFunctionPtr function;
+    std::map<ValuePtr, uint16_t> constantIndices;
+    uint16_t usedRegisterCount = 0;
+    uint16_t usedUnboxedRegisterCount = 0;
+};
+
+ValuePtr evaluateBytecodeFunctionInEnvironment(const BytecodeFunction &function, const EnvironmentPtr &environment);
+ValuePtr evaluateAnalyzedValueInEnvironment(const ValuePtr &analyzedValue, const EnvironmentPtr &environment);
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_BYTECODE_HPP
@@ -0,0 +1,556 @@
+#include "Bytecode.hpp"
+#include "Semantics.hpp"
+#include "Assert.hpp"
+
+namespace Sysmel
+{
+
+BytecodeFunctionPtr BytecodeCompiler::compileFunctionBody(const ValuePtr &body)
+{
+    BytecodeCompiler compiler;
+    compiler.function = makeRef<BytecodeFunction> ();
+    auto resultRegister = compiler.allocateRegisters(1);
+    compiler.compileValueInto(body, resultRegister);
+    compiler.emit(BytecodeOpcode::Return, resultRegister);
+    return compiler.function;
+}
+
+void BytecodeCompiler::compileValueInto(const ValuePtr &value, uint16_t resultRegister)
+{
+    value->compileBytecodeInto(*this, resultRegister);
+}
+
+void BytecodeCompiler::compileEvaluateTreeInto(const ValuePtr &value, uint16_t resultRegister)
+{
+    emit(BytecodeOpcode::EvaluateTree, resultRegister, addConstant(value));
+}
+
+void BytecodeCompiler::compileConstantInto(const ValuePtr &constant, uint16_t resultRegister)
+{
+    emit(BytecodeOpcode::LoadConstant, resultRegister, addConstant(constant));
+}
+
+uint16_t BytecodeCompiler::compileValuesIntoNewRegisters(const std::vector<ValuePtr> &values)
+{
+    auto firstRegister = allocateRegisters(values.size());
+    for(size_t i = 0; i < values.size(); ++i)
+        compileValueInto(values[i], uint16_t(firstRegister + i));
+    return firstRegister;
+}
+
+uint16_t BytecodeCompiler::allocateRegisters(size_t count)
+{
+    sysmelAssert(usedRegisterCount + count <= 0xFFFF);
+    auto firstRegister = usedRegisterCount;
+    usedRegisterCount = uint16_t(usedRegisterCount + count);
+    if(usedRegisterCount > function->registerCount)
+        function->registerCount = usedRegisterCount;
+    return firstRegister;
+}
+
+void BytecodeCompiler::compileValueForEffect(const ValuePtr &value)
+{
+    value->compileBytecodeForEffect(*this);
+}
+
+void BytecodeCompiler::compileUnboxedValueInto(const ValuePtr &value, uint16_t unboxedRegister, PrimitiveNumberKind kind)
+{
+    value->compileUnboxedBytecodeInto(*this, unboxedRegister, kind);
+}
+
+bool BytecodeCompiler::getPrimitiveNumberKindOfType(const ValuePtr &type, PrimitiveNumberKind &kind)
+{
+    if(!type || !type->isPrimitiveNumberType())
+        return false;
+
+    auto &numberType = static_cast<PrimitiveNumberType&> (*type);
+    auto size = numberType.size();
+    if(numberType.isFloatingPoint())
+    {
+        switch(size)
+        {
+        case 4: kind = PrimitiveNumberKind::Float32; return true;
+        case 8: kind = PrimitiveNumberKind::Float64; return true;
+        default: return false;
+        }
+    }
+    else if(numberType.isCharacter())
+    {
+        switch(size)
+        {
+        case 1: kind = PrimitiveNumberKind::Char8; return true;
+        case 2: kind = PrimitiveNumberKind::Char16; return true;
+        case 4: kind = PrimitiveNumberKind::Char32; return true;
+        default: return false;
+        }
+    }
+    else if(numberType.isSigned())
+    {
+        switch(size)
+        {
+        case 1: kind = PrimitiveNumberKind::Int8; return true;
+        case 2: kind = PrimitiveNumberKind::Int16; return true;
+        case 4: kind = PrimitiveNumberKind::Int32; return true;
+        case 8: kind = PrimitiveNumberKind::Int64; return true;
+        default: return false;
+        }
+    }
+    else
+    {
+        switch(size)
+        {
+        case 1: kind = PrimitiveNumberKind::UInt8; return true;
+        case 2: kind = PrimitiveNumberKind::UInt16; return true;
+        case 4: kind = PrimitiveNumberKind::UInt32; return true;
+        case 8: kind = PrimitiveNumberKind::UInt64; return true;
+        default: return false;
+        }
+    }
+}
+
+uint16_t BytecodeCompiler::getRegisterMark() const
+{
+    return usedRegisterCount;
+}
+
+void BytecodeCompiler::releaseRegistersDownTo(uint16_t mark)
+{
+    sysmelAssert(mark <= usedRegisterCount);
+    usedRegisterCount = mark;
+}
+
+uint16_t BytecodeCompiler::allocateUnboxedRegisters(size_t count)
+{
+    sysmelAssert(usedUnboxedRegisterCount + count <= 0xFFFF);
+    auto firstRegister = usedUnboxedRegisterCount;
+    usedUnboxedRegisterCount = uint16_t(usedUnboxedRegisterCount + count);
+    if(usedUnboxedRegisterCount > function->unboxedRegisterCount)
+        function->unboxedRegisterCount = usedUnboxedRegisterCount;
+    return firstRegister;
+}
+
+uint16_t BytecodeCompiler::getUnboxedRegisterMark() const
+{
+    return usedUnboxedRegisterCount;
+}
+
+void BytecodeCompiler::releaseUnboxedRegistersDownTo(uint16_t mark)
+{
+    sysmelAssert(mark <= usedUnboxedRegisterCount);
+    usedUnboxedRegisterCount = mark;
+}
+
+uint16_t BytecodeCompiler::addConstant(const ValuePtr &constant)
+{
+    auto it = constantIndices.find(constant);
+    if(it != constantIndices.end())
+        return it->second;
+
+    sysmelAssert(function->constants.size() < 0xFFFF);
+    auto index = uint16_t(function->constants.size());
+    function->constants.push_back(constant);
+    constantIndices.insert(std::make_pair(constant, index));
+    return index;
+}
+
+uint16_t BytecodeCompiler::addInlineCache(const ValuePtr &selector)
+{
+    sysmelAssert(function->inlineCaches.size() < 0xFFFF);
+    auto index = uint16_t(function->inlineCaches.size());
+    function->inlineCaches.push_back(InlineCache(selector));
+    return index;
+}
+
+size_t BytecodeCompiler::emit(BytecodeOpcode opcode, uint16_t a, uint16_t b, uint16_t c, uint8_t count)
+{
+    sysmelAssert(function->instructions.size() < 0xFFFF);
+    function->instructions.push_back(BytecodeInstruction{opcode, count, a, b, c});
+    return function->instructions.size() - 1;
+}
+
+size_t BytecodeCompiler::getNextInstructionIndex() const
+{
+    return function->instructions.size();
+}
+
+void BytecodeCompiler::patchJumpTargetToNextInstruction(size_t jumpInstructionIndex)
+{
+    function->instructions[jumpInstructionIndex].b = uint16_t(getNextInstructionIndex());
+}
+
+void Value::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(isSemanticValue())
+        compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+    else
+        compiler.compileConstantInto(selfRef(), resultRegister);
+}
+
+void Value::compileBytecodeForEffect(BytecodeCompiler &compiler)
+{
+    auto mark = compiler.getRegisterMark();
+    auto scratchRegister = compiler.allocateRegisters(1);
+    compileBytecodeInto(compiler, scratchRegister);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void Value::compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind)
+{
+    auto mark = compiler.getRegisterMark();
+    auto boxedRegister = compiler.allocateRegisters(1);
+    compileBytecodeInto(compiler, boxedRegister);
+    compiler.emit(BytecodeOpcode::Unbox, unboxedRegister, boxedRegister, 0, uint8_t(kind));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticValueSequence::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(elements.empty())
+        return compiler.compileConstantInto(UndefinedObject::uniqueInstance(), resultRegister);
+
+    for(size_t i = 0; i + 1 < elements.size(); ++i)
+        compiler.compileValueForEffect(elements[i]);
+    compiler.compileValueInto(elements.back(), resultRegister);
+}
+
+void SemanticValueSequence::compileBytecodeForEffect(BytecodeCompiler &compiler)
+{
+    for(auto &element : elements)
+        compiler.compileValueForEffect(element);
+}
+
+void SemanticApplication::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(arguments.size() > 0xFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    auto mark = compiler.getRegisterMark();
+    auto firstRegister = compiler.allocateRegisters(1 + arguments.size());
+    compiler.compileValueInto(functional, firstRegister);
+    for(size_t i = 0; i < arguments.size(); ++i)
+        compiler.compileValueInto(arguments[i], uint16_t(firstRegister + 1 + i));
+    compiler.emit(isTailCall ? BytecodeOpcode::TailApply : BytecodeOpcode::Apply, resultRegister, firstRegister, compiler.addConstant(selfRef()), uint8_t(arguments.size()));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+static bool isUnboxedComparisonOpcode(BytecodeOpcode opcode)
+{
+    return opcode >= BytecodeOpcode::UnboxedEquals && opcode <= BytecodeOpcode::UnboxedGreaterOrEquals;
+}
+
+bool SemanticMessageSend::getUnboxedOperation(BytecodeOpcode &opcode, PrimitiveNumberKind &kind)
+{
+    struct UnboxedOperation
+    {
+        const char *selector;
+        BytecodeOpcode opcode;
+        size_t argumentCount;
+        bool isIntegerOnly;
+    };
+
+    static const UnboxedOperation UnboxedOperations[] = {
+        {"negated", BytecodeOpcode::UnboxedNegated, 0, false},
+        {"bitInvert", BytecodeOpcode::UnboxedBitInvert, 0, true},
+        {"+", BytecodeOpcode::UnboxedAdd, 1, false},
+        {"-", BytecodeOpcode::UnboxedSubtract, 1, false},
+        {"*", BytecodeOpcode::UnboxedMultiply, 1, false},
+        {"/", BytecodeOpcode::UnboxedDivide, 1, false},
+        {"//", BytecodeOpcode::UnboxedDivide, 1, false},
+        {"%", BytecodeOpcode::UnboxedRemainder, 1, true},
+        {"&", BytecodeOpcode::UnboxedBitAnd, 1, true},
+        {"|", BytecodeOpcode::UnboxedBitOr, 1, true},
+        {"^", BytecodeOpcode::UnboxedBitXor, 1, true},
+        {"<<", BytecodeOpcode::UnboxedShiftLeft, 1, true},
+        {">>", BytecodeOpcode::UnboxedShiftRight, 1, true},
+        {"=", BytecodeOpcode::UnboxedEquals, 1, false},
+        {"~=", BytecodeOpcode::UnboxedNotEquals, 1, false},
+        {"<", BytecodeOpcode::UnboxedLessThan, 1, false},
+        {"<=", BytecodeOpcode::UnboxedLessOrEquals, 1, false},
+        {">", BytecodeOpcode::UnboxedGreaterThan, 1, false},
+        {">=", BytecodeOpcode::UnboxedGreaterOrEquals, 1, false},
+    };
+
+    auto selectorSymbol = selector->asAnalyzedSymbolValue();
+    if(!selectorSymbol)
+        return false;
+
+    // Primitive number types only get their methods from the intrinsics environment.
+    auto receiverType = receiver->getType();
+    if(!BytecodeCompiler::getPrimitiveNumberKindOfType(receiverType, kind) || !receiverType->lookupSelector(selectorSymbol))
+        return false;
+
+    for(auto &operation : UnboxedOperations)
+    {
+        if(selectorSymbol->value != operation.selector || arguments.size() != operation.argumentCount)
+            continue;
+
+        if(operation.isIntegerOnly && (kind == PrimitiveNumberKind::Float32 || kind == PrimitiveNumberKind::Float64))
+            return false;
+        if(operation.argumentCount == 1 && arguments[0]->getType() != receiverType)
+            return false;
+
+        opcode = operation.opcode;
+        return true;
+    }
+
+    return false;
+}
+
+ValuePtr SemanticMessageSend::evaluatePureSendWithLiteralOperands()
+{
+    auto selectorSymbol = selector->asAnalyzedSymbolValue();
+    if(!selectorSymbol || !receiver->isSemanticLiteralValue())
+        return nullptr;
+
+    std::vector<ValuePtr> operands;
+    operands.reserve(1 + arguments.size());
+    operands.push_back(staticRefCast<SemanticLiteralValue> (receiver)->value);
+    for(auto &argument : arguments)
+    {
+        if(!argument->isSemanticLiteralValue())
+            return nullptr;
+        operands.push_back(staticRefCast<SemanticLiteralValue> (argument)->value);
+    }
+
+    auto method = receiver->getTypeOrClass()->lookupSelector(selectorSymbol);
+    if(!method || !method->isPureFunction())
+        return nullptr;
+
+    return method->applyWithArguments(operands);
+}
+
+void SemanticMessageSend::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    auto selectorSymbol = selector->asAnalyzedSymbolValue();
+    if(!selectorSymbol || arguments.size() > 0xFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    auto pureResult = evaluatePureSendWithLiteralOperands();
+    if(pureResult)
+        return compiler.compileConstantInto(pureResult, resultRegister);
+
+    BytecodeOpcode unboxedOpcode;
+    PrimitiveNumberKind kind;
+    if(getUnboxedOperation(unboxedOpcode, kind))
+    {
+        auto unboxedMark = compiler.getUnboxedRegisterMark();
+        if(isUnboxedComparisonOpcode(unboxedOpcode))
+        {
+            auto operands = compiler.allocateUnboxedRegisters(2);
+            compiler.compileUnboxedValueInto(receiver, operands, kind);
+            compiler.compileUnboxedValueInto(arguments[0], uint16_t(operands + 1), kind);
+            compiler.emit(unboxedOpcode, resultRegister, operands, uint16_t(operands + 1), uint8_t(kind));
+        }
+        else
+        {
+            auto unboxedResult = compiler.allocateUnboxedRegisters(1);
+            compileUnboxedBytecodeInto(compiler, unboxedResult, kind);
+            compiler.emit(BytecodeOpcode::Box, resultRegister, unboxedResult, 0, uint8_t(kind));
+        }
+        compiler.releaseUnboxedRegistersDownTo(unboxedMark);
+        return;
+    }
+
+    auto mark = compiler.getRegisterMark();
+    auto firstRegister = compiler.allocateRegisters(1 + arguments.size());
+    compiler.compileValueInto(receiver, firstRegister);
+    for(size_t i = 0; i < arguments.size(); ++i)
+        compiler.compileValueInto(arguments[i], uint16_t(firstRegister + 1 + i));
+    compiler.emit(BytecodeOpcode::Send, resultRegister, firstRegister, compiler.addInlineCache(selectorSymbol), uint8_t(arguments.size()));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticMessageSend::compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind)
+{
+    auto pureResult = evaluatePureSendWithLiteralOperands();
+    if(pureResult)
+    {
+        compiler.emit(BytecodeOpcode::UnboxConstant, unboxedRegister, compiler.addConstant(pureResult), 0, uint8_t(kind));
+        return;
+    }
+
+    BytecodeOpcode unboxedOpcode;
+    PrimitiveNumberKind operationKind;
+    if(!getUnboxedOperation(unboxedOpcode, operationKind) || operationKind != kind || isUnboxedComparisonOpcode(unboxedOpcode))
+        return SemanticValue::compileUnboxedBytecodeInto(compiler, unboxedRegister, kind);
+
+    compiler.compileUnboxedValueInto(receiver, unboxedRegister, kind);
+    if(arguments.empty())
+    {
+        compiler.emit(unboxedOpcode, unboxedRegister, unboxedRegister, 0, uint8_t(kind));
+        return;
+    }
+
+    auto unboxedMark = compiler.getUnboxedRegisterMark();
+    auto argumentRegister = compiler.allocateUnboxedRegisters(1);
+    compiler.compileUnboxedValueInto(arguments[0], argumentRegister, kind);
+    compiler.emit(unboxedOpcode, unboxedRegister, unboxedRegister, argumentRegister, uint8_t(kind));
+    compiler.releaseUnboxedRegistersDownTo(unboxedMark);
+}
+
+void SemanticLiteralValue::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    compiler.compileConstantInto(value, resultRegister);
+}
+
+void SemanticLiteralValue::compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind)
+{
+    compiler.emit(BytecodeOpcode::UnboxConstant, unboxedRegister, compiler.addConstant(value), 0, uint8_t(kind));
+}
+
+void SemanticArray::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(expressions.size() > 0xFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    auto mark = compiler.getRegisterMark();
+    auto firstRegister = compiler.compileValuesIntoNewRegisters(expressions);
+    compiler.emit(BytecodeOpcode::MakeArray, resultRegister, firstRegister, 0, uint8_t(expressions.size()));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticTuple::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(expressions.size() > 0xFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    auto mark = compiler.getRegisterMark();
+    auto firstRegister = compiler.compileValuesIntoNewRegisters(expressions);
+    compiler.emit(BytecodeOpcode::MakeTuple, resultRegister, firstRegister, compiler.addConstant(type), uint8_t(expressions.size()));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticByteArray::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(byteExpressions.size() > 0xFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    auto mark = compiler.getRegisterMark();
+    auto firstRegister = compiler.compileValuesIntoNewRegisters(byteExpressions);
+    compiler.emit(BytecodeOpcode::MakeByteArray, resultRegister, firstRegister, 0, uint8_t(byteExpressions.size()));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticIdentifierReference::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(frameDepth > 0xFFFF || frameSlotIndex > 0xFFFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    compiler.emit(BytecodeOpcode::LoadFrameSlot, resultRegister, uint16_t(frameSlotIndex), uint16_t(frameDepth));
+}
+
+void SemanticGlobalValueReference::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    compiler.emit(BytecodeOpcode::LoadGlobal, resultRegister, compiler.addConstant(selfRef()));
+}
+
+void SemanticLocalDefinition::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    if(binding->frameSlotIndex > 0xFFFF)
+        return compiler.compileEvaluateTreeInto(selfRef(), resultRegister);
+
+    compiler.compileValueInto(value, resultRegister);
+    compiler.emit(BytecodeOpcode::StoreFrameSlot, resultRegister, uint16_t(binding->frameSlotIndex));
+}
+
+void SemanticAlloca::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    auto mark = compiler.getRegisterMark();
+    uint16_t initialValueRegister = 0;
+    if(initialValueExpression)
+    {
+        initialValueRegister = compiler.allocateRegisters(1);
+        compiler.compileValueInto(initialValueExpression, initialValueRegister);
+    }
+
+    compiler.emit(BytecodeOpcode::Alloca, resultRegister, initialValueRegister, compiler.addConstant(selfRef()), initialValueExpression ? 1 : 0);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticLoadValue::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    compiler.compileValueInto(pointer, resultRegister);
+    compiler.emit(BytecodeOpcode::Load, resultRegister, resultRegister);
+}
+
+void SemanticLoadValue::compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind)
+{
+    auto mark = compiler.getRegisterMark();
+    auto pointerRegister = compiler.allocateRegisters(1);
+    compiler.compileValueInto(pointer, pointerRegister);
+    compiler.emit(BytecodeOpcode::LoadUnboxed, unboxedRegister, pointerRegister, 0, uint8_t(kind));
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticStoreValue::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    auto mark = compiler.getRegisterMark();
+    compiler.compileValueInto(value, resultRegister);
+    auto pointerRegister = compiler.allocateRegisters(1);
+    compiler.compileValueInto(pointer, pointerRegister);
+    compiler.emit(BytecodeOpcode::Store, resultRegister, pointerRegister);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticStoreValue::compileBytecodeForEffect(BytecodeCompiler &compiler)
+{
+    // Without a result, primitive numbers can be stored without boxing them again.
+    PrimitiveNumberKind kind;
+    if(!BytecodeCompiler::getPrimitiveNumberKindOfType(value->getType(), kind))
+        return SemanticValue::compileBytecodeForEffect(compiler);
+
+    auto mark = compiler.getRegisterMark();
+    auto unboxedMark = compiler.getUnboxedRegisterMark();
+    auto valueRegister = compiler.allocateUnboxedRegisters(1);
+    compiler.compileUnboxedValueInto(value, valueRegister, kind);
+    auto pointerRegister = compiler.allocateRegisters(1);
+    compiler.compileValueInto(pointer, pointerRegister);
+    compiler.emit(BytecodeOpcode::StoreUnboxed, valueRegister, pointerRegister, 0, uint8_t(kind));
+    compiler.releaseUnboxedRegistersDownTo(unboxedMark);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticIf::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    ValuePtr voidValue = VoidValue::uniqueInstance();
+    auto mark = compiler.getRegisterMark();
+    auto conditionRegister = compiler.allocateRegisters(1);
+    compiler.compileValueInto(condition, conditionRegister);
+
+    auto notTrueJump = compiler.emit(BytecodeOpcode::JumpIfNotTrue, conditionRegister);
+    compiler.compileValueInto(trueCase ? trueCase : voidValue, resultRegister);
+    auto trueCaseEndJump = compiler.emit(BytecodeOpcode::Jump);
+
+    compiler.patchJumpTargetToNextInstruction(notTrueJump);
+    auto notFalseJump = compiler.emit(BytecodeOpcode::JumpIfNotFalse, conditionRegister);
+    compiler.compileValueInto(falseCase ? falseCase : voidValue, resultRegister);
+    auto falseCaseEndJump = compiler.emit(BytecodeOpcode::Jump);
+
+    // Neither true nor false.
+    compiler.patchJumpTargetToNextInstruction(notFalseJump);
+    compiler.compileConstantInto(voidValue, resultRegister);
+
+    compiler.patchJumpTargetToNextInstruction(trueCaseEndJump);
+    compiler.patchJumpTargetToNextInstruction(falseCaseEndJump);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+void SemanticWhile::compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister)
+{
+    auto mark = compiler.getRegisterMark();
+    auto scratchRegister = compiler.allocateRegisters(1);
+    auto loopHeader = compiler.getNextInstructionIndex();
+    compiler.compileValueInto(condition, scratchRegister);
+    auto exitJump = compiler.emit(BytecodeOpcode::JumpIfNotTrue, scratchRegister);
+    if(body)
+        compiler.compileValueForEffect(body);
+    if(continueAction)
+        compiler.compileValueForEffect(continueAction);
+    compiler.emit(BytecodeOpcode::Jump, 0, uint16_t(loopHeader));
+
+    compiler.patchJumpTargetToNextInstruction(exitJump);
+    compiler.compileConstantInto(VoidValue::uniqueInstance(), resultRegister);
+    compiler.releaseRegistersDownTo(mark);
+}
+
+} // End of namespace Sysmel
@@ -0,0 +1,301 @@
+#include "Bytecode.hpp"
+#include "Semantics.hpp"
+#include <string.h>
+#include <typeinfo>
+
+namespace Sysmel
+{
+
+// Unboxed registers hold the raw bits of a primitive number.
+typedef uint64_t UnboxedRegister;
+
+template<typename T>
+static inline T readUnboxed(const UnboxedRegister &unboxedRegister)
+{
+    T value;
+    memcpy(&value, &unboxedRegister, sizeof(T));
+    return value;
+}
+
+template<typename T>
+static inline void writeUnboxed(UnboxedRegister &unboxedRegister, T value)
+{
+    memcpy(&unboxedRegister, &value, sizeof(T));
+}
+
+// The function receives a null pointer to the primitive value class of the kind.
+template<typename FT>
+static inline void withPrimitiveNumberValueClass(uint8_t kind, const FT &function)
+{
+    switch(PrimitiveNumberKind(kind))
+    {
+#define PrimitiveIntegerKindName(name) case PrimitiveNumberKind::name: function((Primitive##name##Value*)nullptr); break;
+#define PrimitiveFloatKindName(name) case PrimitiveNumberKind::name: function((Primitive##name##Value*)nullptr); break;
+#include "PrimitiveNumberKind.inc"
+#undef PrimitiveIntegerKindName
+#undef PrimitiveFloatKindName
+    }
+}
+
+template<typename FT>
+static inline void withPrimitiveIntegerValueClass(uint8_t kind, const FT &function)
+{
+    switch(PrimitiveNumberKind(kind))
+    {
+#define PrimitiveIntegerKindName(name) case PrimitiveNumberKind::name: function((Primitive##name##Value*)nullptr); break;
+#define PrimitiveFloatKindName(name)
+#include "PrimitiveNumberKind.inc"
+#undef PrimitiveIntegerKindName
+#undef PrimitiveFloatKindName
+    default: abort();
+    }
+}
+
+#define PrimitiveValueTypeOf(valueClass) typename std::remove_pointer<decltype(valueClass)>::type::ValueType
+
+#define UnboxedUnaryOperationCase(opcodeName, dispatcher, expression) \
+    case BytecodeOpcode::opcodeName: \
+        dispatcher(instruction.count, [&](auto valueClass) { \
+            typedef PrimitiveValueTypeOf(valueClass) T; \
+            auto operand = readUnboxed<T> (unboxedRegisters[instruction.b]); \
+            writeUnboxed<T> (unboxedRegisters[instruction.a], T(expression)); \
+        }); \
+        break;
+
+#define UnboxedBinaryOperationCase(opcodeName, dispatcher, expression) \
+    case BytecodeOpcode::opcodeName: \
+        dispatcher(instruction.count, [&](auto valueClass) { \
+            typedef PrimitiveValueTypeOf(valueClass) T; \
+            auto left = readUnboxed<T> (unboxedRegisters[instruction.b]); \
+            auto right = readUnboxed<T> (unboxedRegisters[instruction.c]); \
+            writeUnboxed<T> (unboxedRegisters[instruction.a], T(expression)); \
+        }); \
+        break;
+
+#define UnboxedComparisonCase(opcodeName, expression) \
+    case BytecodeOpcode::opcodeName: \
+        withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) { \
+            typedef PrimitiveValueTypeOf(valueClass) T; \
+            auto left = readUnboxed<T> (unboxedRegisters[instruction.b]); \
+            auto right = readUnboxed<T> (unboxedRegisters[instruction.c]); \
+            registers[instruction.a] = Boolean::encode(expression); \
+        }); \
+        break;
+
+ValuePtr evaluateBytecodeFunctionInEnvironment(const BytecodeFunction &function, const EnvironmentPtr &environment)
+{
+    // Small frames keep their registers in the native stack.
+    const size_t InlineRegisterCount = 16;
+    ValuePtr inlineRegisters[InlineRegisterCount];
+    std::vector<ValuePtr> heapRegisters;
+    ValuePtr *registers = inlineRegisters;
+    if(function.registerCount > InlineRegisterCount)
+    {
+        heapRegisters.resize(function.registerCount);
+        registers = heapRegisters.data();
+    }
+
+    const size_t InlineUnboxedRegisterCount = 16;
+    UnboxedRegister inlineUnboxedRegisters[InlineUnboxedRegisterCount];
+    std::vector<UnboxedRegister> heapUnboxedRegisters;
+    UnboxedRegister *unboxedRegisters = inlineUnboxedRegisters;
+    if(function.unboxedRegisterCount > InlineUnboxedRegisterCount)
+    {
+        heapUnboxedRegisters.resize(function.unboxedRegisterCount);
+        unboxedRegisters = heapUnboxedRegisters.data();
+    }
+
+    std::vector<ValuePtr> argumentValues;
+    auto instructions = function.instructions.data();
+    auto constants = function.constants.data();
+    auto inlineCaches = function.inlineCaches.data();
+    size_t pc = 0;
+
+    for(;;)
+    {
+        const auto &instruction = instructions[pc++];
+        switch(instruction.opcode)
+        {
+        case BytecodeOpcode::LoadConstant:
+            registers[instruction.a] = constants[instruction.b];
+            break;
+        case BytecodeOpcode::LoadFrameSlot:
+            registers[instruction.a] = FunctionalActivationEnvironment::frameAtDepthFrom(environment.get(), instruction.c)->slots[instruction.b];
+            break;
+        case BytecodeOpcode::StoreFrameSlot:
+            static_cast<FunctionalActivationEnvironment*> (environment.get())->slots[instruction.b] = registers[instruction.a];
+            break;
+        case BytecodeOpcode::LoadGlobal:
+            registers[instruction.a] = constants[instruction.b]->evaluateInEnvironment(environment);
+            break;
+        case BytecodeOpcode::EvaluateTree:
+            registers[instruction.a] = constants[instruction.b]->evaluateInEnvironment(environment);
+            break;
+
+        case BytecodeOpcode::Send:
+            {
+                auto receiver = registers + instruction.b;
+                argumentValues.assign(receiver, receiver + 1 + instruction.count);
+                registers[instruction.a] = inlineCaches[instruction.c].sendWithArguments(argumentValues);
+            }
+            break;
+        case BytecodeOpcode::Apply:
+            {
+                auto &functionalValue = registers[instruction.b];
+                if(functionalValue->isMacro())
+                    constants[instruction.c]->throwExceptionWithMessage("Macro methods have to evaluated during syntactic translation.");
+
+                auto firstArgument = registers + instruction.b + 1;
+                argumentValues.assign(firstArgument, firstArgument + instruction.count);
+                registers[instruction.a] = functionalValue->applyWithArguments(argumentValues);
+            }
+            break;
+        case BytecodeOpcode::TailApply:
+            {
+                auto &functionalValue = registers[instruction.b];
+                if(functionalValue->isMacro())
+                    constants[instruction.c]->throwExceptionWithMessage("Macro methods have to evaluated during syntactic translation.");
+
+                auto firstArgument = registers + instruction.b + 1;
+                if(functionalValue->isLambdaValue())
+                    return LambdaValue::requestTailCall(functionalValue, std::vector<ValuePtr> (firstArgument, firstArgument + instruction.count));
+
+                argumentValues.assign(firstArgument, firstArgument + instruction.count);
+                registers[instruction.a] = functionalValue->applyWithArguments(argumentValues);
+            }
+            break;
+
+        case BytecodeOpcode::Alloca:
+            {
+                auto &alloca = static_cast<SemanticAlloca&> (*constants[instruction.c]);
+                auto box = makeRef<MutableValueBox> ();
+                box->valueType = alloca.valueType->evaluateInEnvironment(environment);
+                box->type = alloca.type->evaluateInEnvironment(environment);
+                if(instruction.count)
+                    box->value = registers[instruction.b];
+                alloca.storeBoxInBinding(box, environment);
+                registers[instruction.a] = box;
+            }
+            break;
+        case BytecodeOpcode::Load:
+            registers[instruction.a] = registers[instruction.b]->mutableLoadValue();
+            break;
+        case BytecodeOpcode::Store:
+            registers[instruction.b]->mutableStoreValue(registers[instruction.a]);
+            break;
+
+        case BytecodeOpcode::MakeArray:
+            {
+                auto arrayObject = makeRef<Array> ();
+                auto firstElement = registers + instruction.b;
+                arrayObject->values.assign(firstElement, firstElement + instruction.count);
+                registers[instruction.a] = arrayObject;
+            }
+            break;
+        case BytecodeOpcode::MakeTuple:
+            {
+                auto tupleObject = makeRef<ProductTypeValue> ();
+                tupleObject->type = staticRefCast<ProductType> (constants[instruction.c]);
+                auto firstElement = registers + instruction.b;
+                tupleObject->elements.assign(firstElement, firstElement + instruction.count);
+                registers[instruction.a] = tupleObject;
+            }
+            break;
+        case BytecodeOpcode::MakeByteArray:
+            {
+                auto byteArrayObject = makeRef<ByteArray> ();
+                byteArrayObject->values.reserve(instruction.count);
+                for(size_t i = 0; i < instruction.count; ++i)
+                    byteArrayObject->values.push_back(registers[instruction.b + i]->evaluateAsSingleByte());
+                registers[instruction.a] = byteArrayObject;
+            }
+            break;
+
+        case BytecodeOpcode::Jump:
+            // Backward jumps close loops.
+            if(instruction.b < pc)
+                GarbageCollector::safepoint();
+            pc = instruction.b;
+            break;
+        case BytecodeOpcode::JumpIfNotTrue:
+            if(!registers[instruction.a]->isTrue())
+                pc = instruction.b;
+            break;
+        case BytecodeOpcode::JumpIfNotFalse:
+            if(!registers[instruction.a]->isFalse())
+                pc = instruction.b;
+            break;
+        case BytecodeOpcode::Return:
+            return registers[instruction.a];
+
+        case BytecodeOpcode::UnboxConstant:
+            withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) {
+                typedef typename std::remove_pointer<decltype(valueClass)>::type ValueClass;
+                writeUnboxed(unboxedRegisters[instruction.a], static_cast<const ValueClass&> (*constants[instruction.b]).value);
+            });
+            break;
+        case BytecodeOpcode::Unbox:
+            withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) {
+                typedef typename std::remove_pointer<decltype(valueClass)>::type ValueClass;
+                writeUnboxed(unboxedRegisters[instruction.a], static_cast<const ValueClass&> (*registers[instruction.b]).value);
+            });
+            break;
+        case BytecodeOpcode::Box:
+            withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) {
+                typedef typename std::remove_pointer<decltype(valueClass)>::type ValueClass;
+                auto boxedValue = makeRef<ValueClass> ();
+                boxedValue->value = readUnboxed<typename ValueClass::ValueType> (unboxedRegisters[instruction.b]);
+                registers[instruction.a] = boxedValue;
+            });
+            break;
+        case BytecodeOpcode::LoadUnboxed:
+            withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) {
+                typedef typename std::remove_pointer<decltype(valueClass)>::type ValueClass;
+                auto &box = static_cast<MutableValueBox&> (*registers[instruction.b]);
+                writeUnboxed(unboxedRegisters[instruction.a], static_cast<const ValueClass&> (*box.value).value);
+            });
+            break;
+        case BytecodeOpcode::StoreUnboxed:
+            withPrimitiveNumberValueClass(instruction.count, [&](auto valueClass) {
+                typedef typename std::remove_pointer<decltype(valueClass)>::type ValueClass;
+                auto &box = static_cast<MutableValueBox&> (*registers[instruction.b]);
+                auto newValue = readUnboxed<typename ValueClass::ValueType> (unboxedRegisters[instruction.a]);
+
+                // Nobody else can observe a value that is only referenced by the box, so it can be updated in place.
+                if(box.value && box.value->getReferenceCount() == 1 && typeid(*box.value) == typeid(ValueClass))
+                {
+                    static_cast<ValueClass&> (*box.value).value = newValue;
+                }
+                else
+                {
+                    auto boxedValue = makeRef<ValueClass> ();
+                    boxedValue->value = newValue;
+                    box.value = boxedValue;
+                }
+            });
+            break;
+
+        UnboxedUnaryOperationCase(UnboxedNegated, withPrimitiveNumberValueClass, -operand)
+        UnboxedUnaryOperationCase(UnboxedBitInvert, withPrimitiveIntegerValueClass, ~operand)
+        UnboxedBinaryOperationCase(UnboxedAdd, withPrimitiveNumberValueClass, left + right)
+        UnboxedBinaryOperationCase(UnboxedSubtract, withPrimitiveNumberValueClass, left - right)
+        UnboxedBinaryOperationCase(UnboxedMultiply, withPrimitiveNumberValueClass, left * right)
+        UnboxedBinaryOperationCase(UnboxedDivide, withPrimitiveNumberValueClass, left / right)
+        UnboxedBinaryOperationCase(UnboxedRemainder, withPrimitiveIntegerValueClass, left % right)
+        UnboxedBinaryOperationCase(UnboxedBitAnd, withPrimitiveIntegerValueClass, left & right)
+        UnboxedBinaryOperationCase(UnboxedBitOr, withPrimitiveIntegerValueClass, left | right)
+        UnboxedBinaryOperationCase(UnboxedBitXor, withPrimitiveIntegerValueClass, left ^ right)
+        UnboxedBinaryOperationCase(UnboxedShiftLeft, withPrimitiveIntegerValueClass, left << right)
+        UnboxedBinaryOperationCase(UnboxedShiftRight, withPrimitiveIntegerValueClass, left >> right)
+
+        UnboxedComparisonCase(UnboxedEquals, left == right)
+        UnboxedComparisonCase(UnboxedNotEquals, left != right)
+        UnboxedComparisonCase(UnboxedLessThan, left < right)
+        UnboxedComparisonCase(UnboxedLessOrEquals, left <= right)
+        UnboxedComparisonCase(UnboxedGreaterThan, left > right)
+        UnboxedComparisonCase(UnboxedGreaterOrEquals, left >= right)
+        }
+    }
+}
+
+} // End of namespace Sysmel
@@ -0,0 +1,171 @@
+#include "Semantics.hpp"
+#include "Assert.hpp"
+#include <algorithm>
+
+namespace Sysmel
+{
+
+static void foldConstantsInPlace(ValuePtr &node)
+{
+    if(node)
+        node = node->foldConstants();
+}
+
+static void foldConstantsInPlace(std::vector<ValuePtr> &nodes)
+{
+    for(auto &node : nodes)
+        node = node->foldConstants();
+}
+
+static ValuePtr makeFoldedLiteral(const ValuePtr &value, const SourcePositionPtr &sourcePosition)
+{
+    auto literal = makeRef<SemanticLiteralValue> ();
+    literal->sourcePosition = sourcePosition;
+    literal->value = value;
+    return literal;
+}
+
+ValuePtr SemanticValueSequence::foldConstants()
+{
+    // Nested sequences are spliced, and the literals that are not the result have no effect.
+    std::vector<ValuePtr> foldedElements;
+    foldedElements.reserve(elements.size());
+    for(auto &element : elements)
+    {
+        auto foldedElement = element->foldConstants();
+        if(foldedElement->isSemanticValueSequence() && !staticRefCast<SemanticValueSequence> (foldedElement)->elements.empty())
+        {
+            auto &nestedElements = staticRefCast<SemanticValueSequence> (foldedElement)->elements;
+            foldedElements.insert(foldedElements.end(), nestedElements.begin(), nestedElements.end());
+        }
+        else
+        {
+            foldedElements.push_back(foldedElement);
+        }
+    }
+
+    if(!foldedElements.empty())
+    {
+        auto resultElement = foldedElements.back();
+        foldedElements.pop_back();
+        foldedElements.erase(std::remove_if(foldedElements.begin(), foldedElements.end(), [](const ValuePtr &element) {
+            return element->isSemanticLiteralValue();
+        }), foldedElements.end());
+        foldedElements.push_back(resultElement);
+    }
+
+    if(foldedElements.size() == 1)
+        return foldedElements.back();
+
+    elements.swap(foldedElements);
+    return selfRef();
+}
+
+ValuePtr SemanticApplication::foldConstants()
+{
+    foldConstantsInPlace(functional);
+    foldConstantsInPlace(arguments);
+    return selfRef();
+}
+
+ValuePtr SemanticMessageSend::foldConstants()
+{
+    foldConstantsInPlace(receiver);
+    foldConstantsInPlace(arguments);
+
+    auto pureResult = evaluatePureSendWithLiteralOperands();
+    if(pureResult)
+        return makeFoldedLiteral(pureResult, sourcePosition);
+
+    return selfRef();
+}
+
+ValuePtr SemanticArray::foldConstants()
+{
+    foldConstantsInPlace(expressions);
+    return selfRef();
+}
+
+ValuePtr SemanticTuple::foldConstants()
+{
+    foldConstantsInPlace(expressions);
+    return selfRef();
+}
+
+ValuePtr SemanticByteArray::foldConstants()
+{
+    foldConstantsInPlace(byteExpressions);
+    return selfRef();
+}
+
+ValuePtr SemanticLocalDefinition::foldConstants()
+{
+    foldConstantsInPlace(value);
+    return selfRef();
+}
+
+ValuePtr SemanticAlloca::foldConstants()
+{
+    foldConstantsInPlace(initialValueExpression);
+    return selfRef();
+}
+
+ValuePtr SemanticLoadValue::foldConstants()
+{
+    foldConstantsInPlace(pointer);
+    return selfRef();
+}
+
+ValuePtr SemanticStoreValue::foldConstants()
+{
+    foldConstantsInPlace(pointer);
+    foldConstantsInPlace(value);
+    return selfRef();
+}
+
+ValuePtr SemanticIf::foldConstants()
+{
+    foldConstantsInPlace(condition);
+    foldConstantsInPlace(trueCase);
+    foldConstantsInPlace(falseCase);
+    if(!condition->isSemanticLiteralValue())
+        return selfRef();
+
+    auto conditionValue = staticRefCast<SemanticLiteralValue> (condition)->value;
+    ValuePtr caseToEvaluate;
+    if(conditionValue->isTrue())
+        caseToEvaluate = trueCase;
+    else if(conditionValue->isFalse())
+        caseToEvaluate = falseCase;
+
+    if(returnsValue)
+    {
+        sysmelAssert(caseToEvaluate);
+        return caseToEvaluate;
+    }
+
+    // The case is only evaluated for its effect, and the if still results in void.
+    auto voidLiteral = makeFoldedLiteral(VoidValue::uniqueInstance(), sourcePosition);
+    if(!caseToEvaluate)
+        return voidLiteral;
+
+    auto sequence = makeRef<SemanticValueSequence> ();
+    sequence->sourcePosition = sourcePosition;
+    sequence->type = type;
+    sequence->elements.push_back(caseToEvaluate);
+    sequence->elements.push_back(voidLiteral);
+    return sequence->foldConstants();
+}
+
+ValuePtr SemanticWhile::foldConstants()
+{
+    foldConstantsInPlace(condition);
+    foldConstantsInPlace(body);
+    foldConstantsInPlace(continueAction);
+    if(condition->isSemanticLiteralValue() && staticRefCast<SemanticLiteralValue> (condition)->value->isFalse())
+        return makeFoldedLiteral(VoidValue::uniqueInstance(), sourcePosition);
+
+    return selfRef();
+}
+
+} // End of namespace Sysmel
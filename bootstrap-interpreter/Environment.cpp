@@ -5,38 +5,68 @@
 #include "Syntax.hpp"
 #include <math.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace Sysmel
 {
 
 ValuePtr SymbolValueBinding::analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment)
 {
-    (void)syntaxNode;
-    (void)environment;
-    return analyzedValue;
+    if(!isAlloca && !isFrameLocal)
+        return analyzedValue;
+
+    if(!isFrameLocal)
+    {
+        auto globalReference = makeRef<SemanticGlobalValueReference> ();
+        globalReference->sourcePosition = syntaxNode->getSourcePosition();
+        globalReference->type = analyzedValue->getType();
+        globalReference->binding = staticRefCast<SymbolValueBinding> (selfRef());
+        return globalReference;
+    }
+
+    auto semanticReference = makeRef<SemanticIdentifierReference> ();
+    semanticReference->sourcePosition = syntaxNode->getSourcePosition();
+    semanticReference->type = analyzedValue->getType();
+    semanticReference->identifierBinding = selfRef();
+    semanticReference->frameDepth = environment->getFrameDepth() - frameDepth;
+    semanticReference->frameSlotIndex = frameSlotIndex;
+    return semanticReference;
 }
 
 ValuePtr SymbolArgumentBinding::analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment)
 {
     (void)syntaxNode;
-    (void)environment;
-    auto semanticReference = std::make_shared<SemanticIdentifierReference> ();
+    auto semanticReference = makeRef<SemanticIdentifierReference> ();
     semanticReference->sourcePosition =  sourcePosition;
     semanticReference->type = type;
-    semanticReference->identifierBinding = shared_from_this();
+    if(type && type->isSemanticLiteralValue() && type->asTypeValue())
+        semanticReference->type = type->asTypeValue();
+    semanticReference->identifierBinding = selfRef();
+    semanticReference->frameDepth = environment->getFrameDepth() - frameDepth;
+    semanticReference->frameSlotIndex = frameSlotIndex;
     return semanticReference;
 }
 
 ValuePtr SymbolFixpointBinding::analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment)
 {
     (void)syntaxNode;
-    (void)environment;
-    auto semanticReference = std::make_shared<SemanticIdentifierReference>();
+    auto semanticReference = makeRef<SemanticIdentifierReference>();
     semanticReference->sourcePosition =  sourcePosition;
     semanticReference->type = typeExpression->analyzeInEnvironment(environment);
-    semanticReference->identifierBinding = shared_from_this();
+    semanticReference->identifierBinding = selfRef();
+    semanticReference->frameDepth = environment->getFrameDepth() - frameDepth;
+    semanticReference->frameSlotIndex = frameSlotIndex;
     return semanticReference;
 }
 
+size_t Environment::getFrameDepth()
+{
+    auto functionalAnalysisEnvironment = getFunctionalAnalysisEnvironment();
+    return functionalAnalysisEnvironment ? functionalAnalysisEnvironment->frameDepth : 0;
+}
+
 ClassPtr IntrinsicsEnvironment::lookupValidClass(const std::string &name)
 {
     auto it = intrinsicClasses.find(name);
@@ -58,17 +88,17 @@ void IntrinsicsEnvironment::addIntrinsicClass(const ClassPtr &intrinsicClass)
 
 template<typename BaseClass> std::pair<ClassPtr, MetaclassPtr> makeClassAndMetaclass(const std::string &name)
 {
-    auto meta = std::make_shared<Metaclass> ();
-    auto clazz = std::make_shared<Class> ();
+    auto meta = makeRef<Metaclass> ();
+    auto clazz = makeRef<Class> ();
     clazz->clazz = meta;
     clazz->name = name;
-    clazz->subclasses = std::make_shared<Array> ();
+    clazz->subclasses = makeRef<Array> ();
     clazz->format = sizeof(BaseClass);
     clazz->interpreterBasicNew = []() {
-        return std::make_shared<BaseClass> ();
+        return makeRef<BaseClass> ();
     };
 
-    meta->thisClass = clazz;
+    meta->thisClass = clazz.get();
 
     return std::make_pair(clazz, meta);
 }
@@ -112,7 +142,7 @@ void IntrinsicsEnvironment::buildBasicTypes()
 
 void IntrinsicsEnvironment::buildMetaHierarchy()
 {
-    parent = std::make_shared<EmptyEnvironment> ();
+    parent = makeRef<EmptyEnvironment> ();
 
     std::vector<std::pair<ClassPtr, MetaclassPtr> > intrinsicClassesAndMetaclasses{
 #define AddClass(cls) makeClassAndMetaclass<cls> (#cls),
@@ -165,6 +195,47 @@ void IntrinsicsEnvironment::buildMetaHierarchy()
     intrinsicMetaclasses["ProtoObject"]->superclass = intrinsicClasses["Class"];
 }
 
+// The small integer primitives only keep their result when it fits in a word, and use the large integers otherwise.
+static bool addSmallIntegers(int64_t left, int64_t right, int64_t &result)
+{
+#if defined(__GNUC__)
+    return !__builtin_add_overflow(left, right, &result);
+#else
+    if((right > 0 && left > INT64_MAX - right) || (right < 0 && left < INT64_MIN - right))
+        return false;
+    result = left + right;
+    return true;
+#endif
+}
+
+static bool subtractSmallIntegers(int64_t left, int64_t right, int64_t &result)
+{
+#if defined(__GNUC__)
+    return !__builtin_sub_overflow(left, right, &result);
+#else
+    if((right < 0 && left > INT64_MAX + right) || (right > 0 && left < INT64_MIN + right))
+        return false;
+    result = left - right;
+    return true;
+#endif
+}
+
+static bool multiplySmallIntegers(int64_t left, int64_t right, int64_t &result)
+{
+#if defined(__GNUC__)
+    return !__builtin_mul_overflow(left, right, &result);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    int64_t high;
+    result = _mul128(left, right, &high);
+    return high == (result >> 63);
+#else
+    if((left == -1 && right == INT64_MIN) || (right == -1 && left == INT64_MIN))
+        return false;
+    result = int64_t(uint64_t(left)*uint64_t(right));
+    return left == 0 || result / left == right;
+#endif
+}
+
 void IntrinsicsEnvironment::buildObjectPrimitives()
 {
     // ProtoObject
@@ -178,17 +249,15 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
         SimpleFunctionType::make(lookupValidClass("ProtoObject"), "self", lookupValidClass("ProtoObject")),
         [](const std::vector<ValuePtr> &arguments){
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<ProtoObject> (arguments[0]);
+            auto self = staticRefCast<ProtoObject> (arguments[0]);
             return self->clazz;
         });
     addPrimitiveToClass("ProtoObject", "identityHash",
         SimpleFunctionType::make(lookupValidClass("ProtoObject"), "self", lookupValidClass("Integer")),
         [](const std::vector<ValuePtr> &arguments){
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<ProtoObject> (arguments[0]);
-            auto result = std::make_shared<Integer> ();
-            result->value = LargeInteger(self->identityHash);
-            return result;
+            auto self = staticRefCast<ProtoObject> (arguments[0]);
+            return Integer::make(LargeInteger(uint64_t(self->identityHash)));
         });
 
     // Behavior
@@ -201,10 +270,12 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 3);
-            auto behavior = std::static_pointer_cast<Behavior> (arguments[0]);
-            auto selector = arguments[1];
-            auto method = arguments[0];
-            behavior->methodDict.insert(std::make_pair(selector->asAnalyzedSymbolValue(), method));
+            auto behavior = staticRefCast<Behavior> (arguments[0]);
+            auto selector = arguments[1]->asAnalyzedSymbolValue();
+            if(!selector)
+                arguments[1]->throwExceptionWithMessage("Expected a symbol as a method selector.");
+            auto method = arguments[2];
+            behavior->addMethodWithSelector(selector, method);
             return behavior;
         });
     addPrimitiveToClass("Behavior", "basicNew",
@@ -214,7 +285,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Behavior> (arguments[0]);
+            auto self = staticRefCast<Behavior> (arguments[0]);
             return self->basicNew();
         });
     addPrimitiveToClass("Behavior", "new",
@@ -224,7 +295,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Behavior> (arguments[0]);
+            auto self = staticRefCast<Behavior> (arguments[0]);
             auto basicNew = self->basicNew();
             std::vector<ValuePtr> initializeArgs;
             return basicNew->performWithArguments(Symbol::internString("initialize"), initializeArgs);
@@ -236,7 +307,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto behavior = std::static_pointer_cast<Behavior> (arguments[0]);
+            auto behavior = staticRefCast<Behavior> (arguments[0]);
             return behavior->superclass;
         });
 
@@ -248,7 +319,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto clazz = std::static_pointer_cast<Class> (arguments[0]);
+            auto clazz = staticRefCast<Class> (arguments[0]);
             return clazz->subclasses;
         });
 
@@ -260,7 +331,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
         [](const std::vector<ValuePtr> &arguments){
             sysmelAssert(arguments.size() == 1);
             auto string = arguments[0]->printString();
-            auto stringObject = std::make_shared<String> ();
+            auto stringObject = makeRef<String> ();
             stringObject->value = string;
             return stringObject;
         });
@@ -302,11 +373,9 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
             lookupValidClass("Integer")),
         [](const std::vector<ValuePtr> &arguments){
             sysmelAssert(arguments.size() == 1);
-            auto collection = std::static_pointer_cast<Collection> (arguments[0]);
+            auto collection = staticRefCast<Collection> (arguments[0]);
             auto size = collection->getSize();
-            auto sizeInteger = std::make_shared<Integer> ();
-            sizeInteger->value = LargeInteger(size);
-            return sizeInteger;
+            return Integer::make(int64_t(size));
         });
 
     // Integer
@@ -324,113 +393,137 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
 
     addPrimitiveToClass("Integer", "negated", integerUnaryArithmeticType, [](const std::vector<ValuePtr> &arguments){
         sysmelAssert(arguments.size() == 1);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
+        auto left = staticRefCast<Integer> (arguments[0]);
 
-        auto result = std::make_shared<Integer> ();
-        result->value = -left->value;
-        return result;
-    });
+        int64_t result;
+        if(left->isSmallInteger && subtractSmallIntegers(0, left->smallValue, result))
+            return Integer::make(result);
+        return Integer::make(-left->asLargeInteger());
+    })->isPure = true;
     addPrimitiveToClass("Integer", "+", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments){
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-
-        auto result = std::make_shared<Integer> ();
-        result->value = left->value + right->value;
-        return result;
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+
+        int64_t result;
+        if(left->isSmallInteger && right->isSmallInteger && addSmallIntegers(left->smallValue, right->smallValue, result))
+            return Integer::make(result);
+        return Integer::make(left->asLargeInteger() + right->asLargeInteger());
+    })->isPure = true;
     addPrimitiveToClass("Integer", "-", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments){
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-
-        auto result = std::make_shared<Integer> ();
-        result->value = left->value - right->value;
-        return result;
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+
+        int64_t result;
+        if(left->isSmallInteger && right->isSmallInteger && subtractSmallIntegers(left->smallValue, right->smallValue, result))
+            return Integer::make(result);
+        return Integer::make(left->asLargeInteger() - right->asLargeInteger());
+    })->isPure = true;
     addPrimitiveToClass("Integer", "*", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-
-        auto result = std::make_shared<Integer> ();
-        result->value = left->value * right->value;
-        return result;
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+
+        int64_t result;
+        if(left->isSmallInteger && right->isSmallInteger && multiplySmallIntegers(left->smallValue, right->smallValue, result))
+            return Integer::make(result);
+        return Integer::make(left->asLargeInteger() * right->asLargeInteger());
+    })->isPure = true;
     addPrimitiveToClass("Integer", "//", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
 
-        auto result = std::make_shared<Integer> ();
-        result->value = left->value / right->value;
-        return result;
+        if(left->isSmallInteger && right->isSmallInteger && right->smallValue != 0 &&
+            !(left->smallValue == INT64_MIN && right->smallValue == -1))
+            return Integer::make(left->smallValue / right->smallValue);
+        return Integer::make(left->asLargeInteger() / right->asLargeInteger());
     });
     addPrimitiveToClass("Integer", "\\\\", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
 
-        auto result = std::make_shared<Integer> ();
-        result->value = left->value % right->value;
-        return result;
+        if(left->isSmallInteger && right->isSmallInteger && right->smallValue != 0 &&
+            !(left->smallValue == INT64_MIN && right->smallValue == -1))
+            return Integer::make(left->smallValue % right->smallValue);
+        return Integer::make(left->asLargeInteger() % right->asLargeInteger());
     });
-    addPrimitiveToClass("Integer", "=", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
+    addPrimitiveToClass("Integer", "gcd:", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
+        sysmelAssert(arguments.size() == 2);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Integer::make(LargeInteger::gcd(left->asLargeInteger(), right->asLargeInteger()));
+    })->isPure = true;
+    addPrimitiveToClass("Integer", "lcm:", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value == right->value);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Integer::make(LargeInteger::lcm(left->asLargeInteger(), right->asLargeInteger()));
+    })->isPure = true;
+    addPrimitiveToClass("Integer", "modularInverse:", integerBinaryArithmeticType, [](const std::vector<ValuePtr> &arguments) {
+        sysmelAssert(arguments.size() == 2);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Integer::make(left->asLargeInteger().modularInverse(right->asLargeInteger()));
     });
+    addPrimitiveToClass("Integer", "=", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
+        sysmelAssert(arguments.size() == 2);
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) == 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", "~=", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value != right->value);
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) != 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", "<", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value < right->value);
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) < 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", "<=", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value <= right->value);
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) <= 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", ">", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value > right->value);
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) > 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", ">=", integerBinaryComparisonType, [](const std::vector<ValuePtr> &arguments) {
         sysmelAssert(arguments.size() == 2);
-        auto left = std::static_pointer_cast<Integer> (arguments[0]);
-        auto right = std::static_pointer_cast<Integer> (arguments[1]);
-        return Boolean::encode(left->value >= right->value);
-    });
+        auto left = staticRefCast<Integer> (arguments[0]);
+        auto right = staticRefCast<Integer> (arguments[1]);
+        return Boolean::encode(left->compareWith(*right) >= 0);
+    })->isPure = true;
     addPrimitiveToClass("Integer", "asInteger", 
         SimpleFunctionType::make(
             lookupValidClass("Integer"), "self",
             lookupValidClass("Integer")),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Integer> (arguments[0]);
+            auto self = staticRefCast<Integer> (arguments[0]);
             return self;
-        });
+        })->isPure = true;
     addPrimitiveToClass("Integer", "asFloat", 
         SimpleFunctionType::make(
                 lookupValidClass("Integer"), "self",
                 lookupValidClass("Float")),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Integer> (arguments[0]);
-            auto floatObject = std::make_shared<Float> ();
-            floatObject->value = self->value.asDouble();
+            auto self = staticRefCast<Integer> (arguments[0]);
+            auto floatObject = makeRef<Float> ();
+            floatObject->value = self->asDouble();
             return floatObject;
-        });
+        })->isPure = true;
 
 
     // Stream
@@ -441,7 +534,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
                 lookupValidClass("Stream")),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 2);
-            auto stream = std::static_pointer_cast<Stream> (arguments[0]);
+            auto stream = staticRefCast<Stream> (arguments[0]);
             stream->nextPut(arguments[1]);
             return stream;
         });
@@ -452,7 +545,7 @@ void IntrinsicsEnvironment::buildObjectPrimitives()
                 lookupValidClass("Stream")),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 2);
-            auto stream = std::static_pointer_cast<Stream> (arguments[0]);
+            auto stream = staticRefCast<Stream> (arguments[0]);
             stream->nextPutAll(arguments[1]);
             return stream;
         });
@@ -494,129 +587,136 @@ void buildPrimitiveNumberTypeMethods(IntrinsicsEnvironment *environment,
         SimpleFunctionType::make(integerType, "self", primitiveType),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Integer> (arguments[0]);
-            auto primitive = std::make_shared<PrimitiveNumberValueClass> ();
-            primitive->value = typename PrimitiveNumberValueClass::ValueType(self->value);
+            auto self = staticRefCast<Integer> (arguments[0]);
+            auto primitive = makeRef<PrimitiveNumberValueClass> ();
+            primitive->value = self->castTo<typename PrimitiveNumberValueClass::ValueType> ();
             return primitive;
-        });
+        })->isPure = true;
 
     environment->addPrimitiveToClass("Integer", conversionMethodName,
         SimpleFunctionType::make(integerType, "self", primitiveType),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Integer> (arguments[0]);
-            auto primitive = std::make_shared<PrimitiveNumberValueClass> ();
-            primitive->value = typename PrimitiveNumberValueClass::ValueType(self->value);
+            auto self = staticRefCast<Integer> (arguments[0]);
+            auto primitive = makeRef<PrimitiveNumberValueClass> ();
+            primitive->value = self->castTo<typename PrimitiveNumberValueClass::ValueType> ();
             return primitive;
-        });
+        })->isPure = true;
 
     environment->addPrimitiveToClass("Float", literalSuffix,
         SimpleFunctionType::make(floatType, "self", primitiveType),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Float> (arguments[0]);
-            auto primitive = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self = staticRefCast<Float> (arguments[0]);
+            auto primitive = makeRef<PrimitiveNumberValueClass> ();
             primitive->value = typename PrimitiveNumberValueClass::ValueType(self->value);
             return primitive;
-        });
+        })->isPure = true;
 
     environment->addPrimitiveToClass("Float", conversionMethodName,
         SimpleFunctionType::make(floatType, "self",primitiveType),
         [](const std::vector<ValuePtr> &arguments) {
             sysmelAssert(arguments.size() == 1);
-            auto self = std::static_pointer_cast<Float> (arguments[0]);
-            auto primitive = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self = staticRefCast<Float> (arguments[0]);
+            auto primitive = makeRef<PrimitiveNumberValueClass> ();
             primitive->value = typename PrimitiveNumberValueClass::ValueType(self->value);
             return primitive;
-        });
+        })->isPure = true;
 
     auto unaryArithmethicType = SimpleFunctionType::make(primitiveType, "self", primitiveType);
     auto binaryArithmethicType = SimpleFunctionType::make(primitiveType, "self", primitiveType, "other", primitiveType);
     auto binaryComparisonType = SimpleFunctionType::make(primitiveType, "self", primitiveType, "other", environment->lookupValidClass("Boolean"));
+    environment->addPrimitiveToType(primitiveType, "printString", SimpleFunctionType::make(primitiveType, "self", environment->lookupValidClass("String")),
+        [](const std::vector<ValuePtr> &arguments) {
+            sysmelAssert(arguments.size() == 1);
+            auto stringObject = makeRef<String> ();
+            stringObject->value = arguments[0]->printString();
+            return stringObject;
+        });
     environment->addPrimitiveToType(primitiveType, "negated", unaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = -self->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "+", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value + other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "-", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value - other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "*", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value * other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "/", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value / other->value;
             return result;
         });
     environment->addPrimitiveToType(primitiveType, "//", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value / other->value;
             return result;
         });
 
     environment->addPrimitiveToType(primitiveType, "=", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value == other->value);
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "~=", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value != other->value);
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "<", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value < other->value);
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "<=", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value <= other->value);
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, ">", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value > other->value);
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, ">=", binaryComparisonType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
             return Boolean::encode(self->value >= other->value);
-        });
+        })->isPure = true;
 }
 
 template<typename PrimitiveNumberTypeClass, typename PrimitiveNumberValueClass>
@@ -631,57 +731,57 @@ void buildPrimitiveIntegerTypeMethods(IntrinsicsEnvironment *environment,
 
     environment->addPrimitiveToType(primitiveType, "bitInvert", unaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = ~self->value;
             return result;
-        });
+        })->isPure = true;
 
     environment->addPrimitiveToType(primitiveType, "%", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value % other->value;
             return result;
         });
     environment->addPrimitiveToType(primitiveType, "|", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value | other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "&", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
-            result->value = self->value | other->value;
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
+            result->value = self->value & other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "^", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value ^ other->value;
             return result;
-        });
+        })->isPure = true;
     environment->addPrimitiveToType(primitiveType, "<<", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value << other->value;
             return result;
         });
     environment->addPrimitiveToType(primitiveType, ">>", binaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto other = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[1]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto other = staticRefCast<PrimitiveNumberValueClass> (arguments[1]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = self->value >> other->value;
             return result;
         });
@@ -697,11 +797,11 @@ void buildPrimitiveFloatTypeMethods(IntrinsicsEnvironment *environment,
     auto unaryArithmethicType = SimpleFunctionType::make(primitiveType, "self", primitiveType);
     environment->addPrimitiveToType(primitiveType, "sqrt", unaryArithmethicType,
         [](const std::vector<ValuePtr> &arguments) {
-            auto self  = std::static_pointer_cast<PrimitiveNumberValueClass> (arguments[0]);
-            auto result = std::make_shared<PrimitiveNumberValueClass> ();
+            auto self  = staticRefCast<PrimitiveNumberValueClass> (arguments[0]);
+            auto result = makeRef<PrimitiveNumberValueClass> ();
             result->value = sqrt(self->value);
             return result;
-        });
+        })->isPure = true;
 }
 
 
@@ -735,7 +835,7 @@ void IntrinsicsEnvironment::buildBasicMacros()
             lookupValidClass("SyntacticValue"), "trueCase",
             lookupValidClass("SyntacticValue")),
         [](const MacroContextPtr &context, const std::vector<ValuePtr> &arguments){
-            auto syntaxIf = std::make_shared<SyntaxIf> ();
+            auto syntaxIf = makeRef<SyntaxIf> ();
             syntaxIf->sourcePosition = context->sourcePosition;
             syntaxIf->condition = arguments[0];
             syntaxIf->trueCase = arguments[1];
@@ -749,7 +849,7 @@ void IntrinsicsEnvironment::buildBasicMacros()
             lookupValidClass("SyntacticValue"), "falseCase",
             lookupValidClass("SyntacticValue")),
         [](const MacroContextPtr &context, const std::vector<ValuePtr> &arguments){
-            auto syntaxIf = std::make_shared<SyntaxIf> ();
+            auto syntaxIf = makeRef<SyntaxIf> ();
             syntaxIf->sourcePosition = context->sourcePosition;
             syntaxIf->condition = arguments[0];
             syntaxIf->trueCase = arguments[1];
@@ -764,7 +864,7 @@ void IntrinsicsEnvironment::buildBasicMacros()
             lookupValidClass("SyntacticValue"), "body",
             lookupValidClass("SyntacticValue")),
         [](const MacroContextPtr &context, const std::vector<ValuePtr> &arguments){
-            auto syntaxWhile = std::make_shared<SyntaxWhile> ();
+            auto syntaxWhile = makeRef<SyntaxWhile> ();
             syntaxWhile->sourcePosition = context->sourcePosition;
             syntaxWhile->condition = arguments[0];
             syntaxWhile->body = arguments[1];
@@ -778,7 +878,7 @@ void IntrinsicsEnvironment::buildBasicMacros()
             lookupValidClass("SyntacticValue"), "continueAction",
             lookupValidClass("SyntacticValue")),
         [](const MacroContextPtr &context, const std::vector<ValuePtr> &arguments){
-            auto syntaxWhile = std::make_shared<SyntaxWhile> ();
+            auto syntaxWhile = makeRef<SyntaxWhile> ();
             syntaxWhile->sourcePosition = context->sourcePosition;
             syntaxWhile->condition = arguments[0];
             syntaxWhile->body = arguments[1];
@@ -787,29 +887,32 @@ void IntrinsicsEnvironment::buildBasicMacros()
         });
 }
 
-void IntrinsicsEnvironment::addPrimitiveToType(const TypeBehaviorPtr &behavior, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
+PrimitiveMethodPtr IntrinsicsEnvironment::addPrimitiveToType(const TypeBehaviorPtr &behavior, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
 {
-    auto primitive = std::make_shared<PrimitiveMethod> (functionalType, impl);
-    behavior->methodDict[Symbol::internString(selector)] = primitive;
+    auto primitive = makeRef<PrimitiveMethod> (functionalType, impl);
+    behavior->addMethodWithSelector(Symbol::internString(selector), primitive);
+    return primitive;
 }
 
-void IntrinsicsEnvironment::addPrimitiveToClass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
+PrimitiveMethodPtr IntrinsicsEnvironment::addPrimitiveToClass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
 {
-    auto primitive = std::make_shared<PrimitiveMethod> (functionalType, impl);
+    auto primitive = makeRef<PrimitiveMethod> (functionalType, impl);
     auto &clazz = intrinsicClasses[className];
-    clazz->methodDict[Symbol::internString(selector)] = primitive;
+    clazz->addMethodWithSelector(Symbol::internString(selector), primitive);
+    return primitive;
 }
 
-void IntrinsicsEnvironment::addPrimitiveToMetaclass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
+PrimitiveMethodPtr IntrinsicsEnvironment::addPrimitiveToMetaclass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature impl)
 {
-    auto primitive = std::make_shared<PrimitiveMethod> (functionalType, impl);
+    auto primitive = makeRef<PrimitiveMethod> (functionalType, impl);
     auto &clazz = intrinsicMetaclasses[className];
-    clazz->methodDict[Symbol::internString(selector)] = primitive;
+    clazz->addMethodWithSelector(Symbol::internString(selector), primitive);
+    return primitive;
 }
 
 void IntrinsicsEnvironment::addPrimitiveGlobalMacro(const std::string &name, ValuePtr functionalType, PrimitiveMacroImplementationSignature impl)
 {
-    auto primitiveMacro = std::make_shared<PrimitiveMacroMethod> (functionalType, impl);
+    auto primitiveMacro = makeRef<PrimitiveMacroMethod> (functionalType, impl);
     addLocalSymbolBinding(Symbol::internString(name), primitiveMacro);
 }
 
@@ -817,7 +920,7 @@ IntrinsicsEnvironmentPtr IntrinsicsEnvironment::uniqueInstance()
 {
     if(!singleton)
     {
-        singleton = std::make_shared<IntrinsicsEnvironment> ();
+        singleton = makeRef<IntrinsicsEnvironment> ();
         singleton->buildIntrinsicsState();
     }
     return singleton;
@@ -8,18 +8,17 @@
 
 namespace Sysmel
 {
-    typedef std::shared_ptr<Environment> EnvironmentPtr;
-    typedef std::shared_ptr<class IntrinsicsEnvironment> IntrinsicsEnvironmentPtr;
-    typedef std::shared_ptr<class LexicalEnvironment> LexicalEnvironmentPtr;
-    typedef std::shared_ptr<class FunctionalAnalysisEnvironment> FunctionalAnalysisEnvironmentPtr;
-    typedef std::shared_ptr<class FunctionalActivationEnvironment> FunctionalActivationEnvironmentPtr;
-    typedef std::shared_ptr<class Module> ModulePtr;
-    typedef std::shared_ptr<class Namespace> NamespacePtr;
-    typedef std::shared_ptr<class SymbolValueBinding> SymbolValueBindingPtr;
-    typedef std::shared_ptr<class SymbolCaptureBinding> SymbolCaptureBindingPtr;
-    typedef std::shared_ptr<class SymbolArgumentBinding> SymbolArgumentBindingPtr;
-    typedef std::shared_ptr<class SymbolFixpointBinding> SymbolFixpointBindingPtr;
-    typedef std::shared_ptr<class TypeBehavior> TypeBehaviorPtr;
+    typedef Ref<Environment> EnvironmentPtr;
+    typedef Ref<class IntrinsicsEnvironment> IntrinsicsEnvironmentPtr;
+    typedef Ref<class LexicalEnvironment> LexicalEnvironmentPtr;
+    typedef Ref<class FunctionalAnalysisEnvironment> FunctionalAnalysisEnvironmentPtr;
+    typedef Ref<class FunctionalActivationEnvironment> FunctionalActivationEnvironmentPtr;
+    typedef Ref<class Module> ModulePtr;
+    typedef Ref<class Namespace> NamespacePtr;
+    typedef Ref<class SymbolValueBinding> SymbolValueBindingPtr;
+    typedef Ref<class SymbolArgumentBinding> SymbolArgumentBindingPtr;
+    typedef Ref<class SymbolFixpointBinding> SymbolFixpointBindingPtr;
+    typedef Ref<class TypeBehavior> TypeBehaviorPtr;
 
     class SymbolValueBinding : public Value
     {
@@ -27,6 +26,18 @@ namespace Sysmel
         SymbolPtr name;
         ValuePtr analyzedValue;
         bool isAlloca = false;
+        bool isFrameLocal = false;
+        size_t frameDepth = 0;
+        size_t frameSlotIndex = 0;
+        ValuePtr globalValue;
+
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            Value::visitSlots(visitor);
+            visitor.visit(name);
+            visitor.visit(analyzedValue);
+            visitor.visit(globalValue);
+        }
 
         virtual ValuePtr analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment);
     };
@@ -38,6 +49,15 @@ namespace Sysmel
         ValuePtr type;
         bool isImplicit = false;
         bool isExistential = false;
+        size_t frameDepth = 0;
+        size_t frameSlotIndex = 0;
+
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            Value::visitSlots(visitor);
+            visitor.visit(name);
+            visitor.visit(type);
+        }
 
         virtual ValuePtr getType() const override
         {
@@ -63,6 +83,15 @@ namespace Sysmel
     public:
         SymbolPtr name;
         ValuePtr typeExpression;
+        size_t frameDepth = 0;
+        size_t frameSlotIndex = 0;
+
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            Value::visitSlots(visitor);
+            visitor.visit(name);
+            visitor.visit(typeExpression);
+        }
 
         virtual void printStringOn(std::ostream &out) const override
         {
@@ -107,11 +136,7 @@ namespace Sysmel
             return parent->getFunctionalActivationEnvironment();
         }
 
-        virtual ValuePtr lookupValueForBinding(ValuePtr binding)
-        {
-            auto parent = getParent();
-            return parent->lookupValueForBinding(binding);
-        }
+        size_t getFrameDepth();
 
         virtual ValuePtr lookupSymbolRecursively(SymbolPtr symbol)
         {
@@ -144,12 +169,6 @@ namespace Sysmel
             return nullptr;
         }
 
-        virtual ValuePtr lookupValueForBinding(ValuePtr binding) override
-        {
-            (void)binding;
-            return nullptr;
-        }
-
         virtual NamespacePtr getNamespace() const
         {
             auto parent = getParent();
@@ -201,6 +220,13 @@ namespace Sysmel
             symbolTable.insert(std::make_pair(symbol, binding));
         }
 
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            Environment::visitSlots(visitor);
+            visitor.visit(parent);
+            visitor.visit(symbolTable);
+        }
+
         EnvironmentPtr parent;
         std::map<SymbolPtr, ValuePtr> symbolTable;
     };
@@ -214,9 +240,9 @@ namespace Sysmel
         MetaclassPtr lookupValidMetaclass(const std::string &s);
         void addIntrinsicClass(const ClassPtr &intrinsicClass);
 
-        void addPrimitiveToType(const TypeBehaviorPtr &behavior, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
-        void addPrimitiveToClass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
-        void addPrimitiveToMetaclass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
+        PrimitiveMethodPtr addPrimitiveToType(const TypeBehaviorPtr &behavior, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
+        PrimitiveMethodPtr addPrimitiveToClass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
+        PrimitiveMethodPtr addPrimitiveToMetaclass(const std::string &className, const std::string &selector, ValuePtr functionalType, PrimitiveImplementationSignature);
         void addPrimitiveGlobalMacro(const std::string &name, ValuePtr functionalType, PrimitiveMacroImplementationSignature);
 
     private:
@@ -246,6 +272,12 @@ namespace Sysmel
             return module;
         }
 
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            NonEmptyEnvironment::visitSlots(visitor);
+            visitor.visit(module);
+        }
+
         ModulePtr module;
     };
 
@@ -263,6 +295,12 @@ namespace Sysmel
             return namespce;
         }
 
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            NonEmptyEnvironment::visitSlots(visitor);
+            visitor.visit(namespce);
+        }
+
         NamespacePtr namespce;
     };
 
@@ -275,6 +313,12 @@ namespace Sysmel
             sourcePosition = csourcePosition;
         }
 
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            NonEmptyEnvironment::visitSlots(visitor);
+            visitor.visit(sourcePosition);
+        }
+
         SourcePositionPtr sourcePosition;
     };
 
@@ -313,11 +357,12 @@ namespace Sysmel
         {
             parent = cparent;
             sourcePosition = csourcePosition;
+            frameDepth = cparent->getFrameDepth() + 1;
         }
 
         virtual FunctionalAnalysisEnvironmentPtr getFunctionalAnalysisEnvironment() override
         {
-            return std::static_pointer_cast<FunctionalAnalysisEnvironment>(shared_from_this());
+            return staticRefCast<FunctionalAnalysisEnvironment>(selfRef());
         }
 
         void addArgumentBinding(const SymbolArgumentBindingPtr &analyzedArgument)
@@ -325,6 +370,8 @@ namespace Sysmel
             auto name = analyzedArgument->name;
             if (name)
                 addLocalSymbolBinding(name, analyzedArgument);
+            analyzedArgument->frameDepth = frameDepth;
+            analyzedArgument->frameSlotIndex = allocateFrameSlot();
             argumentBindings.push_back(analyzedArgument);
         }
 
@@ -333,18 +380,40 @@ namespace Sysmel
             sysmelAssert(!this->fixpointBinding);
             if (fixpointBinding->name)
                 addLocalSymbolBinding(fixpointBinding->name, fixpointBinding);
+            fixpointBinding->frameDepth = frameDepth;
+            fixpointBinding->frameSlotIndex = allocateFrameSlot();
             this->fixpointBinding = fixpointBinding;
         }
 
+        size_t allocateFrameSlot()
+        {
+            return frameSize++;
+        }
+
+        size_t frameDepth = 0;
+        size_t frameSize = 0;
+        virtual void visitSlots(SlotVisitor &visitor) override
+        {
+            NonEmptyEnvironment::visitSlots(visitor);
+            visitor.visit(sourcePosition);
+            visitor.visit(fixpointBinding);
+            visitor.visit(argumentBindings);
+        }
+
         SourcePositionPtr sourcePosition;
         SymbolFixpointBindingPtr fixpointBinding;
         std::vector<ValuePtr> argumentBindings;
     };
 
+    /**
+     * I am the activation frame of a function call. Arguments, the fixpoint and local bindings live in
+     * slots resolved during analysis, and my parent is the frame of the enclosing function.
+     */
     class FunctionalActivationEnvironment : public NonEmptyEnvironment
     {
     public:
-        FunctionalActivationEnvironment(const EnvironmentPtr &cparent, const SourcePositionPtr &csourcePosition)
+        FunctionalActivationEnvironment(const EnvironmentPtr &cparent, const SourcePositionPtr &csourcePosition, size_t frameSize)
+            : slots(frameSize)
         {
             parent = cparent;
             sourcePosition = csourcePosition;
@@ -352,35 +421,26 @@ namespace Sysmel
 
         virtual FunctionalActivationEnvironmentPtr getFunctionalActivationEnvironment() override
         {
-            return std::static_pointer_cast<FunctionalActivationEnvironment>(shared_from_this());
-        }
-
-        void forArgumentBindingSetValue(const SymbolArgumentBindingPtr &binding, ValuePtr value)
-        {
-            argumentBindings.insert(std::make_pair(binding, value));
+            return staticRefCast<FunctionalActivationEnvironment>(selfRef());
         }
 
-        void setFixpointBindingValue(const SymbolFixpointBindingPtr &newFixpointBinding, const ValuePtr &bindingValue)
+        static FunctionalActivationEnvironment *frameAtDepthFrom(Environment *environment, size_t depth)
         {
-            fixpointBinding = newFixpointBinding;
-            fixpointBindingValue = bindingValue;
+            auto frame = static_cast<FunctionalActivationEnvironment*> (environment);
+            for (size_t i = 0; i < depth; ++i)
+                frame = static_cast<FunctionalActivationEnvironment*> (frame->parent.get());
+            return frame;
         }
 
-        virtual ValuePtr lookupValueForBinding(ValuePtr binding) override
+        virtual void visitSlots(SlotVisitor &visitor) override
         {
-            if (binding && binding == fixpointBinding)
-                return fixpointBindingValue;
-
-            auto it = argumentBindings.find(std::static_pointer_cast<SymbolArgumentBinding>(binding));
-            if (it != argumentBindings.end())
-                return it->second;
-            return nullptr;
+            NonEmptyEnvironment::visitSlots(visitor);
+            visitor.visit(sourcePosition);
+            visitor.visit(slots);
         }
 
-        SymbolFixpointBindingPtr fixpointBinding;
-        ValuePtr fixpointBindingValue;
         SourcePositionPtr sourcePosition;
-        std::map<SymbolArgumentBindingPtr, ValuePtr> argumentBindings;
+        std::vector<ValuePtr> slots;
     };
 }
 #endif // SYSMEL_ENVIRONMENT_HPP
\ No newline at end of file
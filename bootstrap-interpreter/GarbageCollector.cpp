@@ -0,0 +1,295 @@
+#include "GarbageCollector.hpp"
+#include "Value.hpp"
+#include "Assert.hpp"
+#include <stdlib.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+
+namespace Sysmel
+{
+
+thread_local GarbageCollector::ValueList GarbageCollector::nursery;
+GarbageCollector::ValueList GarbageCollector::oldGeneration;
+size_t GarbageCollector::oldGenerationSizeAfterMajorCollection;
+thread_local GarbageCollectorStatistics GarbageCollector::statistics;
+
+// Small values are bump allocated from chunks, and their cells are recycled through a free list per size class.
+struct FreeCell
+{
+    FreeCell *next;
+};
+
+static constexpr size_t AllocationGranularity = 16;
+static constexpr size_t MaximumSmallAllocationSize = 512;
+static constexpr size_t SizeClassCount = MaximumSmallAllocationSize / AllocationGranularity + 1;
+static constexpr size_t ChunkSize = 256*1024;
+
+static thread_local FreeCell *freeCellLists[SizeClassCount];
+static thread_local uint8_t *bumpPointer;
+static thread_local uint8_t *bumpLimit;
+
+void GarbageCollectorStatistics::printOn(FILE *out) const
+{
+    fprintf(out, "Garbage collector minor collections: %" PRIu64 "\n", minorCollections);
+    fprintf(out, "Garbage collector major collections: %" PRIu64 "\n", majorCollections);
+    fprintf(out, "Garbage collector collected values: %" PRIu64 "\n", collectedValues);
+    fprintf(out, "Garbage collector promoted values: %" PRIu64 "\n", promotedValues);
+    fprintf(out, "Garbage collector total pause: %.3f ms\n", totalPauseTime*1000.0);
+    fprintf(out, "Garbage collector max pause: %.3f ms\n", maxPauseTime*1000.0);
+    fprintf(out, "Heap size: %zu bytes\n", heapSize);
+    fprintf(out, "Heap peak size: %zu bytes\n", peakHeapSize);
+    fprintf(out, "Heap reserved size: %zu bytes\n", reservedHeapSize);
+}
+
+void SlotVisitor::visitValue(Value *value)
+{
+    if(value->gcState == Value::GCState::None)
+        return;
+
+    switch(mode)
+    {
+    case Mode::SubtractInternalReferences:
+        sysmelAssert(value->gcCount > 0);
+        --value->gcCount;
+        break;
+    case Mode::MarkReachable:
+        if(value->gcState == Value::GCState::Candidate)
+        {
+            value->gcState = Value::GCState::Reachable;
+            markingStack->push_back(value);
+        }
+        break;
+    case Mode::Clear:
+        break;
+    }
+}
+
+void GarbageCollector::ValueList::add(Value *value)
+{
+    if(size == capacity)
+    {
+        capacity = std::max(capacity*2, size_t(1024));
+        elements = reinterpret_cast<Value**> (realloc(elements, capacity*sizeof(Value*)));
+        sysmelAssert(elements);
+    }
+
+    value->gcIndex = uint32_t(size);
+    elements[size++] = value;
+}
+
+void GarbageCollector::ValueList::remove(Value *value)
+{
+    auto index = value->gcIndex;
+    sysmelAssert(index < size && elements[index] == value);
+
+    auto last = elements[--size];
+    elements[index] = last;
+    last->gcIndex = index;
+}
+
+void *GarbageCollector::allocate(size_t size)
+{
+    auto allocationSize = (size + AllocationGranularity - 1) & (~(AllocationGranularity - 1));
+    statistics.heapSize += allocationSize;
+    statistics.peakHeapSize = std::max(statistics.peakHeapSize, statistics.heapSize);
+
+    if(allocationSize > MaximumSmallAllocationSize)
+    {
+        statistics.reservedHeapSize += allocationSize;
+        auto result = malloc(allocationSize);
+        sysmelAssert(result);
+        return result;
+    }
+
+    auto &freeList = freeCellLists[allocationSize / AllocationGranularity];
+    if(freeList)
+    {
+        auto cell = freeList;
+        freeList = cell->next;
+        return cell;
+    }
+
+    if(size_t(bumpLimit - bumpPointer) < allocationSize)
+    {
+        // The tail of the previous chunk is too small for this size class, so it is left unused.
+        bumpPointer = reinterpret_cast<uint8_t*> (malloc(ChunkSize));
+        sysmelAssert(bumpPointer);
+        bumpLimit = bumpPointer + ChunkSize;
+        statistics.reservedHeapSize += ChunkSize;
+    }
+
+    auto result = bumpPointer;
+    bumpPointer += allocationSize;
+    return result;
+}
+
+void GarbageCollector::deallocate(void *pointer, size_t size)
+{
+    auto allocationSize = (size + AllocationGranularity - 1) & (~(AllocationGranularity - 1));
+    statistics.heapSize -= allocationSize;
+
+    if(allocationSize > MaximumSmallAllocationSize)
+    {
+        statistics.reservedHeapSize -= allocationSize;
+        free(pointer);
+        return;
+    }
+
+    auto cell = reinterpret_cast<FreeCell*> (pointer);
+    auto &freeList = freeCellLists[allocationSize / AllocationGranularity];
+    cell->next = freeList;
+    freeList = cell;
+}
+
+void GarbageCollector::registerValue(Value *value)
+{
+    value->gcGeneration = Value::GCGeneration::Nursery;
+    nursery.add(value);
+}
+
+void GarbageCollector::unregisterValue(Value *value)
+{
+    if(value->gcGeneration == Value::GCGeneration::Nursery)
+        nursery.remove(value);
+    else
+        oldGeneration.remove(value);
+}
+
+void GarbageCollector::promoteNursery()
+{
+    for(size_t i = 0; i < nursery.size; ++i)
+    {
+        auto value = nursery.elements[i];
+        value->gcGeneration = Value::GCGeneration::Old;
+        oldGeneration.add(value);
+    }
+
+    nursery.size = 0;
+}
+
+void GarbageCollector::collectNursery()
+{
+    collect(false);
+    if(oldGeneration.size >= std::max(MinimumOldGenerationSizeForMajorCollection, oldGenerationSizeAfterMajorCollection*2))
+        collect(true);
+}
+
+void GarbageCollector::collectAllGenerations()
+{
+    collect(true);
+}
+
+void GarbageCollector::collect(bool includeOldGeneration)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    if(includeOldGeneration)
+        promoteNursery();
+
+    auto &candidates = includeOldGeneration ? oldGeneration : nursery;
+    for(size_t i = 0; i < candidates.size; ++i)
+    {
+        auto value = candidates.elements[i];
+        value->gcState = Value::GCState::Candidate;
+        value->gcCount = value->referenceCount;
+    }
+
+    // The references that are left come from outside of the candidates.
+    SlotVisitor subtractVisitor(SlotVisitor::Mode::SubtractInternalReferences);
+    for(size_t i = 0; i < candidates.size; ++i)
+        candidates.elements[i]->visitSlots(subtractVisitor);
+
+    // Values without any reference are still being constructed, so they are also roots.
+    std::vector<Value*> markingStack;
+    for(size_t i = 0; i < candidates.size; ++i)
+    {
+        auto value = candidates.elements[i];
+        if(value->gcCount > 0 || value->referenceCount == 0)
+        {
+            value->gcState = Value::GCState::Reachable;
+            markingStack.push_back(value);
+        }
+    }
+
+    SlotVisitor markingVisitor(SlotVisitor::Mode::MarkReachable, &markingStack);
+    while(!markingStack.empty())
+    {
+        auto value = markingStack.back();
+        markingStack.pop_back();
+        value->visitSlots(markingVisitor);
+    }
+
+    std::vector<Value*> garbage;
+    for(size_t i = 0; i < candidates.size; ++i)
+    {
+        auto value = candidates.elements[i];
+        if(value->gcState == Value::GCState::Candidate)
+            garbage.push_back(value);
+        value->gcState = Value::GCState::None;
+    }
+
+    if(!includeOldGeneration)
+    {
+        statistics.promotedValues += nursery.size - garbage.size();
+        promoteNursery();
+    }
+
+    // Break the cycles by clearing the slots of the garbage. The extra reference keeps
+    // every garbage value alive until all of them are cleared.
+    for(auto value : garbage)
+        value->retainReference();
+    SlotVisitor clearingVisitor(SlotVisitor::Mode::Clear);
+    for(auto value : garbage)
+        value->visitSlots(clearingVisitor);
+    for(auto value : garbage)
+        value->releaseReference();
+
+    statistics.collectedValues += garbage.size();
+    if(includeOldGeneration)
+    {
+        ++statistics.majorCollections;
+        oldGenerationSizeAfterMajorCollection = oldGeneration.size;
+    }
+    else
+    {
+        ++statistics.minorCollections;
+    }
+
+    auto pauseTime = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+    statistics.totalPauseTime += pauseTime;
+    statistics.maxPauseTime = std::max(statistics.maxPauseTime, pauseTime);
+}
+
+GarbageCollector::ThreadValues GarbageCollector::detachThreadValues()
+{
+    ThreadValues threadValues;
+    std::swap(threadValues.values, nursery);
+    threadValues.heapSize = statistics.heapSize;
+    threadValues.reservedHeapSize = statistics.reservedHeapSize;
+    threadValues.allocatedInstanceCount = Value::allocatedInstanceCount;
+    statistics.heapSize = 0;
+    statistics.reservedHeapSize = 0;
+    Value::allocatedInstanceCount = 0;
+    return threadValues;
+}
+
+void GarbageCollector::adoptThreadValues(ThreadValues &threadValues)
+{
+    auto &values = threadValues.values;
+    for(size_t i = 0; i < values.size; ++i)
+        nursery.add(values.elements[i]);
+    free(values.elements);
+
+    statistics.heapSize += threadValues.heapSize;
+    statistics.peakHeapSize = std::max(statistics.peakHeapSize, statistics.heapSize);
+    statistics.reservedHeapSize += threadValues.reservedHeapSize;
+    Value::allocatedInstanceCount += threadValues.allocatedInstanceCount;
+    threadValues = ThreadValues();
+}
+
+GarbageCollectorStatistics &GarbageCollector::getStatistics()
+{
+    return statistics;
+}
+
+} // End of namespace Sysmel
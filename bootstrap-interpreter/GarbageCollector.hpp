@@ -0,0 +1,191 @@
+#ifndef SYSMEL_GARBAGE_COLLECTOR_HPP
+#define SYSMEL_GARBAGE_COLLECTOR_HPP
+
+#pragma once
+
+#include "Ref.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Sysmel
+{
+
+class Value;
+
+/**
+ * Counters that describe the behavior of the garbage collector and the size of the heap.
+ */
+struct GarbageCollectorStatistics
+{
+    uint64_t minorCollections = 0;
+    uint64_t majorCollections = 0;
+    uint64_t collectedValues = 0;
+    uint64_t promotedValues = 0;
+    double totalPauseTime = 0;
+    double maxPauseTime = 0;
+
+    size_t heapSize = 0;
+    size_t peakHeapSize = 0;
+    size_t reservedHeapSize = 0;
+
+    void printOn(FILE *out) const;
+};
+
+/**
+ * I visit the reference slots of a value on behalf of the garbage collector.
+ * Values only report the slots that hold a counted reference, so that I can
+ * tell apart the references that come from inside of the heap.
+ */
+class SlotVisitor
+{
+public:
+    enum class Mode : uint8_t
+    {
+        SubtractInternalReferences,
+        MarkReachable,
+        Clear,
+    };
+
+    SlotVisitor(Mode initialMode, std::vector<Value*> *initialMarkingStack = nullptr)
+        : mode(initialMode), markingStack(initialMarkingStack) {}
+
+    template<typename T>
+    void visit(Ref<T> &slot)
+    {
+        if(!slot)
+            return;
+
+        if(mode == Mode::Clear)
+            slot.reset();
+        else
+            visitValue(slot.get());
+    }
+
+    template<typename T>
+    void visit(std::vector<Ref<T>> &slots)
+    {
+        if(mode == Mode::Clear)
+            return slots.clear();
+
+        for(auto &slot : slots)
+            visit(slot);
+    }
+
+    template<typename K, typename V>
+    void visit(std::map<K, V> &slots)
+    {
+        if(mode == Mode::Clear)
+            return slots.clear();
+
+        for(auto &entry : slots)
+        {
+            visitKey(entry.first);
+            visit(entry.second);
+        }
+    }
+
+private:
+    template<typename T>
+    void visitKey(const Ref<T> &key)
+    {
+        visitValue(key.get());
+    }
+
+    void visitKey(const std::string &)
+    {
+    }
+
+    void visitValue(Value *value);
+
+    Mode mode;
+    std::vector<Value*> *markingStack;
+};
+
+/**
+ * I am a generational cycle collector for values. Values are reclaimed by
+ * their reference count as soon as they are dropped, and I find the cycles
+ * that reference counting cannot reclaim. I trace a generation through the
+ * value slots and subtract the references that come from inside of it; the
+ * values that still have references left are held from outside, such as
+ * from the C++ stack, and they are the roots from where the survivors are marked.
+ *
+ * New values are bump allocated into chunks that are shared by every size class,
+ * and they belong to the nursery until they survive a collection. Values cannot
+ * be moved, so survivors are promoted in place into the old generation.
+ *
+ * The reference counts are not atomic, so a value is only used by a single thread
+ * at a time. Other threads may create values, as long as they hand them over with
+ * detachThreadValues() and adoptThreadValues() before they are shared.
+ */
+class GarbageCollector
+{
+public:
+    static constexpr size_t NurseryCollectionThreshold = 8192;
+    static constexpr size_t MinimumOldGenerationSizeForMajorCollection = 16384;
+
+    static void *allocate(size_t size);
+    static void deallocate(void *pointer, size_t size);
+
+    static void registerValue(Value *value);
+    static void unregisterValue(Value *value);
+
+    // Collections only happen on safepoints, where every live value is held by a counted reference.
+    static void safepoint()
+    {
+        if(nursery.size >= NurseryCollectionThreshold)
+            collectNursery();
+    }
+
+    static void collectNursery();
+    static void collectAllGenerations();
+
+    static GarbageCollectorStatistics &getStatistics();
+
+private:
+    friend class SlotVisitor;
+
+    struct ValueList
+    {
+        Value **elements = nullptr;
+        size_t size = 0;
+        size_t capacity = 0;
+
+        void add(Value *value);
+        void remove(Value *value);
+    };
+
+public:
+    /**
+     * The values that a thread without collections has created, such as a parser
+     * worker. They are handed over to the thread that evaluates them, which adopts
+     * them into its nursery.
+     */
+    struct ThreadValues
+    {
+        ValueList values;
+        size_t heapSize = 0;
+        size_t reservedHeapSize = 0;
+        size_t allocatedInstanceCount = 0;
+    };
+
+    static ThreadValues detachThreadValues();
+    static void adoptThreadValues(ThreadValues &threadValues);
+
+private:
+
+    static void collect(bool includeOldGeneration);
+    static void promoteNursery();
+
+    // Each thread allocates and registers its values on its own, and only the main thread collects them.
+    static thread_local ValueList nursery;
+    static ValueList oldGeneration;
+    static size_t oldGenerationSizeAfterMajorCollection;
+    static thread_local GarbageCollectorStatistics statistics;
+};
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_GARBAGE_COLLECTOR_HPP
@@ -0,0 +1,89 @@
+#include "InlineCache.hpp"
+#include <inttypes.h>
+
+namespace Sysmel
+{
+
+// Any change in a method dictionary advances this epoch, which stales every call site.
+static uint32_t currentMethodDictionaryEpoch = 1;
+static InlineCacheStatistics inlineCacheStatistics;
+
+void InlineCacheStatistics::printOn(FILE *out) const
+{
+    fprintf(out, "Inline cache hits: %" PRIu64 "\n", hits);
+    fprintf(out, "Inline cache misses: %" PRIu64 "\n", misses);
+    fprintf(out, "Inline cache megamorphic sends: %" PRIu64 "\n", megamorphicSends);
+    fprintf(out, "Inline cache invalidations: %" PRIu64 "\n", invalidations);
+}
+
+void InlineCache::invalidateAll()
+{
+    ++currentMethodDictionaryEpoch;
+    ++inlineCacheStatistics.invalidations;
+}
+
+InlineCacheStatistics &InlineCache::getStatistics()
+{
+    return inlineCacheStatistics;
+}
+
+void InlineCache::flush()
+{
+    for(uint32_t i = 0; i < entryCount; ++i)
+        entries[i] = Entry{};
+    entryCount = 0;
+    isMegamorphic = false;
+    epoch = currentMethodDictionaryEpoch;
+}
+
+ValuePtr InlineCache::sendWithArguments(const ValuePtr &sentSelector, const std::vector<ValuePtr> &receiverAndArguments)
+{
+    auto &receiver = receiverAndArguments[0];
+    auto behavior = receiver->getClass();
+    if(!behavior)
+    {
+        behavior = receiver->getType();
+        if(!behavior)
+            receiver->throwExceptionWithMessage("Cannot send a message to something without a type or a class.");
+    }
+
+    if(epoch != currentMethodDictionaryEpoch || sentSelector != selector)
+    {
+        flush();
+        selector = sentSelector;
+    }
+
+    for(uint32_t i = 0; i < entryCount; ++i)
+    {
+        if(entries[i].behavior == behavior)
+        {
+            ++inlineCacheStatistics.hits;
+            return entries[i].method->applyWithArguments(receiverAndArguments);
+        }
+    }
+
+    auto method = behavior->lookupSelector(selector);
+    if(!method)
+    {
+        // Let the behavior report the failure, or handle the message on its own.
+        std::vector<ValuePtr> arguments(receiverAndArguments.begin() + 1, receiverAndArguments.end());
+        return behavior->performWithArgumentsOnInstance(receiver, selector, arguments);
+    }
+
+    if(isMegamorphic)
+    {
+        ++inlineCacheStatistics.megamorphicSends;
+    }
+    else
+    {
+        ++inlineCacheStatistics.misses;
+        if(entryCount < PolymorphicEntryCount)
+            entries[entryCount++] = Entry{behavior, method};
+        else
+            isMegamorphic = true;
+    }
+
+    return method->applyWithArguments(receiverAndArguments);
+}
+
+} // End of namespace Sysmel
@@ -0,0 +1,68 @@
+#ifndef SYSMEL_INLINE_CACHE_HPP
+#define SYSMEL_INLINE_CACHE_HPP
+
+#pragma once
+
+#include "Value.hpp"
+#include <stdint.h>
+#include <stdio.h>
+
+namespace Sysmel
+{
+
+/**
+ * Counters that describe the behavior of the message send inline caches.
+ */
+struct InlineCacheStatistics
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t megamorphicSends = 0;
+    uint64_t invalidations = 0;
+
+    void printOn(FILE *out) const;
+};
+
+/**
+ * I am a message send call site cache. I remember the methods found for the last few receiver classes or types.
+ * Once more behaviors than my entries are seen, I become megamorphic and I always perform the full lookup.
+ */
+class InlineCache
+{
+public:
+    static constexpr size_t PolymorphicEntryCount = 4;
+
+    InlineCache() = default;
+    explicit InlineCache(const ValuePtr &initialSelector)
+        : selector(initialSelector) {}
+
+    // The first element of receiverAndArguments is the receiver.
+    ValuePtr sendWithArguments(const ValuePtr &sentSelector, const std::vector<ValuePtr> &receiverAndArguments);
+    ValuePtr sendWithArguments(const std::vector<ValuePtr> &receiverAndArguments)
+    {
+        return sendWithArguments(selector, receiverAndArguments);
+    }
+
+    ValuePtr selector;
+
+    static void invalidateAll();
+    static InlineCacheStatistics &getStatistics();
+
+private:
+    struct Entry
+    {
+        ValuePtr behavior;
+        ValuePtr method;
+    };
+
+    void flush();
+
+    Entry entries[PolymorphicEntryCount];
+    uint32_t entryCount = 0;
+    uint32_t epoch = 0;
+    bool isMegamorphic = false;
+};
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_INLINE_CACHE_HPP
@@ -3,16 +3,33 @@
 #include <algorithm>
 #include <sstream>
 #include <exception>
+#include <inttypes.h>
+
+// The double word intermediates hold a full word product, or a sum with its carry. They are native
+// on the compilers with a 128-bit integer, and they are done with intrinsics on MSVC for x64.
+#if defined(__SIZEOF_INT128__)
+#define SYSMEL_LARGE_INTEGER_USE_INT128
+#elif defined(_MSC_VER) && _MSC_VER >= 1920 && defined(_M_X64)
+#define SYSMEL_LARGE_INTEGER_USE_X64_INTRINSICS
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace Sysmel
 {
 
-static uint32_t highBitOf(uint32_t word)
+typedef LargeInteger::Word Word;
+
+static uint32_t highBitOf(Word word)
 {
-#if defined(_MSC_VER)
-    return 32 - __lzcnt(word);
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return uint32_t(index + 1);
 #elif defined(__GNUC__)
-    return 32 - __builtin_clz(word);
+    return uint32_t(64 - __builtin_clzll(word));
 #else
     uint32_t result = 0;
     while(word > 0)
@@ -25,7 +42,153 @@ static uint32_t highBitOf(uint32_t word)
 #endif
 }
 
-static bool isAllZeroWords(const uint32_t words[], size_t wordCount)
+#if defined(SYSMEL_LARGE_INTEGER_USE_INT128)
+typedef unsigned __int128 DoubleWord;
+
+// I return the carry out of left + right + carry, and I store the low word of the sum in the result.
+static Word addWordsWithCarry(Word left, Word right, Word carry, Word &result)
+{
+    DoubleWord sum = DoubleWord(left) + right + carry;
+    result = Word(sum);
+    return Word(sum >> 64);
+}
+
+// I return the borrow out of left - right - borrow, and I store the low word of the difference in the result.
+static Word subtractWordsWithBorrow(Word left, Word right, Word borrow, Word &result)
+{
+    DoubleWord difference = DoubleWord(left) - right - borrow;
+    result = Word(difference);
+    return Word(difference >> 127);
+}
+
+// I return the low word of left*right + addend + secondAddend, which always fits in two words, and I store its high word.
+static Word multiplyAndAddWords(Word left, Word right, Word addend, Word secondAddend, Word &high)
+{
+    DoubleWord result = DoubleWord(left)*right + addend + secondAddend;
+    high = Word(result >> 64);
+    return Word(result);
+}
+
+// I divide high:low by the divisor, which must be above high so that the quotient fits in a word.
+static Word divideDoubleWordByWord(Word high, Word low, Word divisor, Word &remainder)
+{
+    auto dividend = (DoubleWord(high) << 64) | low;
+    remainder = Word(dividend % divisor);
+    return Word(dividend / divisor);
+}
+#elif defined(SYSMEL_LARGE_INTEGER_USE_X64_INTRINSICS)
+static Word addWordsWithCarry(Word left, Word right, Word carry, Word &result)
+{
+    unsigned long long sum;
+    auto carryOut = _addcarry_u64((unsigned char)carry, left, right, &sum);
+    result = sum;
+    return carryOut;
+}
+
+static Word subtractWordsWithBorrow(Word left, Word right, Word borrow, Word &result)
+{
+    unsigned long long difference;
+    auto borrowOut = _subborrow_u64((unsigned char)borrow, left, right, &difference);
+    result = difference;
+    return borrowOut;
+}
+
+static Word multiplyAndAddWords(Word left, Word right, Word addend, Word secondAddend, Word &high)
+{
+    unsigned long long productHigh;
+    unsigned long long low = _umul128(left, right, &productHigh);
+    productHigh += _addcarry_u64(0, low, addend, &low);
+    productHigh += _addcarry_u64(0, low, secondAddend, &low);
+    high = productHigh;
+    return low;
+}
+
+static Word divideDoubleWordByWord(Word high, Word low, Word divisor, Word &remainder)
+{
+    unsigned long long wordRemainder;
+    auto quotient = _udiv128(high, low, divisor, &wordRemainder);
+    remainder = wordRemainder;
+    return quotient;
+}
+#else
+static Word addWordsWithCarry(Word left, Word right, Word carry, Word &result)
+{
+    auto sum = left + right;
+    Word carryOut = sum < left ? 1 : 0;
+    result = sum + carry;
+    return carryOut + (result < sum ? 1 : 0);
+}
+
+static Word subtractWordsWithBorrow(Word left, Word right, Word borrow, Word &result)
+{
+    auto difference = left - right;
+    Word borrowOut = left < right ? 1 : 0;
+    result = difference - borrow;
+    return borrowOut + (difference < borrow ? 1 : 0);
+}
+
+static Word multiplyAndAddWords(Word left, Word right, Word addend, Word secondAddend, Word &high)
+{
+    // The product is added up from the products of the half words.
+    static constexpr Word HalfWordMask = 0xFFFFFFFF;
+    auto leftLow = left & HalfWordMask;
+    auto leftHigh = left >> 32;
+    auto rightLow = right & HalfWordMask;
+    auto rightHigh = right >> 32;
+
+    auto lowProduct = leftLow*rightLow;
+    auto firstMiddleProduct = leftLow*rightHigh;
+    auto secondMiddleProduct = leftHigh*rightLow;
+    auto middle = (lowProduct >> 32) + (firstMiddleProduct & HalfWordMask) + (secondMiddleProduct & HalfWordMask);
+
+    Word low = (middle << 32) | (lowProduct & HalfWordMask);
+    high = leftHigh*rightHigh + (firstMiddleProduct >> 32) + (secondMiddleProduct >> 32) + (middle >> 32);
+    high += addWordsWithCarry(low, addend, 0, low);
+    high += addWordsWithCarry(low, secondAddend, 0, low);
+    return low;
+}
+
+static Word divideDoubleWordByWord(Word high, Word low, Word divisor, Word &remainder)
+{
+    // The divisor is normalized, and the quotient is found in two half words as in Knuth's algorithm D.
+    static constexpr Word HalfWordBase = Word(1) << 32;
+    static constexpr Word HalfWordMask = 0xFFFFFFFF;
+    auto shift = LargeInteger::WordBits - highBitOf(divisor);
+    divisor <<= shift;
+    auto divisorHigh = divisor >> 32;
+    auto divisorLow = divisor & HalfWordMask;
+    auto dividendHigh = shift == 0 ? high : (high << shift) | (low >> (LargeInteger::WordBits - shift));
+    auto dividendLow = low << shift;
+    auto dividendLowHigh = dividendLow >> 32;
+    auto dividendLowLow = dividendLow & HalfWordMask;
+
+    auto quotientHigh = dividendHigh / divisorHigh;
+    auto partialRemainder = dividendHigh - quotientHigh*divisorHigh;
+    while(quotientHigh >= HalfWordBase || quotientHigh*divisorLow > ((partialRemainder << 32) | dividendLowHigh))
+    {
+        --quotientHigh;
+        partialRemainder += divisorHigh;
+        if(partialRemainder >= HalfWordBase)
+            break;
+    }
+
+    auto middle = ((dividendHigh << 32) | dividendLowHigh) - quotientHigh*divisor;
+    auto quotientLow = middle / divisorHigh;
+    partialRemainder = middle - quotientLow*divisorHigh;
+    while(quotientLow >= HalfWordBase || quotientLow*divisorLow > ((partialRemainder << 32) | dividendLowLow))
+    {
+        --quotientLow;
+        partialRemainder += divisorHigh;
+        if(partialRemainder >= HalfWordBase)
+            break;
+    }
+
+    remainder = (((middle << 32) | dividendLowLow) - quotientLow*divisor) >> shift;
+    return (quotientHigh << 32) | quotientLow;
+}
+#endif
+
+static bool isAllZeroWords(const Word words[], size_t wordCount)
 {
     for(size_t i = 0; i < wordCount; ++i )
     {
@@ -35,7 +198,7 @@ static bool isAllZeroWords(const uint32_t words[], size_t wordCount)
 
     return true;
 }
-static size_t computeSignificantWordCount(const uint32_t words[], size_t wordCount)
+static size_t computeSignificantWordCount(const Word words[], size_t wordCount)
 {
     while(wordCount > 0)
     {
@@ -70,165 +233,723 @@ static int32_t compareMagnitudes(const LargeInteger &left, const LargeInteger &r
     return 0;
 }
 
-static void sumMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
+static Word addWordsInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
 {
-    auto resultWordCount = std::max(left.words.size(), right.words.size());
-    result.words.clear();
-    result.words.reserve(resultWordCount + 1);
+    sysmelAssert(leftSize >= rightSize);
+    Word carry = 0;
+    for(size_t i = 0; i < rightSize; ++i)
+    {
+        carry = addWordsWithCarry(left[i], right[i], carry, result[i]);
+    }
 
-    uint32_t carry = 0;
-    for(size_t i = 0; i < resultWordCount; ++i)
+    for(size_t i = rightSize; i < leftSize; ++i)
     {
-        uint64_t leftWord = left.wordAt(i);
-        uint64_t rightWord = right.wordAt(i);
-        uint64_t sum = leftWord + rightWord + carry;
-        result.words.push_back(static_cast<uint32_t> (sum & 0xFFFFFFFF));
-        carry = static_cast<uint32_t> (sum >> 32);
+        carry = addWordsWithCarry(left[i], 0, carry, result[i]);
     }
 
-    if(carry != 0)
-        result.words.push_back(carry);
+    return carry;
 }
 
-static void subtractMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
+static Word addWordsInPlace(Word *accumulator, size_t accumulatorSize, const Word *operand, size_t operandSize)
 {
-    auto resultWordCount = std::max(left.words.size(), right.words.size());
-    result.words.clear();
-    result.words.reserve(resultWordCount);
+    sysmelAssert(accumulatorSize >= operandSize);
+    Word carry = 0;
+    for(size_t i = 0; i < operandSize; ++i)
+    {
+        carry = addWordsWithCarry(accumulator[i], operand[i], carry, accumulator[i]);
+    }
 
-    int32_t borrow = 0;
-    for(size_t i = 0; i < resultWordCount; ++i)
+    // Keep propagating the carry beyond.
+    for(size_t i = operandSize; carry != 0 && i < accumulatorSize; ++i)
     {
-        uint64_t leftWord = left.wordAt(i);
-        uint64_t rightWord = right.wordAt(i);
-        int64_t subtraction = leftWord - rightWord + borrow;
-        result.words.push_back(static_cast<uint32_t> (subtraction & 0xFFFFFFFF));
-        borrow = static_cast<int32_t> (subtraction >> 32);
+        carry = addWordsWithCarry(accumulator[i], 0, carry, accumulator[i]);
     }
+
+    return carry;
 }
 
-static void accumulateOffsetTimesWordInto(const LargeInteger &left, size_t offset, uint32_t rightWord, LargeInteger &accumulator)
+static Word subtractWordsInPlace(Word *accumulator, size_t accumulatorSize, const Word *operand, size_t operandSize)
 {
-    uint32_t carry = 0;
-    for(size_t i = 0; i < left.words.size(); ++i)
+    sysmelAssert(accumulatorSize >= operandSize);
+    Word borrow = 0;
+    for(size_t i = 0; i < operandSize; ++i)
     {
-        uint64_t leftWord = left.words[i];
-        auto &accumulatorWord = accumulator.words[i + offset];
-        uint64_t sum = leftWord*rightWord + accumulatorWord + carry;
-        accumulatorWord = static_cast<uint32_t> (sum & 0xFFFFFFFF);
-        carry = static_cast<uint32_t> (sum >> 32);
+        borrow = subtractWordsWithBorrow(accumulator[i], operand[i], borrow, accumulator[i]);
     }
 
-    // Keep propagating the carry beyond.
-    for(size_t i = offset + left.words.size(); i < accumulator.words.size(); ++i)
+    for(size_t i = operandSize; borrow != 0 && i < accumulatorSize; ++i)
+    {
+        borrow = subtractWordsWithBorrow(accumulator[i], 0, borrow, accumulator[i]);
+    }
+
+    return borrow;
+}
+
+// I compute operand - accumulator into the accumulator, which has as many words as the operand.
+static Word subtractWordsFromInPlace(Word *accumulator, const Word *operand, size_t size)
+{
+    Word borrow = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        borrow = subtractWordsWithBorrow(operand[i], accumulator[i], borrow, accumulator[i]);
+    }
+
+    return borrow;
+}
+
+// The destination can be the source, and I return the bits that are shifted out of the top word.
+static Word shiftWordsLeftInto(const Word *source, size_t size, uint32_t shiftAmount, Word *destination)
+{
+    if(shiftAmount == 0)
+    {
+        std::copy_backward(source, source + size, destination + size);
+        return 0;
+    }
+
+    auto shiftedOut = source[size - 1] >> (LargeInteger::WordBits - shiftAmount);
+    for(size_t i = size - 1; i > 0; --i)
+        destination[i] = (source[i] << shiftAmount) | (source[i - 1] >> (LargeInteger::WordBits - shiftAmount));
+    destination[0] = source[0] << shiftAmount;
+    return shiftedOut;
+}
+
+static void shiftWordsRightInPlace(Word *words, size_t size, uint32_t shiftAmount)
+{
+    if(shiftAmount == 0)
+        return;
+
+    for(size_t i = 0; i + 1 < size; ++i)
+        words[i] = (words[i] >> shiftAmount) | (words[i + 1] << (LargeInteger::WordBits - shiftAmount));
+    words[size - 1] >>= shiftAmount;
+}
+
+// I add a magnitude with the given sign into an accumulator, reusing its words.
+static void addSignedMagnitudeInPlace(LargeInteger &accumulator, const LargeInteger &operand, bool operandSignBit)
+{
+    if(operand.isZero())
+        return;
+
+    auto operandSize = operand.words.size();
+    if(accumulator.isZero())
+    {
+        accumulator.words.assign(operand.words.begin(), operand.words.end());
+        accumulator.signBit = operandSignBit;
+        return;
+    }
+
+    if(accumulator.signBit == operandSignBit)
     {
-        auto &accumulatorWord = accumulator.words[i];
-        uint64_t sum = uint64_t(accumulatorWord) + carry;
-        accumulatorWord = static_cast<uint32_t> (sum & 0xFFFFFFFF);
-        carry = static_cast<uint32_t> (sum >> 32);
+        if(accumulator.words.size() < operandSize)
+            accumulator.words.resize(operandSize);
+        auto carry = addWordsInPlace(accumulator.words.data(), accumulator.words.size(), operand.words.data(), operandSize);
+        if(carry != 0)
+            accumulator.words.push_back(carry);
+        return;
     }
+
+    if(compareMagnitudes(accumulator, operand) >= 0)
+    {
+        subtractWordsInPlace(accumulator.words.data(), accumulator.words.size(), operand.words.data(), operandSize);
+    }
+    else
+    {
+        accumulator.words.resize(operandSize);
+        subtractWordsFromInPlace(accumulator.words.data(), operand.words.data(), operandSize);
+        accumulator.signBit = operandSignBit;
+    }
+
+    accumulator.normalize();
 }
 
-static void multiplyAndAddBySingleWordInPlace(LargeInteger &leftAndResult, uint32_t rightWord, uint32_t startCarry)
+static void sumMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
 {
-    uint32_t carry = startCarry;
+    auto &longer = left.words.size() >= right.words.size() ? left : right;
+    auto &shorter = left.words.size() >= right.words.size() ? right : left;
+    result.words.resize(longer.words.size() + 1);
+    result.words.back() = addWordsInto(longer.words.data(), longer.words.size(), shorter.words.data(), shorter.words.size(), result.words.data());
+}
+
+static void subtractMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
+{
+    sysmelAssert(left.words.size() >= right.words.size());
+    result.words = left.words;
+    auto borrow = subtractWordsInPlace(result.words.data(), result.words.size(), right.words.data(), right.words.size());
+    sysmelAssert(borrow == 0);
+}
+
+static void multiplyAndAddBySingleWordInPlace(LargeInteger &leftAndResult, Word rightWord, Word startCarry)
+{
+    Word carry = startCarry;
     for(size_t i = 0; i < leftAndResult.words.size(); ++i)
     {
         auto &resultWord = leftAndResult.words[i];
-        uint64_t sum = uint64_t(resultWord)*rightWord + carry;
-        resultWord = static_cast<uint32_t> (sum & 0xFFFFFFFF);
-        carry = static_cast<uint32_t> (sum >> 32);
+        resultWord = multiplyAndAddWords(resultWord, rightWord, carry, 0, carry);
     }
 
     if(carry > 0)
         leftAndResult.words.push_back(carry);
 }
 
-static void multiplyMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
+// Operand sizes in words from where the divide and conquer multiplications pay off.
+static constexpr size_t KaratsubaMultiplicationThreshold = 32;
+static constexpr size_t KaratsubaSquaringThreshold = 48;
+static constexpr size_t Toom3MultiplicationThreshold = 256;
+static constexpr size_t Toom3SquaringThreshold = 384;
+
+static void multiplyWordsInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result);
+static void squareWordsInto(const Word *operand, size_t size, Word *result);
+
+static void multiplyWordsSchoolbookInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
 {
-    auto resultWordCount = left.words.size() + right.words.size();
-    result.words.clear();
-    result.words.resize(resultWordCount);
+    std::fill(result, result + leftSize + rightSize, 0);
+    for(size_t j = 0; j < rightSize; ++j)
+    {
+        Word rightWord = right[j];
+        Word carry = 0;
+        for(size_t i = 0; i < leftSize; ++i)
+        {
+            result[i + j] = multiplyAndAddWords(left[i], rightWord, result[i + j], carry, carry);
+        }
+
+        result[j + leftSize] = carry;
+    }
+}
 
-    for(size_t i = 0; i < right.words.size(); ++i)
+static void squareWordsSchoolbookInto(const Word *operand, size_t size, Word *result)
+{
+    // The cross products are computed once, doubled, and then the squares of the diagonal are added.
+    std::fill(result, result + size*2, 0);
+    for(size_t i = 0; i < size; ++i)
     {
-        accumulateOffsetTimesWordInto(left, i, right.words[i], result);
+        Word word = operand[i];
+        Word carry = 0;
+        for(size_t j = i + 1; j < size; ++j)
+        {
+            result[i + j] = multiplyAndAddWords(word, operand[j], result[i + j], carry, carry);
+        }
+
+        result[i + size] = carry;
     }
+
+    Word shiftedOutBit = 0;
+    for(size_t i = 0; i < size*2; ++i)
+    {
+        auto word = result[i];
+        result[i] = (word << 1) | shiftedOutBit;
+        shiftedOutBit = word >> 63;
+    }
+
+    Word carry = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        Word squareHigh;
+        auto squareLow = multiplyAndAddWords(operand[i], operand[i], 0, 0, squareHigh);
+        auto lowCarry = addWordsWithCarry(result[i*2], squareLow, carry, result[i*2]);
+        carry = addWordsWithCarry(result[i*2 + 1], squareHigh, lowCarry, result[i*2 + 1]);
+    }
+    sysmelAssert(carry == 0);
 }
 
-static LargeInteger timeFactorWithOffset(const LargeInteger &operand, uint32_t wordFactor, size_t offset)
+static void multiplyWordsUnbalancedInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
 {
-    LargeInteger result;
-    result.words.resize(operand.words.size() + offset + 1);
+    // The larger operand is multiplied in slices of the size of the smaller one, so that each product is balanced.
+    auto resultSize = leftSize + rightSize;
+    std::fill(result, result + resultSize, 0);
 
-    uint32_t carry = 0;
-    for(size_t i = 0; i < operand.words.size(); ++i)
+    std::vector<Word> sliceProduct(rightSize*2);
+    for(size_t offset = 0; offset < leftSize; offset += rightSize)
     {
-        uint64_t timesFactorWithCarry = uint64_t(operand.words[i])*wordFactor + carry;
-        result.words[i + offset] = uint32_t(timesFactorWithCarry & 0xFFFFFFFF);
-        carry = uint32_t(timesFactorWithCarry >> 32);
+        auto sliceSize = std::min(rightSize, leftSize - offset);
+        multiplyWordsInto(left + offset, sliceSize, right, rightSize, sliceProduct.data());
+        auto carry = addWordsInPlace(result + offset, resultSize - offset, sliceProduct.data(), sliceSize + rightSize);
+        sysmelAssert(carry == 0);
     }
+}
 
-    result.words.back() = carry;
-    result.normalize();
+static void multiplyWordsKaratsubaInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
+{
+    // (l1*B + l0)*(r1*B + r0) = l1*r1*B^2 + ((l0 + l1)*(r0 + r1) - l0*r0 - l1*r1)*B + l0*r0
+    auto resultSize = leftSize + rightSize;
+    auto lowSize = (leftSize + 1) / 2;
+    auto leftHighSize = leftSize - lowSize;
+    auto rightHighSize = rightSize - lowSize;
+    sysmelAssert(rightSize > lowSize);
+
+    multiplyWordsInto(left, lowSize, right, lowSize, result);
+    multiplyWordsInto(left + lowSize, leftHighSize, right + lowSize, rightHighSize, result + lowSize*2);
+
+    std::vector<Word> leftSum(lowSize + 1);
+    std::vector<Word> rightSum(lowSize + 1);
+    std::vector<Word> middle(lowSize*2 + 2);
+    leftSum[lowSize] = addWordsInto(left, lowSize, left + lowSize, leftHighSize, leftSum.data());
+    rightSum[lowSize] = addWordsInto(right, lowSize, right + lowSize, rightHighSize, rightSum.data());
+    multiplyWordsInto(leftSum.data(), leftSum.size(), rightSum.data(), rightSum.size(), middle.data());
+
+    subtractWordsInPlace(middle.data(), middle.size(), result, lowSize*2);
+    subtractWordsInPlace(middle.data(), middle.size(), result + lowSize*2, resultSize - lowSize*2);
+    auto carry = addWordsInPlace(result + lowSize, resultSize - lowSize, middle.data(), computeSignificantWordCount(middle.data(), middle.size()));
+    sysmelAssert(carry == 0);
+}
 
-    return result;
+static void squareWordsKaratsubaInto(const Word *operand, size_t size, Word *result)
+{
+    auto lowSize = (size + 1) / 2;
+    auto highSize = size - lowSize;
+
+    squareWordsInto(operand, lowSize, result);
+    squareWordsInto(operand + lowSize, highSize, result + lowSize*2);
+
+    std::vector<Word> sum(lowSize + 1);
+    std::vector<Word> middle(lowSize*2 + 2);
+    sum[lowSize] = addWordsInto(operand, lowSize, operand + lowSize, highSize, sum.data());
+    squareWordsInto(sum.data(), sum.size(), middle.data());
+
+    subtractWordsInPlace(middle.data(), middle.size(), result, lowSize*2);
+    subtractWordsInPlace(middle.data(), middle.size(), result + lowSize*2, highSize*2);
+    auto carry = addWordsInPlace(result + lowSize, size*2 - lowSize, middle.data(), computeSignificantWordCount(middle.data(), middle.size()));
+    sysmelAssert(carry == 0);
 }
 
-static LargeInteger wordShifted(const LargeInteger &operand, size_t offset)
+static LargeInteger toom3PartOf(const Word *words, size_t size, size_t partIndex, size_t partSize)
 {
     LargeInteger result;
-    result.words.resize(operand.words.size() + offset);
+    auto start = std::min(size, partIndex*partSize);
+    auto end = std::min(size, start + partSize);
+    result.setUnnormalizedWords(words + start, end - start);
+    return result;
+}
 
-    for(size_t i = 0; i < operand.words.size(); ++i)
-        result.words[i + offset] = operand.words[i];
+static void exactlyDivideMagnitudeByThreeInPlace(LargeInteger &dividendAndResult)
+{
+    // The division is exact, so each quotient word is found from the low end with the multiplicative inverse of three.
+    static constexpr Word InverseOfThree = 0xAAAAAAAAAAAAAAABull;
+    Word carry = 0;
+    for(auto &word : dividendAndResult.words)
+    {
+        Word borrow = word < carry ? 1 : 0;
+        Word quotientWord = (word - carry) * InverseOfThree;
+        word = quotientWord;
+        Word productHigh;
+        multiplyAndAddWords(quotientWord, 3, 0, 0, productHigh);
+        carry = productHigh + borrow;
+    }
 
-    return result;
+    sysmelAssert(carry == 0);
+    dividendAndResult.normalize();
 }
 
+static void multiplyWordsToom3Into(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
+{
+    // The operands are split in three parts, evaluated in 0, 1, -1, -2 and infinity, and the
+    // five products are interpolated with the sequence from Bodrato's "Towards Optimal Toom-Cook Multiplication".
+    auto isSquaring = left == right && leftSize == rightSize;
+    auto partSize = (leftSize + 2) / 3;
+    auto multiply = [isSquaring](const LargeInteger &leftFactor, const LargeInteger &rightFactor) {
+        return isSquaring ? leftFactor.squared() : leftFactor * rightFactor;
+    };
+
+    auto left0 = toom3PartOf(left, leftSize, 0, partSize);
+    auto left1 = toom3PartOf(left, leftSize, 1, partSize);
+    auto left2 = toom3PartOf(left, leftSize, 2, partSize);
+    auto leftEvenSum = left0 + left2;
+    auto leftAtOne = leftEvenSum + left1;
+    auto leftAtMinusOne = leftEvenSum - left1;
+    auto leftAtMinusTwo = leftAtMinusOne + left2;
+    leftAtMinusTwo = leftAtMinusTwo + leftAtMinusTwo - left0;
+
+    LargeInteger right0, right1, right2, rightAtOne, rightAtMinusOne, rightAtMinusTwo;
+    if(!isSquaring)
+    {
+        right0 = toom3PartOf(right, rightSize, 0, partSize);
+        right1 = toom3PartOf(right, rightSize, 1, partSize);
+        right2 = toom3PartOf(right, rightSize, 2, partSize);
+        auto rightEvenSum = right0 + right2;
+        rightAtOne = rightEvenSum + right1;
+        rightAtMinusOne = rightEvenSum - right1;
+        rightAtMinusTwo = rightAtMinusOne + right2;
+        rightAtMinusTwo = rightAtMinusTwo + rightAtMinusTwo - right0;
+    }
+
+    auto productAtZero = multiply(left0, right0);
+    auto productAtOne = multiply(leftAtOne, rightAtOne);
+    auto productAtMinusOne = multiply(leftAtMinusOne, rightAtMinusOne);
+    auto productAtMinusTwo = multiply(leftAtMinusTwo, rightAtMinusTwo);
+    auto productAtInfinity = multiply(left2, right2);
+
+    auto coefficient3 = productAtMinusTwo - productAtOne;
+    exactlyDivideMagnitudeByThreeInPlace(coefficient3);
+    auto coefficient1 = productAtOne - productAtMinusOne;
+    coefficient1 >>= 1;
+    auto coefficient2 = productAtMinusOne - productAtZero;
+    coefficient3 = coefficient2 - coefficient3;
+    coefficient3 >>= 1;
+    coefficient3 = coefficient3 + productAtInfinity + productAtInfinity;
+    coefficient2 = coefficient2 + coefficient1 - productAtInfinity;
+    coefficient1 = coefficient1 - coefficient3;
+
+    // The coefficients of the product polynomial are never negative.
+    const LargeInteger *coefficients[] = {&productAtZero, &coefficient1, &coefficient2, &coefficient3, &productAtInfinity};
+    auto resultSize = leftSize + rightSize;
+    std::fill(result, result + resultSize, 0);
+    for(size_t i = 0; i < 5; ++i)
+    {
+        auto &coefficient = *coefficients[i];
+        sysmelAssert(!coefficient.isNegative());
+        auto offset = i*partSize;
+        if(coefficient.isZero())
+            continue;
+
+        sysmelAssert(offset + coefficient.words.size() <= resultSize);
+        auto carry = addWordsInPlace(result + offset, resultSize - offset, coefficient.words.data(), coefficient.words.size());
+        sysmelAssert(carry == 0);
+    }
+}
+
+static void multiplyWordsInto(const Word *left, size_t leftSize, const Word *right, size_t rightSize, Word *result)
+{
+    if(leftSize < rightSize)
+    {
+        std::swap(left, right);
+        std::swap(leftSize, rightSize);
+    }
+
+    if(rightSize < KaratsubaMultiplicationThreshold)
+        multiplyWordsSchoolbookInto(left, leftSize, right, rightSize, result);
+    else if(rightSize <= (leftSize + 1) / 2)
+        multiplyWordsUnbalancedInto(left, leftSize, right, rightSize, result);
+    else if(rightSize < Toom3MultiplicationThreshold)
+        multiplyWordsKaratsubaInto(left, leftSize, right, rightSize, result);
+    else
+        multiplyWordsToom3Into(left, leftSize, right, rightSize, result);
+}
+
+static void squareWordsInto(const Word *operand, size_t size, Word *result)
+{
+    if(size < KaratsubaSquaringThreshold)
+        squareWordsSchoolbookInto(operand, size, result);
+    else if(size < Toom3SquaringThreshold)
+        squareWordsKaratsubaInto(operand, size, result);
+    else
+        multiplyWordsToom3Into(operand, size, operand, size, result);
+}
+
+static void multiplyMagnitudesInto(const LargeInteger &left, const LargeInteger &right, LargeInteger &result)
+{
+    result.words.clear();
+    result.words.resize(left.words.size() + right.words.size());
+    multiplyWordsInto(left.words.data(), left.words.size(), right.words.data(), right.words.size(), result.words.data());
+}
+
+static void squareMagnitudeInto(const LargeInteger &operand, LargeInteger &result)
+{
+    result.words.clear();
+    result.words.resize(operand.words.size()*2);
+    squareWordsInto(operand.words.data(), operand.words.size(), result.words.data());
+}
+
+static Word divideMagnitudeBySingleWordInPlace(LargeInteger &dividendAndQuotient, Word divisor)
+{
+    Word remainder = 0;
+    for(size_t i = dividendAndQuotient.words.size(); i > 0;)
+    {
+        --i;
+        auto &word = dividendAndQuotient.words[i];
+        word = divideDoubleWordByWord(remainder, word, divisor, remainder);
+    }
+
+    dividendAndQuotient.normalize();
+    return remainder;
+}
+
+static Word remainderOfMagnitudeBySingleWord(const LargeInteger &dividend, Word divisor)
+{
+    Word remainder = 0;
+    for(size_t i = dividend.words.size(); i > 0;)
+    {
+        --i;
+        divideDoubleWordByWord(remainder, dividend.words[i], divisor, remainder);
+    }
+
+    return remainder;
+}
+
+/**
+ * I divide the magnitudes with Knuth's algorithm D. The dividend is shifted into the words of the remainder,
+ * where each quotient word is multiplied and subtracted in place, so that the division only allocates the
+ * quotient, the remainder, and a shifted copy of a divisor with more than the inline words.
+ */
 static void divideMagnitudesInto(const LargeInteger &dividend, const LargeInteger &divisor, LargeInteger &quotient, LargeInteger &remainder)
 {
     auto n = divisor.words.size();
     auto m = dividend.words.size() - n;
-    quotient.words.clear();
+    if(n == 1)
+    {
+        quotient.words.assign(dividend.words.begin(), dividend.words.end());
+        auto remainderWord = divideMagnitudeBySingleWordInPlace(quotient, divisor.words[0]);
+        remainder.words.clear();
+        remainder.words.push_back(remainderWord);
+        return;
+    }
+
+    // Normalize the divisor so that its leading word has the high bit set.
+    auto normalizationShift = LargeInteger::WordBits - highBitOf(divisor.words.back());
+    LargeIntegerWords normalizedDivisor;
+    const Word *v = divisor.words.data();
+    if(normalizationShift != 0)
+    {
+        normalizedDivisor.resize(n);
+        shiftWordsLeftInto(divisor.words.data(), n, normalizationShift, normalizedDivisor.data());
+        v = normalizedDivisor.data();
+    }
+
+    auto &u = remainder.words;
+    u.resize(m + n + 1);
+    u[m + n] = shiftWordsLeftInto(dividend.words.data(), m + n, normalizationShift, u.data());
     quotient.words.resize(m + 1);
 
-    remainder = dividend;
-    remainder.signBit = false;
+    auto leadingDivisorWord = v[n - 1];
+    auto nextDivisorWord = v[n - 2];
+    for(size_t j = m + 1; j > 0;)
+    {
+        --j;
+
+        // Estimate the quotient word from the leading words, which is at most one above after the correction.
+        // The leading dividend word is at most the leading divisor word, and the estimate is clamped to a word when they are equal.
+        Word quotientWord;
+        Word estimatedRemainder;
+        Word estimatedRemainderOverflow = 0;
+        if(u[j + n] == leadingDivisorWord)
+        {
+            quotientWord = ~Word(0);
+            estimatedRemainderOverflow = addWordsWithCarry(u[j + n - 1], leadingDivisorWord, 0, estimatedRemainder);
+        }
+        else
+        {
+            quotientWord = divideDoubleWordByWord(u[j + n], u[j + n - 1], leadingDivisorWord, estimatedRemainder);
+        }
+
+        while(!estimatedRemainderOverflow)
+        {
+            Word productHigh;
+            auto productLow = multiplyAndAddWords(quotientWord, nextDivisorWord, 0, 0, productHigh);
+            if(productHigh < estimatedRemainder || (productHigh == estimatedRemainder && productLow <= u[j + n - 2]))
+                break;
+
+            --quotientWord;
+            estimatedRemainderOverflow = addWordsWithCarry(estimatedRemainder, leadingDivisorWord, 0, estimatedRemainder);
+        }
+
+        Word carry = 0;
+        Word borrow = 0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            auto productLow = multiplyAndAddWords(quotientWord, v[i], carry, 0, carry);
+            borrow = subtractWordsWithBorrow(u[i + j], productLow, borrow, u[i + j]);
+        }
+
+        borrow = subtractWordsWithBorrow(u[j + n], carry, borrow, u[j + n]);
+        if(borrow)
+        {
+            // The estimate was one too large, so add back the divisor.
+            --quotientWord;
+            u[j + n] += addWordsInPlace(u.data() + j, n, v, n);
+        }
+
+        quotient.words[j] = quotientWord;
+    }
+
+    u.resize(n);
+    shiftWordsRightInPlace(u.data(), n, normalizationShift);
+}
+
+// The radix conversions between decimal strings and magnitudes split the digits in halves with the powers (10^19)^(2^level).
+static constexpr Word TenRaisedTo19 = 10000000000000000000ull;
+static constexpr size_t DigitsPerDecimalChunk = 19;
+
+// Magnitude sizes in words, and digit counts, below which the conversions are done one chunk at a time.
+static constexpr size_t DecimalPrintingThreshold = 32;
+static constexpr size_t DecimalParsingThreshold = 32*DigitsPerDecimalChunk;
+static constexpr size_t ReciprocalThresholdBits = 32*LargeInteger::WordBits;
 
-    if(compareMagnitudes(dividend, divisor, m) >= 0)
+// I compute floor(2^(2*bitCount) / divisor) for a divisor with exactly bitCount bits, through a Newton iteration
+// that recurses on the leading half of the divisor bits.
+static LargeInteger reciprocalOf(const LargeInteger &divisor, uint32_t bitCount)
+{
+    if(bitCount <= ReciprocalThresholdBits)
+        return (LargeInteger::One << (2*bitCount)) / divisor;
+
+    // The guard bits keep the error of a single Newton step below one.
+    auto leadingBitCount = bitCount/2 + 4;
+    auto discardedBitCount = bitCount - leadingBitCount;
+    auto leadingReciprocal = reciprocalOf(divisor >> discardedBitCount, leadingBitCount);
+
+    // The correction only needs the leading bits of the error.
+    auto approximation = leadingReciprocal << discardedBitCount;
+    auto scale = LargeInteger::One << (2*bitCount);
+    auto error = scale - divisor*approximation;
+    approximation += (leadingReciprocal*(error >> discardedBitCount)) >> (2*leadingBitCount);
+
+    // Correct the truncations of the step.
+    auto residual = scale - divisor*approximation;
+    while(residual.isNegative())
     {
-        quotient.words[m] = 1;
-        remainder -= wordShifted(divisor, m);
-        sysmelAssert(remainder.isNormalized());
+        approximation -= LargeInteger::One;
+        residual += divisor;
     }
-    else
+    while(residual >= divisor)
+    {
+        approximation += LargeInteger::One;
+        residual -= divisor;
+    }
+
+    return approximation;
+}
+
+/**
+ * I am the table of the powers of 10^19 that are squared from each other. The reciprocals are
+ * only needed for the printing divisions, so they are computed on demand. Each thread keeps its
+ * own table, because the scanners parse their literals in worker threads.
+ */
+struct DecimalPowerTable
+{
+    std::vector<LargeInteger> powers;
+    std::vector<LargeInteger> reciprocals;
+    std::vector<uint32_t> bitCounts;
+
+    static DecimalPowerTable &get()
+    {
+        static thread_local DecimalPowerTable table;
+        return table;
+    }
+
+    const LargeInteger &powerAt(size_t level)
+    {
+        if(powers.empty())
+            addPower(LargeInteger(uint64_t(TenRaisedTo19)));
+        while(powers.size() <= level)
+            addPower(powers.back().squared());
+        return powers[level];
+    }
+
+    const LargeInteger &reciprocalAt(size_t level)
     {
-        quotient.words[m] = 0;
+        powerAt(level);
+        if(reciprocals[level].isZero())
+            reciprocals[level] = reciprocalOf(powers[level], bitCounts[level]);
+        return reciprocals[level];
     }
 
-    auto lastDivisorDigit = divisor.words.back();
+    void addPower(LargeInteger &&power)
+    {
+        bitCounts.push_back(power.highBitOfMagnitude());
+        powers.push_back(std::move(power));
+        reciprocals.push_back(LargeInteger::Zero);
+    }
 
-    for(auto i = m; i > 0;)
+    // I divide a magnitude below the square of the power at the level with a Barrett reduction, whose
+    // quotient estimate only uses the leading bits of the dividend and is at most two below the quotient.
+    void divideByPowerAt(const LargeInteger &dividend, size_t level, LargeInteger &quotient, LargeInteger &remainder)
+    {
+        auto &divisor = powerAt(level);
+        auto bitCount = bitCounts[level];
+        quotient = ((dividend >> (bitCount - 1))*reciprocalAt(level)) >> (bitCount + 1);
+        remainder = dividend - quotient*divisor;
+        while(remainder >= divisor)
+        {
+            quotient += LargeInteger::One;
+            remainder -= divisor;
+        }
+    }
+};
+
+static void appendDecimalDigitsOf(const LargeInteger &magnitude, std::string &out)
+{
+    char chunkDigits[DigitsPerDecimalChunk];
+    std::vector<Word> chunks;
+    auto quotient = magnitude;
+    while(!quotient.isZero())
+        chunks.push_back(divideMagnitudeBySingleWordInPlace(quotient, TenRaisedTo19));
+
+    for(size_t i = chunks.size(); i > 0;)
     {
-        sysmelAssert(!remainder.signBit);
         --i;
+        auto chunk = chunks[i];
+        size_t digitCount = 0;
+        do
+        {
+            chunkDigits[digitCount++] = char('0' + chunk % 10);
+            chunk /= 10;
+        } while(chunk != 0);
+
+        // Only the leading chunk is not padded.
+        if(i + 1 != chunks.size())
+            out.append(DigitsPerDecimalChunk - digitCount, '0');
+        while(digitCount > 0)
+            out.push_back(chunkDigits[--digitCount]);
+    }
+}
+
+// I append the digits of a magnitude below (10^19)^(2^(level + 1)). The padded digits fill the whole width of that power.
+static void appendDecimalDigitsOf(const LargeInteger &magnitude, ptrdiff_t level, bool padded, std::string &out)
+{
+    if(level < 0 || magnitude.words.size() <= DecimalPrintingThreshold)
+    {
+        auto startSize = out.size();
+        appendDecimalDigitsOf(magnitude, out);
+        if(padded)
+        {
+            auto width = DigitsPerDecimalChunk << (level + 1);
+            out.insert(startSize, width - (out.size() - startSize), '0');
+        }
+        return;
+    }
 
-        auto &qi = quotient.words[i];
-        auto doubleWordDividend = (uint64_t(remainder.wordAt(i + n)) << 32) | remainder.wordAt(i + n - 1);
-        auto qs = doubleWordDividend / lastDivisorDigit;
-        qi = uint32_t(std::min(qs, uint64_t(0xFFFFFFFF)));
+    auto &table = DecimalPowerTable::get();
+    if(!padded && compareMagnitudes(magnitude, table.powerAt(level)) < 0)
+        return appendDecimalDigitsOf(magnitude, level - 1, false, out);
 
-        remainder -= timeFactorWithOffset(divisor, qi, i);
-        while(remainder.signBit)
+    LargeInteger quotient;
+    LargeInteger remainder;
+    table.divideByPowerAt(magnitude, level, quotient, remainder);
+    appendDecimalDigitsOf(quotient, level - 1, padded, out);
+    appendDecimalDigitsOf(remainder, level - 1, true, out);
+}
+
+// I parse a string of decimal digits as the leading half times a power of 10^19 plus the trailing half.
+static LargeInteger parseDecimalDigits(const char *digits, size_t digitCount)
+{
+    if(digitCount <= DecimalParsingThreshold)
+    {
+        LargeInteger result;
+        result.words.reserve(digitCount/DigitsPerDecimalChunk + 1);
+        size_t chunkDigitCount = digitCount % DigitsPerDecimalChunk;
+        if(chunkDigitCount == 0)
+            chunkDigitCount = DigitsPerDecimalChunk;
+        for(size_t i = 0; i < digitCount; i += chunkDigitCount, chunkDigitCount = DigitsPerDecimalChunk)
         {
-            sysmelAssert(qi > 0);
-            --qi;
-            remainder += wordShifted(divisor, i);
+            Word chunk = 0;
+            Word chunkScale = 1;
+            for(size_t j = 0; j < chunkDigitCount; ++j)
+            {
+                chunk = chunk*10 + Word(digits[i + j] - '0');
+                chunkScale *= 10;
+            }
+            multiplyAndAddBySingleWordInPlace(result, chunkScale, chunk);
         }
+
+        result.normalize();
+        return result;
     }
 
-    sysmelAssert(compareMagnitudes(remainder, divisor) < 0);
+    size_t level = 0;
+    while((DigitsPerDecimalChunk << (level + 1)) < digitCount)
+        ++level;
+
+    auto trailingDigitCount = DigitsPerDecimalChunk << level;
+    auto leadingDigitCount = digitCount - trailingDigitCount;
+    auto result = parseDecimalDigits(digits, leadingDigitCount) * DecimalPowerTable::get().powerAt(level);
+    result += parseDecimalDigits(digits + leadingDigitCount, trailingDigitCount);
+    return result;
 }
 
 static uint8_t bitsPerDigitInRadix(uint8_t radix)
@@ -236,7 +957,7 @@ static uint8_t bitsPerDigitInRadix(uint8_t radix)
     if(radix == 0)
         return 0;
 
-    return uint8_t(highBitOf(uint32_t(radix - 1)) + 1);
+    return uint8_t(highBitOf(Word(radix - 1)) + 1);
 }
 
 static int8_t parseDigitInRadix(char digit, uint8_t radix)
@@ -256,6 +977,32 @@ static int8_t parseDigitInRadix(char digit, uint8_t radix)
     return parsedDigit;
 }
 
+LargeIntegerWords::Statistics LargeIntegerWords::statistics;
+
+void LargeIntegerWords::Statistics::printOn(FILE *out) const
+{
+    fprintf(out, "Large integer heap allocations: %" PRIu64 "\n", uint64_t(heapAllocations));
+    fprintf(out, "Large integer heap allocated words: %" PRIu64 "\n", uint64_t(heapAllocatedWords));
+}
+
+LargeIntegerWords::Statistics &LargeIntegerWords::getStatistics()
+{
+    return statistics;
+}
+
+void LargeIntegerWords::grow(size_t requiredCapacity)
+{
+    auto newCapacity = std::max(requiredCapacity, size_t(capacity)*2);
+    auto newWords = new Word[newCapacity];
+    std::copy(begin(), end(), newWords);
+    releaseHeapWords();
+
+    heapWords = newWords;
+    capacity = uint32_t(newCapacity);
+    statistics.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    statistics.heapAllocatedWords.fetch_add(newCapacity, std::memory_order_relaxed);
+}
+
 const LargeInteger LargeInteger::Zero = LargeInteger{0};
 const LargeInteger LargeInteger::One = LargeInteger{1};
 const LargeInteger LargeInteger::MinusOne = LargeInteger{-1};
@@ -286,13 +1033,13 @@ LargeInteger::LargeInteger(size_t value)
     setValue(value);
 }
 
-LargeInteger::LargeInteger(bool isNegative, const std::vector<uint32_t> &newWords)
+LargeInteger::LargeInteger(bool isNegative, const LargeIntegerWords &newWords)
 {
     signBit = isNegative;
     setUnnormalizedWords(newWords);
 }
 
-LargeInteger::LargeInteger(bool isNegative, std::vector<uint32_t> &&newWords)
+LargeInteger::LargeInteger(bool isNegative, LargeIntegerWords &&newWords)
 {
     signBit = isNegative;
     words = std::move(newWords);
@@ -307,7 +1054,7 @@ LargeInteger::LargeInteger(const std::string &string, uint8_t radix)
 void LargeInteger::setValue(uint32_t value)
 {
     signBit = false;
-    uint32_t newWords[] = {
+    Word newWords[] = {
         value,
     };
     setUnnormalizedWords(newWords);
@@ -316,8 +1063,8 @@ void LargeInteger::setValue(uint32_t value)
 void LargeInteger::setValue(int32_t value)
 {
     signBit = value < 0;
-    uint32_t newWords[] = {
-        static_cast<uint32_t> (value < 0 ? -value : value),
+    Word newWords[] = {
+        value < 0 ? Word(0) - Word(value) : Word(value),
     };
     setUnnormalizedWords(newWords);
 }
@@ -325,9 +1072,8 @@ void LargeInteger::setValue(int32_t value)
 void LargeInteger::setValue(uint64_t value)
 {
     signBit = 0;
-    uint32_t newWords[] = {
-        static_cast<uint32_t> (value & 0xffffffff),
-        static_cast<uint32_t> (value >> 32),
+    Word newWords[] = {
+        value,
     };
     setUnnormalizedWords(newWords);
 }
@@ -335,10 +1081,9 @@ void LargeInteger::setValue(uint64_t value)
 void LargeInteger::setValue(int64_t value)
 {
     signBit = value < 0;
-    uint64_t absValue = value < 0 ? -value : value;
-    uint32_t newWords[] = {
-        static_cast<uint32_t> (absValue & 0xffffffff),
-        static_cast<uint32_t> (absValue >> 32),
+    uint64_t absValue = value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+    Word newWords[] = {
+        absValue,
     };
     setUnnormalizedWords(newWords);
 }
@@ -371,26 +1116,42 @@ void LargeInteger::setValueByParsingFrom(const std::string &string, uint8_t radi
         ++startIndex;
     }
 
+    if(radix == 10)
+    {
+        std::string digits;
+        digits.reserve(string.size() - startIndex);
+        for(size_t i = startIndex; i < string.size(); ++i)
+        {
+            if('0' <= string[i] && string[i] <= '9')
+                digits.push_back(string[i]);
+        }
+
+        auto parsedSignBit = signBit;
+        *this = parseDecimalDigits(digits.data(), digits.size());
+        signBit = parsedSignBit && !isZero();
+        return;
+    }
+
     size_t digitCount = string.size() - startIndex;
-    size_t requiredWordCount = (digitCount * bitsPerDigitInRadix(radix) + 31) / 32;
+    size_t requiredWordCount = (digitCount * bitsPerDigitInRadix(radix) + WordBits - 1) / WordBits;
     words.clear();
     words.reserve(requiredWordCount);
     for(size_t i = startIndex; i < string.size(); ++i)
     {
         auto digit = parseDigitInRadix(string[i], radix);
         if(digit >= 0)
-            multiplyAndAddBySingleWordInPlace(*this, radix, uint32_t(digit));
+            multiplyAndAddBySingleWordInPlace(*this, radix, Word(digit));
     }
 
     normalize();
 }
 
-void LargeInteger::setUnnormalizedWords(const std::vector<uint32_t> &newWords)
+void LargeInteger::setUnnormalizedWords(const LargeIntegerWords &newWords)
 {
     setUnnormalizedWords(newWords.data(), newWords.size());
 }
 
-void LargeInteger::setUnnormalizedWords(const uint32_t newWords[], size_t wordCount)
+void LargeInteger::setUnnormalizedWords(const Word newWords[], size_t wordCount)
 {
     auto normalizedWordCount = computeSignificantWordCount(newWords, wordCount);
     words.resize(normalizedWordCount);
@@ -483,7 +1244,7 @@ LargeInteger LargeInteger::operator+(const LargeInteger &other) const
 
 LargeInteger &LargeInteger::operator+=(const LargeInteger &other)
 {
-    *this = *this + other;
+    addSignedMagnitudeInPlace(*this, other, other.signBit);
     return *this;
 }
 
@@ -521,7 +1282,7 @@ LargeInteger LargeInteger::operator-(const LargeInteger &other) const
 
 LargeInteger &LargeInteger::operator-=(const LargeInteger &other)
 {
-    *this = *this - other;
+    addSignedMagnitudeInPlace(*this, other, !other.signBit);
     return *this;
 }
 
@@ -542,17 +1303,35 @@ LargeInteger LargeInteger::operator*(const LargeInteger &other) const
         return -(*this);
 
     LargeInteger result;
-    result.signBit = signBit ^ other.signBit;
-    if(words.size() >= other.words.size())
+    if(this == &other || (words.size() >= KaratsubaSquaringThreshold && words == other.words))
+        squareMagnitudeInto(*this, result);
+    else if(words.size() >= other.words.size())
         multiplyMagnitudesInto(*this, other, result);
     else
         multiplyMagnitudesInto(other, *this, result);
+    result.signBit = signBit ^ other.signBit;
+    result.normalize();
+    return result;
+}
+
+LargeInteger LargeInteger::squared() const
+{
+    LargeInteger result;
+    squareMagnitudeInto(*this, result);
     result.normalize();
     return result;
 }
 
 LargeInteger &LargeInteger::operator*=(const LargeInteger &other)
 {
+    // The product of several words cannot overlap its operands, so it is only in place for a single word factor.
+    if(other.words.size() == 1 && !isZero())
+    {
+        multiplyAndAddBySingleWordInPlace(*this, other.words[0], 0);
+        signBit = signBit != other.signBit;
+        return *this;
+    }
+
     *this = *this * other;
     return *this;
 }
@@ -567,12 +1346,31 @@ LargeInteger LargeInteger::operator/(const LargeInteger &divisor) const
 
 LargeInteger &LargeInteger::operator/=(const LargeInteger &divisor)
 {
-    *this = *this / divisor;
+    if(divisor.words.size() == 1)
+    {
+        divideMagnitudeBySingleWordInPlace(*this, divisor.words[0]);
+        signBit = signBit != divisor.signBit;
+        normalize();
+        return *this;
+    }
+
+    LargeInteger quotient;
+    LargeInteger remainder;
+    divisionAndRemainder(divisor, quotient, remainder);
+    *this = std::move(quotient);
     return *this;
 }
 
 LargeInteger LargeInteger::operator%(const LargeInteger &divisor) const
 {
+    if(divisor.words.size() == 1)
+    {
+        LargeInteger remainder(uint64_t(remainderOfMagnitudeBySingleWord(*this, divisor.words[0])));
+        remainder.signBit = signBit;
+        remainder.normalize();
+        return remainder;
+    }
+
     LargeInteger quotient;
     LargeInteger remainder;
     divisionAndRemainder(divisor, quotient, remainder);
@@ -581,94 +1379,89 @@ LargeInteger LargeInteger::operator%(const LargeInteger &divisor) const
 
 LargeInteger &LargeInteger::operator%=(const LargeInteger &divisor)
 {
-    *this = *this % divisor;
+    if(divisor.words.size() == 1)
+    {
+        auto remainderWord = remainderOfMagnitudeBySingleWord(*this, divisor.words[0]);
+        words.clear();
+        words.push_back(remainderWord);
+        normalize();
+        return *this;
+    }
+
+    LargeInteger quotient;
+    LargeInteger remainder;
+    divisionAndRemainder(divisor, quotient, remainder);
+    *this = std::move(remainder);
     return *this;
 }
 
 LargeInteger LargeInteger::operator<<(uint32_t shiftAmount) const
 {
-    if(isZero() || shiftAmount == 0)
-        return *this;
-
+    // Reserve the shifted size up front, so that the shift does not grow the copy.
     LargeInteger result;
-    auto insertedWordCount = shiftAmount / 32;
-    auto actualShiftedAmount = shiftAmount % 32;
-
-    auto remainingFreeSpace = 32 - highBitOf(words.back());
-    auto hasExtraWordAtEnd = actualShiftedAmount > remainingFreeSpace;
-    auto resultSize = words.size() + insertedWordCount + (hasExtraWordAtEnd ? 1 : 0);
     result.signBit = signBit;
-    result.words.resize(resultSize);
-
-    uint32_t carry = 0;
-    for(size_t i = 0; i < words.size(); ++i)
-    {
-        auto carriedWord = (uint64_t(words[i]) << actualShiftedAmount) | carry;
-        result.words[i + insertedWordCount] = uint32_t(carriedWord & 0xFFFFFFFF);
-        carry = carriedWord >> 32;
-    }
-
-    if(carry != 0)
-    {
-        sysmelAssert(hasExtraWordAtEnd);
-        result.words.back() = carry;
-    }
-
-    result.normalize();
+    result.words.reserve(words.size() + shiftAmount / WordBits + 1);
+    result.words.assign(words.begin(), words.end());
+    result <<= shiftAmount;
     return result;
 }
 
 LargeInteger &LargeInteger::operator<<=(uint32_t shiftAmount)
 {
-    *this = *this << shiftAmount;
+    if(isZero() || shiftAmount == 0)
+        return *this;
+
+    auto insertedWordCount = shiftAmount / WordBits;
+    auto size = words.size();
+    words.resize(size + insertedWordCount + 1);
+
+    auto data = words.data();
+    data[size + insertedWordCount] = shiftWordsLeftInto(data, size, shiftAmount % WordBits, data + insertedWordCount);
+    std::fill(data, data + insertedWordCount, 0);
+    normalize();
     return *this;
 }
 
 LargeInteger LargeInteger::operator>>(uint32_t shiftAmount) const
+{
+    auto result = *this;
+    result >>= shiftAmount;
+    return result;
+}
+
+LargeInteger &LargeInteger::operator>>=(uint32_t shiftAmount)
 {
     if(isZero() || shiftAmount == 0)
         return *this;
-    
-    auto removedWordCount = shiftAmount / 32;
-    if(removedWordCount >= words.size())
-        return Zero;
-
-    auto actualShiftedAmount = shiftAmount % 32;
 
-    LargeInteger result;
-    result.signBit = signBit;
-    result.words.resize(words.size() - removedWordCount);
-    if(actualShiftedAmount == 0)
-    {
-        for(size_t i = 0; i < result.words.size(); ++i)
-            result.words[i] = words[i + removedWordCount];
-    }
-    else
+    auto removedWordCount = shiftAmount / WordBits;
+    if(removedWordCount >= words.size())
     {
-        uint32_t nextWordMask = (1<<actualShiftedAmount) - 1;
-        uint32_t nextWordShift = 32 - actualShiftedAmount;
-        for(size_t i = 0; i < result.words.size(); ++i)
-        {
-            uint32_t nextBits = 0;
-            if(i + 1 < result.words.size())
-            {
-                auto nextWord = words[i + removedWordCount + 1];
-                nextBits = (nextWord & nextWordMask) << nextWordShift;
-            }
-            result.words[i] = (words[i + removedWordCount] >> actualShiftedAmount) | nextBits;
-        }
-            
+        *this = Zero;
+        return *this;
     }
 
-    result.normalize();
-
-    return result;
+    auto size = words.size() - removedWordCount;
+    std::copy(words.begin() + removedWordCount, words.end(), words.begin());
+    words.resize(size);
+    shiftWordsRightInPlace(words.data(), size, shiftAmount % WordBits);
+    normalize();
+    return *this;
 }
 
-LargeInteger &LargeInteger::operator>>=(uint32_t shiftAmount)
+static LargeInteger productOfRange(uint64_t first, uint64_t last)
 {
-    *this = *this >> shiftAmount;
-    return *this;
+    // Splitting the range in halves keeps the factors balanced, where the faster multiplications apply.
+    if(last - first < 16)
+    {
+        LargeInteger result = LargeInteger::One;
+        for(auto factor = first; factor <= last; ++factor)
+            result *= LargeInteger(factor);
+        return result;
+    }
+
+    auto middle = first + (last - first) / 2;
+    return productOfRange(first, middle) * productOfRange(middle + 1, last);
 }
 
 LargeInteger LargeInteger::factorial() const
@@ -676,7 +1469,7 @@ LargeInteger LargeInteger::factorial() const
     if(isZero())
         return One;
 
-    return *this * (*this + MinusOne).factorial();
+    return productOfRange(1, uint64_t(*this));
 }
 
 LargeInteger LargeInteger::binomialCoefficient(const LargeInteger &n, const LargeInteger &k)
@@ -689,7 +1482,7 @@ uint32_t LargeInteger::highBitOfMagnitude() const
     sysmelAssert(isNormalized());
     if(isZero())
         return 0;
-    return uint32_t(highBitOf(words.back()) + (words.size() - 1) * 32);
+    return uint32_t(highBitOf(words.back()) + (words.size() - 1) * WordBits);
 
 }
 
@@ -706,18 +1499,20 @@ double LargeInteger::asDouble() const
     }
 
 
-    auto mantissaPart = words[words.size() - 2] | (uint64_t(words[words.size() - 1]) << 32);
-    auto remainingWordCount = words.size() - 2;
-    double mantissa = double(mantissaPart);
+    // Take the leading word worth of bits, and keep the discarded ones as a sticky bit so that the conversion rounds once.
+    auto shiftAmount = highBitOfMagnitude() - WordBits;
+    auto wordShift = shiftAmount / WordBits;
+    auto bitShift = shiftAmount % WordBits;
+    auto leadingBits = words[wordShift] >> bitShift;
+    if(bitShift != 0)
+        leadingBits |= words[wordShift + 1] << (WordBits - bitShift);
 
-    // Add the third word which might have additional required bits.
-    if(words.size() >= 3)
-    {
-        mantissa = ldexp(mantissa, 32) + words[words.size() - 3];
-        --remainingWordCount;
-    }
+    auto hasDiscardedBits = (bitShift != 0 && (words[wordShift] << (WordBits - bitShift)) != 0) || !isAllZeroWords(words.data(), wordShift);
+    if(hasDiscardedBits)
+        leadingBits |= 1;
 
-    return ldexp(signBit ? -mantissa : mantissa, int(remainingWordCount*32));
+    double mantissa = double(leadingBits);
+    return ldexp(signBit ? -mantissa : mantissa, int(shiftAmount));
 }
 
 void LargeInteger::divisionAndRemainder(const LargeInteger &divisor, LargeInteger &quotient, LargeInteger &remainder) const
@@ -725,6 +1520,17 @@ void LargeInteger::divisionAndRemainder(const LargeInteger &divisor, LargeIntege
     if(divisor.isZero())
         throw DivisionByZeroError();
 
+    // The results are written while the operands are read.
+    if(&quotient == this || &quotient == &divisor || &remainder == this || &remainder == &divisor)
+    {
+        LargeInteger separateQuotient;
+        LargeInteger separateRemainder;
+        divisionAndRemainder(divisor, separateQuotient, separateRemainder);
+        quotient = std::move(separateQuotient);
+        remainder = std::move(separateRemainder);
+        return;
+    }
+
     // Compare the magnitude to rule out the easy cases.
     auto magnitudeComparison = compareMagnitudes(*this, divisor);
     if(magnitudeComparison < 0)
@@ -743,22 +1549,7 @@ void LargeInteger::divisionAndRemainder(const LargeInteger &divisor, LargeIntege
         return;
     }
 
-    auto lastWord = divisor.words.back();
-    auto lastWordHighBit = highBitOf(lastWord);
-    auto normalizationBitShift = 32 - lastWordHighBit;
-    if(normalizationBitShift == 0)
-    {
-        divideMagnitudesInto(*this, divisor, quotient, remainder);
-    }
-    else
-    {
-        auto normalizedDividend = *this << normalizationBitShift;
-        auto normalizedDivisor = divisor << normalizationBitShift;
-        divideMagnitudesInto(normalizedDividend, normalizedDivisor, quotient, remainder);
-
-        remainder >>= normalizationBitShift;
-    }
-
+    divideMagnitudesInto(*this, divisor, quotient, remainder);
     quotient.signBit = signBit ^ divisor.signBit;
     quotient.normalize();
     remainder.signBit = signBit;
@@ -773,7 +1564,7 @@ std::string LargeInteger::asHexString() const
     }
 
     std::string result;
-    result.reserve(words.size()*8 + (signBit ? 1 : 0));
+    result.reserve(words.size()*WordBits/4 + (signBit ? 1 : 0));
     if(signBit)
         result.push_back('-');
 
@@ -782,9 +1573,9 @@ std::string LargeInteger::asHexString() const
     for(size_t i = 0; i < words.size(); ++i)
     {
         auto word = words[words.size() - i - 1];
-        for(auto j = 0; j < 8; ++j)
+        for(uint32_t j = 0; j < WordBits/4; ++j)
         {
-            auto nibble = (word >> (32 - j*4 - 4)) & 0xF;
+            auto nibble = (word >> (WordBits - j*4 - 4)) & 0xF;
             if(nibble != 0 || hasNonZeroLeft)
             {
                 hasNonZeroLeft = true;
@@ -803,81 +1594,267 @@ std::string LargeInteger::asString() const
         return "0";
     }
 
-    if(words.size() <= 2)
+    if(words.size() == 1)
     {
         std::ostringstream out;
         if(signBit)
             out << '-';
-        if(words.size() == 2)
-        {
-            out << (words[0] | (uint64_t(words[1]) << 32));
-        }
-        else
-        {
-            out << words[0];
-        }
-
+        out << words[0];
         return out.str();
     }
 
-    // TODO: Use a proper divide-and-conquer algorithm for this.
-    static const LargeInteger TenRaisedTo19 = LargeInteger{uint64_t(10000000000000000000ull)};
+    auto magnitude = *this;
+    magnitude.signBit = false;
 
-    LargeInteger currentValue = *this;
-    currentValue.signBit = false;
+    // Start from the level whose next power is above me.
+    auto &table = DecimalPowerTable::get();
+    ptrdiff_t level = -1;
+    if(words.size() > DecimalPrintingThreshold)
+    {
+        while(compareMagnitudes(magnitude, table.powerAt(level + 1)) >= 0)
+            ++level;
+    }
+
+    std::string result;
+    result.reserve(words.size()*WordBits*3/10 + 2);
+    if(signBit)
+        result.push_back('-');
+    appendDecimalDigitsOf(magnitude, level, false, result);
+    return result;
+}
 
+LargeInteger LargeInteger::abs() const
+{
+    return isNegative() ? -(*this) : *this;
+}
+
+static uint32_t trailingZeroCountOf(Word word)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return uint32_t(index);
+#elif defined(__GNUC__)
+    return uint32_t(__builtin_ctzll(word));
+#else
+    uint32_t result = 0;
+    while((word & 1) == 0)
+    {
+        ++result;
+        word >>= 1;
+    }
+
+    return result;
+#endif
+}
+
+static Word binaryGcdOfWords(Word u, Word v)
+{
+    if(u == 0)
+        return v;
+    if(v == 0)
+        return u;
+
+    auto commonShift = trailingZeroCountOf(u | v);
+    u >>= trailingZeroCountOf(u);
+    do
+    {
+        v >>= trailingZeroCountOf(v);
+        if(u > v)
+            std::swap(u, v);
+        v -= u;
+    } while(v != 0);
+
+    return u << commonShift;
+}
+
+// I take the bits of a magnitude that start at the shift, which must fit in a word.
+static int64_t leadingBitsOf(const LargeInteger &magnitude, uint32_t shift)
+{
+    auto wordShift = shift / LargeInteger::WordBits;
+    auto bitShift = shift % LargeInteger::WordBits;
+    auto result = magnitude.wordAt(wordShift) >> bitShift;
+    if(bitShift != 0)
+        result |= magnitude.wordAt(wordShift + 1) << (LargeInteger::WordBits - bitShift);
+    return int64_t(result);
+}
+
+// I compute a*x + b*y for a non-negative result, when the cofactors a and b have opposite signs.
+static void linearCombinationOfMagnitudesInto(const LargeInteger &x, int64_t a, const LargeInteger &y, int64_t b, LargeInteger &result)
+{
+    const LargeInteger *minuend = &x;
+    const LargeInteger *subtrahend = &y;
+    auto minuendFactor = Word(a);
+    auto subtrahendFactor = Word(-b);
+    if(b > 0)
+    {
+        std::swap(minuend, subtrahend);
+        minuendFactor = Word(b);
+        subtrahendFactor = Word(-a);
+    }
+
+    auto size = std::max(x.words.size(), y.words.size());
+    result.words.resize(size + 1);
+
+    Word minuendCarry = 0;
+    Word subtrahendCarry = 0;
+    Word borrow = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        auto minuendProduct = multiplyAndAddWords(minuend->wordAt(i), minuendFactor, minuendCarry, 0, minuendCarry);
+        auto subtrahendProduct = multiplyAndAddWords(subtrahend->wordAt(i), subtrahendFactor, subtrahendCarry, 0, subtrahendCarry);
+        borrow = subtractWordsWithBorrow(minuendProduct, subtrahendProduct, borrow, result.words[i]);
+    }
+
+    result.words[size] = minuendCarry - subtrahendCarry - borrow;
+    result.signBit = false;
+    result.normalize();
+}
+
+/**
+ * I compute the gcd of two magnitudes with u >= v by Lehmer's algorithm, which runs the Euclidean steps on
+ * the leading 62 bits and applies their accumulated cofactors to the whole magnitudes at once. When requested,
+ * I also track the cofactor of the original v, whose product with it is congruent to the gcd modulo the original u.
+ */
+static LargeInteger lehmerGcdOfMagnitudes(LargeInteger u, LargeInteger v, LargeInteger *vCofactor)
+{
+    static constexpr uint32_t LeadingBitCount = 62;
+
+    LargeInteger previousCofactor = LargeInteger::Zero;
+    LargeInteger cofactor = LargeInteger::One;
+    LargeInteger nextU;
+    LargeInteger nextV;
     LargeInteger quotient;
     LargeInteger remainder;
-    std::string reverseResult;
-    reverseResult.reserve(words.size()*32 / 4);
-    while(!currentValue.isZero())
+    while(v.words.size() > 1)
     {
-        currentValue.divisionAndRemainder(TenRaisedTo19, quotient, remainder);
-        auto segmentRemainder = remainder.wordAt(0) | (uint64_t(remainder.wordAt(1)) << 32);
+        auto shift = u.highBitOfMagnitude() - LeadingBitCount;
+        auto uLeading = leadingBitsOf(u, shift);
+        auto vLeading = leadingBitsOf(v, shift);
 
-        size_t segmentDigitCount = 0;
-        do
+        // Knuth's algorithm L, where each quotient is only accepted if it is the same for both bounds of the leading bits.
+        int64_t a = 1, b = 0, c = 0, d = 1;
+        for(;;)
         {
-            reverseResult.push_back((segmentRemainder % 10) + '0');
-            segmentRemainder /= 10;
-            ++segmentDigitCount;
-        } while(segmentRemainder != 0);
+            if(vLeading + c <= 0 || vLeading + d <= 0)
+                break;
+
+            auto q = (uLeading + a) / (vLeading + c);
+            if(q != (uLeading + b) / (vLeading + d))
+                break;
 
-        sysmelAssert(segmentDigitCount <= 19);
-        if(!quotient.isZero())
+            auto t = a - q*c; a = c; c = t;
+            t = b - q*d; b = d; d = t;
+            t = uLeading - q*vLeading; uLeading = vLeading; vLeading = t;
+        }
+
+        if(b == 0)
         {
-            auto paddingCount = 19 - segmentDigitCount;
-            for(size_t i = 0; i < paddingCount; ++i)
-                reverseResult.push_back('0');
+            // The leading bits do not determine a quotient, which is too large, so take a full division step.
+            u.divisionAndRemainder(v, quotient, remainder);
+            std::swap(u, v);
+            std::swap(v, remainder);
+            if(vCofactor)
+            {
+                auto nextCofactor = previousCofactor - quotient*cofactor;
+                previousCofactor = std::move(cofactor);
+                cofactor = std::move(nextCofactor);
+            }
+            continue;
         }
 
-        currentValue = quotient;
+        linearCombinationOfMagnitudesInto(u, a, v, b, nextU);
+        linearCombinationOfMagnitudesInto(u, c, v, d, nextV);
+        std::swap(u, nextU);
+        std::swap(v, nextV);
+        if(vCofactor)
+        {
+            auto nextPreviousCofactor = LargeInteger(a)*previousCofactor + LargeInteger(b)*cofactor;
+            cofactor = LargeInteger(c)*previousCofactor + LargeInteger(d)*cofactor;
+            previousCofactor = std::move(nextPreviousCofactor);
+        }
     }
 
-    std::string result;
-    result.reserve(reverseResult.size() + (signBit ? 1 : 0));
-    if(signBit)
-        result.push_back('-');
-    result.insert(result.end(), reverseResult.rbegin(), reverseResult.rend());
-    return result;
-}
+    if(!vCofactor)
+    {
+        if(v.isZero())
+            return u;
 
-LargeInteger LargeInteger::abs() const
-{
-    return isNegative() ? -(*this) : *this;
+        auto uWord = divideMagnitudeBySingleWordInPlace(u, v.words[0]);
+        return LargeInteger(uint64_t(binaryGcdOfWords(v.words[0], uWord)));
+    }
+
+    // The remaining steps are on single words, which are kept inline.
+    while(!v.isZero())
+    {
+        u.divisionAndRemainder(v, quotient, remainder);
+        std::swap(u, v);
+        std::swap(v, remainder);
+        auto nextCofactor = previousCofactor - quotient*cofactor;
+        previousCofactor = std::move(cofactor);
+        cofactor = std::move(nextCofactor);
+    }
+
+    *vCofactor = std::move(previousCofactor);
+    return u;
 }
 
 LargeInteger LargeInteger::gcd(const LargeInteger &a, const LargeInteger &b)
 {
     auto ca = a.abs();
     auto cb = b.abs();
-    while(!cb.isZero())
-    {
-        auto t = cb;
-        cb = ca % cb;
-        ca = t;
-    }
+    if(ca < cb)
+        std::swap(ca, cb);
+    return lehmerGcdOfMagnitudes(std::move(ca), std::move(cb), nullptr);
+}
 
-    return ca;
+LargeInteger LargeInteger::lcm(const LargeInteger &a, const LargeInteger &b)
+{
+    if(a.isZero() || b.isZero())
+        return Zero;
+
+    return (a / gcd(a, b) * b).abs();
+}
+
+LargeInteger LargeInteger::extendedGcd(const LargeInteger &a, const LargeInteger &b, LargeInteger &aCofactor, LargeInteger &bCofactor)
+{
+    // Solve for the cofactor of the smaller magnitude, and derive the other one with a single division.
+    auto swapped = compareMagnitudes(a, b) < 0;
+    auto &larger = swapped ? b : a;
+    auto &smaller = swapped ? a : b;
+    auto &largerCofactor = swapped ? bCofactor : aCofactor;
+    auto &smallerCofactor = swapped ? aCofactor : bCofactor;
+
+    auto result = lehmerGcdOfMagnitudes(larger.abs(), smaller.abs(), &smallerCofactor);
+    if(smaller.isNegative())
+        smallerCofactor = -smallerCofactor;
+
+    if(larger.isZero())
+        largerCofactor = Zero;
+    else
+        largerCofactor = (result - smaller*smallerCofactor) / larger;
+    return result;
+}
+
+LargeInteger LargeInteger::modularInverse(const LargeInteger &modulus) const
+{
+    if(modulus.isZero())
+        throw DivisionByZeroError();
+
+    auto modulusMagnitude = modulus.abs();
+    auto reduced = *this % modulusMagnitude;
+    if(reduced.isNegative())
+        reduced += modulusMagnitude;
+
+    LargeInteger inverse;
+    auto divisor = lehmerGcdOfMagnitudes(modulusMagnitude, reduced, &inverse);
+    if(!divisor.isOne())
+        throw NotInvertibleError();
+
+    inverse %= modulusMagnitude;
+    if(inverse.isNegative())
+        inverse += modulusMagnitude;
+    return inverse;
 }
+
 } // End of namespace Sysmel
@@ -3,9 +3,12 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 #include <string>
 #include <ostream>
 #include <vector>
+#include <atomic>
+#include <algorithm>
 #include "Assert.hpp"
 
 namespace Sysmel
@@ -20,13 +23,221 @@ public:
     }
 };
 
+class NotInvertibleError : public std::exception
+{
+public:
+    virtual const char* what() const throw()
+    {
+        return "Integer is not invertible modulo the modulus";
+    }
+};
+
+/**
+ * I hold the magnitude words of a large integer. A few words are kept inline, which
+ * covers the values that barely overflow a small integer and the temporaries of their
+ * arithmetic, and only larger magnitudes are allocated in the heap.
+ */
+class LargeIntegerWords
+{
+public:
+    typedef uint64_t Word;
+    static constexpr uint32_t InlineCapacity = 4;
+
+    struct Statistics
+    {
+        std::atomic<uint64_t> heapAllocations {0};
+        std::atomic<uint64_t> heapAllocatedWords {0};
+
+        void printOn(FILE *out) const;
+    };
+
+    LargeIntegerWords()
+    {
+    }
+
+    LargeIntegerWords(const LargeIntegerWords &other)
+    {
+        assign(other.begin(), other.end());
+    }
+
+    LargeIntegerWords(LargeIntegerWords &&other) noexcept
+    {
+        takeWordsFrom(other);
+    }
+
+    ~LargeIntegerWords()
+    {
+        releaseHeapWords();
+    }
+
+    LargeIntegerWords &operator=(const LargeIntegerWords &other)
+    {
+        if(this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    LargeIntegerWords &operator=(LargeIntegerWords &&other) noexcept
+    {
+        if(this != &other)
+        {
+            releaseHeapWords();
+            takeWordsFrom(other);
+        }
+        return *this;
+    }
+
+    bool operator==(const LargeIntegerWords &other) const
+    {
+        return wordCount == other.wordCount && std::equal(begin(), end(), other.begin());
+    }
+
+    bool isInline() const
+    {
+        return capacity <= InlineCapacity;
+    }
+
+    Word *data()
+    {
+        return isInline() ? inlineWords : heapWords;
+    }
+
+    const Word *data() const
+    {
+        return isInline() ? inlineWords : heapWords;
+    }
+
+    size_t size() const
+    {
+        return wordCount;
+    }
+
+    bool empty() const
+    {
+        return wordCount == 0;
+    }
+
+    Word *begin()
+    {
+        return data();
+    }
+
+    Word *end()
+    {
+        return data() + wordCount;
+    }
+
+    const Word *begin() const
+    {
+        return data();
+    }
+
+    const Word *end() const
+    {
+        return data() + wordCount;
+    }
+
+    Word &operator[](size_t index)
+    {
+        return data()[index];
+    }
+
+    const Word &operator[](size_t index) const
+    {
+        return data()[index];
+    }
+
+    Word &back()
+    {
+        return data()[wordCount - 1];
+    }
+
+    const Word &back() const
+    {
+        return data()[wordCount - 1];
+    }
+
+    void clear()
+    {
+        wordCount = 0;
+    }
+
+    void reserve(size_t requiredCapacity)
+    {
+        if(requiredCapacity > capacity)
+            grow(requiredCapacity);
+    }
+
+    // The new words are zero.
+    void resize(size_t newSize)
+    {
+        reserve(newSize);
+        if(newSize > wordCount)
+            std::fill(data() + wordCount, data() + newSize, 0);
+        wordCount = uint32_t(newSize);
+    }
+
+    void push_back(Word word)
+    {
+        if(wordCount == capacity)
+            grow(size_t(capacity)*2);
+        data()[wordCount++] = word;
+    }
+
+    void assign(const Word *first, const Word *last)
+    {
+        auto newSize = size_t(last - first);
+        clear();
+        reserve(newSize);
+        std::copy(first, last, data());
+        wordCount = uint32_t(newSize);
+    }
+
+    static Statistics &getStatistics();
+
+private:
+    void grow(size_t requiredCapacity);
+
+    void releaseHeapWords()
+    {
+        if(!isInline())
+            delete [] heapWords;
+    }
+
+    void takeWordsFrom(LargeIntegerWords &other)
+    {
+        wordCount = other.wordCount;
+        capacity = other.capacity;
+        if(other.isInline())
+            std::copy(other.inlineWords, other.inlineWords + other.wordCount, inlineWords);
+        else
+            heapWords = other.heapWords;
+
+        other.wordCount = 0;
+        other.capacity = InlineCapacity;
+    }
+
+    static Statistics statistics;
+
+    uint32_t wordCount = 0;
+    uint32_t capacity = InlineCapacity;
+    union
+    {
+        Word inlineWords[InlineCapacity];
+        Word *heapWords;
+    };
+};
+
 /**
  * I represent a large integer value.
  */
 struct LargeInteger
 {
+    typedef LargeIntegerWords::Word Word;
+    static constexpr uint32_t WordBits = 64;
+
     bool signBit = 0;
-    std::vector<uint32_t> words;
+    LargeIntegerWords words;
 
     static const LargeInteger Zero;
     static const LargeInteger One;
@@ -42,8 +253,8 @@ struct LargeInteger
     explicit LargeInteger(uint64_t value);
     explicit LargeInteger(int64_t value);
     explicit LargeInteger(size_t value);
-    explicit LargeInteger(bool isNegative, std::vector<uint32_t> &&newWords);
-    explicit LargeInteger(bool isNegative, const std::vector<uint32_t> &newWords);
+    explicit LargeInteger(bool isNegative, LargeIntegerWords &&newWords);
+    explicit LargeInteger(bool isNegative, const LargeIntegerWords &newWords);
     explicit LargeInteger(const std::string &string, uint8_t radix = 10);
 
     void setValue(uint32_t value);
@@ -54,22 +265,30 @@ struct LargeInteger
     void setValueByParsingFrom(const std::string &string, uint8_t radix = 10);
 
     template<size_t N>
-    void setUnnormalizedWords(const uint32_t (&words)[N])
+    void setUnnormalizedWords(const Word (&words)[N])
     {
         setUnnormalizedWords(words, N);
     }
 
-    void setUnnormalizedWords(const std::vector<uint32_t> &newWords);
-    void setUnnormalizedWords(const uint32_t newWords[], size_t wordCount);
+    void setUnnormalizedWords(const LargeIntegerWords &newWords);
+    void setUnnormalizedWords(const Word newWords[], size_t wordCount);
     int32_t compareWith(const LargeInteger &other) const;
 
-    uint32_t wordAt(size_t index) const
+    Word wordAt(size_t index) const
     {
         if(index < words.size())
             return words[index];
         return 0;
     }
 
+    // The magnitude is measured in 32-bit units, so that the binary contents do not depend on the word size.
+    size_t magnitudeByteSize() const
+    {
+        if(words.empty())
+            return 0;
+        return words.size()*sizeof(Word) - ((words.back() >> 32) == 0 ? 4 : 0);
+    }
+
     int sign() const
     {
         if(words.empty())
@@ -125,6 +344,7 @@ struct LargeInteger
 
     LargeInteger operator*(const LargeInteger &other) const;
     LargeInteger &operator*=(const LargeInteger &other);
+    LargeInteger squared() const;
 
     LargeInteger operator/(const LargeInteger &divisor) const;
     LargeInteger &operator/=(const LargeInteger &divisor);
@@ -181,7 +401,7 @@ struct LargeInteger
 
     operator uint64_t() const
     {
-        auto result = uint64_t(wordAt(0)) | (uint64_t(wordAt(1)) << 32);
+        auto result = wordAt(0);
         return signBit ? -result : result;
     }
 
@@ -202,7 +422,7 @@ struct LargeInteger
 
     operator int64_t() const
     {
-        auto result = int64_t(wordAt(0)) | (int64_t(wordAt(1)) << 32);
+        auto result = int64_t(wordAt(0));
         return signBit ? -result : result;
     }
 
@@ -232,6 +452,13 @@ struct LargeInteger
     }
 
     static LargeInteger gcd(const LargeInteger &a, const LargeInteger &b);
+    static LargeInteger lcm(const LargeInteger &a, const LargeInteger &b);
+
+    // I return the gcd, and the cofactors that satisfy a*aCofactor + b*bCofactor = gcd.
+    static LargeInteger extendedGcd(const LargeInteger &a, const LargeInteger &b, LargeInteger &aCofactor, LargeInteger &bCofactor);
+
+    // I return the inverse in [0, |modulus|), and throw when I share a factor with the modulus.
+    LargeInteger modularInverse(const LargeInteger &modulus) const;
 
     friend std::ostream &operator<<(std::ostream &out, const LargeInteger &integer)
     {
@@ -3,20 +3,38 @@
 #include "Syntax.hpp"
 #include "Module.hpp"
 #include "Utilities.hpp"
+#include "Bytecode.hpp"
+#include "MethodLookupCache.hpp"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
 
 using namespace Sysmel;
 
 ModulePtr currentModule;
+bool printSyntaxArenaStatistics = false;
+bool printStageTimes = false;
+size_t parserThreadCount = 1;
+size_t checkedEditCount = 0;
 
 void printHelp()
 {
     printf(
 "bootstrap-interpreter\n"
-"-ep        Evaluate and Print Result.\n");
+"-ep        Evaluate and Print Result.\n"
+"-engine    Select the evaluation engine: bytecode (default) or tree.\n"
+"-stats     Print the message send, method lookup cache, garbage collector, large integer and allocation statistics at exit.\n"
+"-arena-stats Print the syntax arena high-water mark of each source.\n"
+"-j N       Read, scan and parse the input files on N threads. They are still evaluated in order.\n"
+"-times     Print the time that each input file spends on every stage.\n"
+"-check-edits N Apply N random edits to each input file with the incremental parser, and compare it with a full parse after each one.\n");
 }
 
 void printVersion()
@@ -24,14 +42,16 @@ void printVersion()
     printf("bootstrap-interpreter version 0.1");
 }
 
-void dumpTokens(const std::vector<TokenPtr> &tokens)
+void dumpTokens(const ScannedSourceCode &scannedSourceCode)
 {
-    for(auto token : tokens)
+    for(size_t i = 0; i < scannedSourceCode.tokens.size(); ++i)
     {
-        if(token->errorMessage.empty())
-            printf("%s\n", getTokenKindName(token->kind));
+        auto &token = scannedSourceCode.tokens[i];
+        auto &errorMessage = scannedSourceCode.getErrorMessage(i);
+        if(errorMessage.empty())
+            printf("%s\n", getTokenKindName(token.kind));
         else
-            printf("%s: %s\n", getTokenKindName(token->kind), token->errorMessage.c_str());
+            printf("%s: %s\n", getTokenKindName(token.kind), errorMessage.c_str());
     }
 }
 
@@ -47,23 +67,35 @@ bool checkSyntaxErrors(ValuePtr parseTree)
     for(auto &parseError : parseErrors)
     {
         auto position = parseError->sourcePosition;
+        size_t startLine, startColumn, endLine, endColumn;
+        position->computeStartLineAndColumn(startLine, startColumn);
+        position->computeEndLineAndColumn(endLine, endColumn);
         fprintf(stderr, "%s:%ld.%ld-%ld.%ld: %s\n",
             position->sourceCode->name.c_str(),
-            position->startLine, position->startColumn,
-            position->endLine, position->endColumn,
+            startLine, startColumn,
+            endLine, endColumn,
             parseError->errorMessage.c_str());
     }
     return !parseErrors.empty();
 }
 
-ValuePtr evaluateSourceCode(const SourceCodePtr &sourceCode)
+ValuePtr parseSourceCode(const SourceCodePtr &sourceCode, size_t &syntaxErrorCount)
 {
-    auto tokens = scanSourceCode(sourceCode);
-    //dumpTokens(tokens);
-    
-    auto parseTree = parseTokens(sourceCode, tokens);
+    auto scannedSourceCode = scanSourceCode(sourceCode);
+    //dumpTokens(scannedSourceCode);
+
+    auto parseTree = parseTokens(scannedSourceCode, syntaxErrorCount);
     //dumpParseTree(parseTree);
-    if(checkSyntaxErrors(parseTree))
+    return parseTree;
+}
+
+ValuePtr evaluateParseTree(const SourceCodePtr &sourceCode, const ValuePtr &parseTree, size_t syntaxErrorCount)
+{
+    if(printSyntaxArenaStatistics)
+        sourceCode->syntaxArena->printStatisticsOn(stderr, sourceCode->name.c_str());
+
+    // The tree is only searched for the errors when the parser has made some.
+    if(syntaxErrorCount > 0 && checkSyntaxErrors(parseTree))
         return nullptr;
 
     auto lexicalEnvironment = currentModule->newLexicalEnvironment(parseTree->getSourcePosition());
@@ -71,6 +103,13 @@ ValuePtr evaluateSourceCode(const SourceCodePtr &sourceCode)
     return result;
 }
 
+ValuePtr evaluateSourceCode(const SourceCodePtr &sourceCode)
+{
+    size_t syntaxErrorCount = 0;
+    auto parseTree = parseSourceCode(sourceCode, syntaxErrorCount);
+    return evaluateParseTree(sourceCode, parseTree, syntaxErrorCount);
+}
+
 bool evaluateAndPrintSourceCode(const SourceCodePtr &sourceCode)
 {
     auto evaluationResult = evaluateSourceCode(sourceCode);
@@ -83,37 +122,288 @@ bool evaluateAndPrintSourceCode(const SourceCodePtr &sourceCode)
 
 bool evaluateAndPrintString(const std::string &sourceText)
 {
-    auto sourceCode = std::make_shared<SourceCode> ();
+    auto sourceCode = makeRef<SourceCode> ();
     sourceCode->directory = "";
     sourceCode->name = "<cli>";
     sourceCode->language = "sysmel";
-    sourceCode->text = sourceText;
+    sourceCode->setText(sourceText);
 
     return evaluateAndPrintSourceCode(sourceCode);
 }
 
-bool evaluateInputFile(const std::string fileName)
+double elapsedMilliseconds()
+{
+    static auto startTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * An input file that is read, scanned and parsed ahead of its evaluation, possibly by a worker thread.
+ */
+struct ParsedInputFile
+{
+    std::string fileName;
+    SourceCodePtr sourceCode;
+    ValuePtr parseTree;
+    size_t syntaxErrorCount = 0;
+    bool hasOpenedFile = false;
+
+    size_t threadIndex = 0;
+    double parseStartTime = 0;
+    double readTime = 0;
+    double scanTime = 0;
+    double parseTime = 0;
+
+    // The values that were created by a worker thread, until the evaluation adopts them.
+    GarbageCollector::ThreadValues threadValues;
+};
+
+void readScanAndParseInputFile(ParsedInputFile &inputFile)
 {
-    auto dirAndBasename = splitPath(fileName);
-    auto sourceText = readWholeTextFile(fileName);
+    inputFile.parseStartTime = elapsedMilliseconds();
+    auto dirAndBasename = splitPath(inputFile.fileName);
 
-    auto sourceCode = std::make_shared<SourceCode> ();
+    auto sourceCode = makeRef<SourceCode> ();
     sourceCode->directory = dirAndBasename.first;
     sourceCode->name = dirAndBasename.second;
     sourceCode->language = "sysmel";
-    sourceCode->text = sourceText;
+    inputFile.hasOpenedFile = sourceCode->loadTextFromFile(inputFile.fileName);
+    auto scanStartTime = elapsedMilliseconds();
+
+    auto scannedSourceCode = scanSourceCode(sourceCode);
+    auto parseStartTime = elapsedMilliseconds();
+
+    inputFile.parseTree = parseTokens(scannedSourceCode, inputFile.syntaxErrorCount);
+    inputFile.sourceCode = sourceCode;
+    auto parseEndTime = elapsedMilliseconds();
+
+    inputFile.readTime = scanStartTime - inputFile.parseStartTime;
+    inputFile.scanTime = parseStartTime - scanStartTime;
+    inputFile.parseTime = parseEndTime - parseStartTime;
+}
+
+bool evaluateParsedInputFile(ParsedInputFile &inputFile)
+{
+    if(!inputFile.hasOpenedFile)
+        fprintf(stderr, "Failed to open input file '%s'\n", inputFile.fileName.c_str());
+
+    auto evaluationStartTime = elapsedMilliseconds();
+    auto result = evaluateParseTree(inputFile.sourceCode, inputFile.parseTree, inputFile.syntaxErrorCount);
+    auto evaluationEndTime = elapsedMilliseconds();
+
+    if(printStageTimes)
+    {
+        fprintf(stderr, "%s: read %.3f ms, scan %.3f ms, parse %.3f ms on thread %zu at %.3f ms; evaluation %.3f ms at %.3f ms\n",
+            inputFile.fileName.c_str(),
+            inputFile.readTime, inputFile.scanTime, inputFile.parseTime,
+            inputFile.threadIndex, inputFile.parseStartTime,
+            evaluationEndTime - evaluationStartTime, evaluationStartTime);
+    }
 
-    auto result = evaluateSourceCode(sourceCode);
     return result != nullptr;
 }
 
+/**
+ * I read, scan and parse the input files on worker threads, and I hand them over
+ * in command-line order. These stages only depend on the source code of each file,
+ * so they overlap with the evaluation of the files that come before.
+ */
+class InputFileParserPool
+{
+public:
+    InputFileParserPool(const std::vector<std::string> &fileNames, size_t threadCount)
+        : inputFiles(fileNames.size()), readyInputFiles(fileNames.size())
+    {
+        for(size_t i = 0; i < fileNames.size(); ++i)
+            inputFiles[i].fileName = fileNames[i];
+
+        for(size_t i = 0; i < threadCount; ++i)
+            workers.emplace_back([this, i] { parseInputFiles(i + 1); });
+    }
+
+    ~InputFileParserPool()
+    {
+        for(auto &worker : workers)
+            worker.join();
+
+        // Adopt the values of the files that were not evaluated, so that they can be released.
+        for(auto &inputFile : inputFiles)
+            GarbageCollector::adoptThreadValues(inputFile.threadValues);
+    }
+
+    ParsedInputFile &waitForInputFile(size_t index)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            inputFileReadyCondition.wait(lock, [&] { return bool(readyInputFiles[index]); });
+        }
+
+        auto &inputFile = inputFiles[index];
+        GarbageCollector::adoptThreadValues(inputFile.threadValues);
+        return inputFile;
+    }
+
+private:
+    void parseInputFiles(size_t threadIndex)
+    {
+        for(;;)
+        {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if(nextInputFileIndex >= inputFiles.size())
+                    return;
+                index = nextInputFileIndex++;
+            }
+
+            auto &inputFile = inputFiles[index];
+            inputFile.threadIndex = threadIndex;
+            readScanAndParseInputFile(inputFile);
+            inputFile.threadValues = GarbageCollector::detachThreadValues();
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                readyInputFiles[index] = true;
+            }
+            inputFileReadyCondition.notify_all();
+        }
+    }
+
+    std::vector<ParsedInputFile> inputFiles;
+    std::vector<bool> readyInputFiles;
+    size_t nextInputFileIndex = 0;
+    std::mutex mutex;
+    std::condition_variable inputFileReadyCondition;
+    std::vector<std::thread> workers;
+};
+
+bool evaluateInputFiles(const std::vector<std::string> &inputFileNames)
+{
+    bool success = true;
+    if(parserThreadCount <= 1 || inputFileNames.size() <= 1)
+    {
+        for(auto &inputFileName : inputFileNames)
+        {
+            ParsedInputFile inputFile;
+            inputFile.fileName = inputFileName;
+            readScanAndParseInputFile(inputFile);
+            if(!evaluateParsedInputFile(inputFile))
+                success = false;
+        }
+
+        return success;
+    }
+
+    InputFileParserPool parserPool(inputFileNames, std::min(parserThreadCount, inputFileNames.size()));
+    for(size_t i = 0; i < inputFileNames.size(); ++i)
+    {
+        auto &inputFile = parserPool.waitForInputFile(i);
+        if(!evaluateParsedInputFile(inputFile))
+            success = false;
+
+        inputFile.sourceCode.reset();
+        inputFile.parseTree.reset();
+    }
+
+    return success;
+}
+
+// The tree is compared with its source positions, which must have been moved by the edits.
+std::string describeParseTreeForComparison(const ValuePtr &parseTree)
+{
+    auto description = parseTree->printString();
+    auto describeSourcePosition = [&](Value *node) {
+        auto &position = node->sourcePosition;
+        if(!position)
+        {
+            description += " -";
+            return;
+        }
+
+        position->synchronizeWithSourceCode();
+        description += " " + std::to_string(position->startIndex) + ":" + std::to_string(position->endIndex);
+    };
+    describeSourcePosition(parseTree.get());
+    parseTree->traverseChildren(describeSourcePosition);
+    return description;
+}
+
+bool checkIncrementalParserEdits(const std::string &fileName, size_t editCount)
+{
+    auto sourceCode = makeRef<SourceCode> ();
+    sourceCode->name = fileName;
+    sourceCode->language = "sysmel";
+    if(!sourceCode->loadTextFromFile(fileName))
+    {
+        fprintf(stderr, "Failed to open input file '%s'\n", fileName.c_str());
+        return false;
+    }
+
+    // The inserted pieces open and close the delimiters, comments, strings and the other constructs
+    // whose tokens and expressions extend beyond the edit.
+    static const char *insertedPieces[] = {
+        "(", ")", "{", "}", "[", "]", ".", ";", ":", ":=", " ", "\n", "a", "foo", "1", "2r101", "\"", "'",
+        "#", "#(", "#[", "#{", "+", "- ", "if:", " then: ", "##c\n", "#*x*#", "\\", "$a", "12.5", "x: ", "| ", ":!"
+    };
+    static constexpr size_t insertedPieceCount = sizeof(insertedPieces) / sizeof(insertedPieces[0]);
+
+    std::mt19937 randomNumbers{uint32_t(editCount)};
+    IncrementalParser parser(sourceCode);
+    size_t rescannedTokenCount = 0;
+    size_t reparsedExpressionCount = 0;
+    for(size_t i = 0; i < editCount; ++i)
+    {
+        auto textSize = sourceCode->text.size();
+        auto startIndex = randomNumbers() % (textSize + 1);
+        auto endIndex = std::min(textSize, startIndex + (randomNumbers() % 3 == 0 ? randomNumbers() % 8 : 0));
+        std::string replacement = randomNumbers() % 4 == 0 ? "" : insertedPieces[randomNumbers() % insertedPieceCount];
+        auto parseTree = parser.applyEdit(startIndex, endIndex, replacement);
+        rescannedTokenCount += parser.getLastRescannedTokenCount();
+        reparsedExpressionCount += parser.getLastReparsedExpressionCount();
+
+        auto fullSourceCode = makeRef<SourceCode> ();
+        fullSourceCode->name = fileName;
+        fullSourceCode->setText(std::string(sourceCode->text));
+        auto fullScannedSourceCode = scanSourceCode(fullSourceCode);
+        size_t fullSyntaxErrorCount = 0;
+        auto fullParseTree = parseTokens(fullScannedSourceCode, fullSyntaxErrorCount);
+
+        auto &tokens = parser.getScannedSourceCode().tokens;
+        auto &fullTokens = fullScannedSourceCode.tokens;
+        auto sameTokens = tokens.size() == fullTokens.size();
+        for(size_t j = 0; sameTokens && j < tokens.size(); ++j)
+        {
+            sameTokens = tokens[j].kind == fullTokens[j].kind &&
+                tokens[j].startIndex == fullTokens[j].startIndex &&
+                tokens[j].endIndex == fullTokens[j].endIndex &&
+                parser.getScannedSourceCode().getErrorMessage(j) == fullScannedSourceCode.getErrorMessage(j);
+        }
+
+        auto sameParseTree = describeParseTreeForComparison(parseTree) == describeParseTreeForComparison(fullParseTree);
+        auto sameSyntaxErrors = parser.getSyntaxErrorCount() == fullSyntaxErrorCount;
+        if(!sameTokens || !sameParseTree || !sameSyntaxErrors)
+        {
+            fprintf(stderr, "%s: edit %zu, which replaces %zu-%zu with \"%s\", differs from a full parse in its %s.\n",
+                fileName.c_str(), i, startIndex, endIndex, replacement.c_str(),
+                !sameTokens ? "tokens" : !sameParseTree ? "parse tree" : "syntax errors");
+            return false;
+        }
+    }
+
+    printf("%s: %zu edits, %zu rescanned tokens, %zu reparsed expressions, %zu retained source edits\n",
+        fileName.c_str(), editCount, rescannedTokenCount, reparsedExpressionCount, sourceCode->getRetainedEditCount());
+    return true;
+}
+
 int main(int argc, const char **argv)
 {
     std::vector<std::string> inputFileNames;
 
-    currentModule = std::make_shared<Module> ();
+    currentModule = makeRef<Module> ();
     currentModule->initializeWithName("cli");
     int exitCode = 0;
+    bool printStatistics = false;
+    elapsedMilliseconds();
 
     for(int i = 1; i < argc; ++i)
     {
@@ -130,6 +420,48 @@ int main(int argc, const char **argv)
                 printVersion();
                 return 0;
             }
+            else if(!strcmp(argument, "-engine") && i + 1 < argc)
+            {
+                EvaluationEngine engine;
+                if(!parseEvaluationEngineName(argv[++i], engine))
+                {
+                    fprintf(stderr, "Unknown evaluation engine %s\n", argv[i]);
+                    return 1;
+                }
+                setEvaluationEngine(engine);
+            }
+            else if(!strcmp(argument, "-stats"))
+            {
+                printStatistics = true;
+            }
+            else if(!strcmp(argument, "-arena-stats"))
+            {
+                printSyntaxArenaStatistics = true;
+            }
+            else if(!strcmp(argument, "-times"))
+            {
+                printStageTimes = true;
+            }
+            else if(!strcmp(argument, "-j") && i + 1 < argc)
+            {
+                auto threadCount = atoi(argv[++i]);
+                if(threadCount < 1)
+                {
+                    fprintf(stderr, "Invalid thread count %s\n", argv[i]);
+                    return 1;
+                }
+                parserThreadCount = size_t(threadCount);
+            }
+            else if(!strcmp(argument, "-check-edits") && i + 1 < argc)
+            {
+                auto editCount = atoi(argv[++i]);
+                if(editCount < 1)
+                {
+                    fprintf(stderr, "Invalid edit count %s\n", argv[i]);
+                    return 1;
+                }
+                checkedEditCount = size_t(editCount);
+            }
             else if(!strcmp(argument, "-ep") && i + 1 < argc)
             {
                 if(!evaluateAndPrintString(argv[++i]))
@@ -142,10 +474,26 @@ int main(int argc, const char **argv)
         }
     }
 
-    for(auto &inputFileName : inputFileNames)
+    if(checkedEditCount > 0)
+    {
+        for(auto &inputFileName : inputFileNames)
+        {
+            if(!checkIncrementalParserEdits(inputFileName, checkedEditCount))
+                exitCode = 1;
+        }
+    }
+    else if(!evaluateInputFiles(inputFileNames))
+    {
+        exitCode = 1;
+    }
+
+    if(printStatistics)
     {
-        if(!evaluateInputFile(inputFileName))
-            exitCode = 1;
+        InlineCache::getStatistics().printOn(stderr);
+        MethodLookupCache::getStatistics().printOn(stderr);
+        GarbageCollector::getStatistics().printOn(stderr);
+        LargeIntegerWords::getStatistics().printOn(stderr);
+        fprintf(stderr, "Allocated values: %zu\n", Value::getAllocatedInstanceCount());
     }
 
     return exitCode;
@@ -0,0 +1,67 @@
+#include "MethodLookupCache.hpp"
+#include <inttypes.h>
+
+namespace Sysmel
+{
+
+MethodLookupCache::Entry MethodLookupCache::entries[MethodLookupCache::EntryCount];
+MethodLookupCache::Statistics MethodLookupCache::statistics;
+
+void MethodLookupCache::Statistics::printOn(FILE *out) const
+{
+    fprintf(out, "Method lookup cache hits: %" PRIu64 "\n", hits);
+    fprintf(out, "Method lookup cache misses: %" PRIu64 "\n", misses);
+    fprintf(out, "Method lookup cache flushed entries: %" PRIu64 "\n", flushedEntries);
+}
+
+ValuePtr MethodLookupCache::lookup(const Value *behavior, const ValuePtr &selector)
+{
+    auto &entry = entries[entryIndexFor(behavior, selector.get())];
+    if(entry.behavior.get() == behavior && entry.selector == selector)
+    {
+        ++statistics.hits;
+        return entry.method;
+    }
+
+    ++statistics.misses;
+    return nullptr;
+}
+
+void MethodLookupCache::store(const ValuePtr &behavior, const ValuePtr &selector, const ValuePtr &method)
+{
+    auto &entry = entries[entryIndexFor(behavior.get(), selector.get())];
+    entry.behavior = behavior;
+    entry.selector = selector;
+    entry.method = method;
+}
+
+void MethodLookupCache::flushSelector(const ValuePtr &selector)
+{
+    for(auto &entry : entries)
+    {
+        if(entry.selector == selector)
+        {
+            entry = Entry{};
+            ++statistics.flushedEntries;
+        }
+    }
+}
+
+void MethodLookupCache::flushAll()
+{
+    for(auto &entry : entries)
+    {
+        if(entry.selector)
+        {
+            entry = Entry{};
+            ++statistics.flushedEntries;
+        }
+    }
+}
+
+MethodLookupCache::Statistics &MethodLookupCache::getStatistics()
+{
+    return statistics;
+}
+
+} // End of namespace Sysmel
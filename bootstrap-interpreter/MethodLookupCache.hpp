@@ -0,0 +1,60 @@
+#ifndef SYSMEL_METHOD_LOOKUP_CACHE_HPP
+#define SYSMEL_METHOD_LOOKUP_CACHE_HPP
+
+#pragma once
+
+#include "Value.hpp"
+#include <stdint.h>
+#include <stdio.h>
+
+namespace Sysmel
+{
+
+/**
+ * I am the process wide method lookup cache. I map (behavior, selector) pairs into the method found by a full lookup.
+ * I am direct mapped, so a colliding pair just replaces the previous entry.
+ */
+class MethodLookupCache
+{
+public:
+    static constexpr size_t EntryCount = 1024;
+
+    struct Statistics
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t flushedEntries = 0;
+
+        void printOn(FILE *out) const;
+    };
+
+    static ValuePtr lookup(const Value *behavior, const ValuePtr &selector);
+    static void store(const ValuePtr &behavior, const ValuePtr &selector, const ValuePtr &method);
+
+    // Inherited methods are cached under each subclass, so a change must flush the selector for every behavior.
+    static void flushSelector(const ValuePtr &selector);
+    static void flushAll();
+
+    static Statistics &getStatistics();
+
+private:
+    struct Entry
+    {
+        ValuePtr behavior;
+        ValuePtr selector;
+        ValuePtr method;
+    };
+
+    static size_t entryIndexFor(const Value *behavior, const Value *selector)
+    {
+        auto hash = (uintptr_t(behavior) >> 4) * 31 + (uintptr_t(selector) >> 4);
+        return (hash ^ (hash >> 10)) & (EntryCount - 1);
+    }
+
+    static Entry entries[EntryCount];
+    static Statistics statistics;
+};
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_METHOD_LOOKUP_CACHE_HPP
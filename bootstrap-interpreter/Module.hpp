@@ -7,7 +7,7 @@
 
 namespace Sysmel
 {
-typedef std::shared_ptr<class Module> ModulePtr;
+typedef Ref<class Module> ModulePtr;
 
 class Module : public Object
 {
@@ -15,16 +15,24 @@ public:
     void initializeWithName(const std::string &newName)
     {
         name = newName;
-        globalNamespace = std::make_shared<Namespace> ();
+        globalNamespace = makeRef<Namespace> ();
 
         auto intrinsics = IntrinsicsEnvironment::uniqueInstance();
-        moduleEnvironment = std::make_shared<ModuleEnvironment> (std::static_pointer_cast<Module> (shared_from_this()), intrinsics);
-        globalNamespaceEnvironment = std::make_shared<NamespaceEnvironment> (globalNamespace, moduleEnvironment);
+        moduleEnvironment = makeRef<ModuleEnvironment> (staticRefCast<Module> (selfRef()), intrinsics);
+        globalNamespaceEnvironment = makeRef<NamespaceEnvironment> (globalNamespace, moduleEnvironment);
     }
 
     LexicalEnvironmentPtr newLexicalEnvironment(const SourcePositionPtr &position)
     {
-        return std::make_shared<LexicalEnvironment> (globalNamespaceEnvironment, position);
+        return makeRef<LexicalEnvironment> (globalNamespaceEnvironment, position);
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(globalNamespace);
+        visitor.visit(moduleEnvironment);
+        visitor.visit(globalNamespaceEnvironment);
     }
 
     std::string name;
@@ -7,7 +7,7 @@
 
 namespace Sysmel
 {
-typedef std::shared_ptr<class Namespace> NamespacePtr;
+typedef Ref<class Namespace> NamespacePtr;
 
 class Namespace : public Object
 {
@@ -12,10 +12,17 @@ ValuePtr ProtoObject::getClass() const
     return clazz;
 }
 
+void Behavior::addMethodWithSelector(const SymbolPtr &selector, const ValuePtr &method)
+{
+    methodDict[selector] = method;
+    MethodLookupCache::flushSelector(selector);
+    InlineCache::invalidateAll();
+}
+
 UndefinedObjectPtr UndefinedObject::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<UndefinedObject> ();
+        singleton = makeRef<UndefinedObject> ();
     return singleton;
 }
 
@@ -32,7 +39,7 @@ ValuePtr Boolean::encode(bool value)
 TruePtr True::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<True> ();
+        singleton = makeRef<True> ();
     return singleton;
 }
 
@@ -41,19 +48,115 @@ TruePtr True::singleton;
 FalsePtr False::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<False> ();
+        singleton = makeRef<False> ();
     return singleton;
 }
 
 FalsePtr False::singleton;
 
+static const ValuePtr &getIntegerClass()
+{
+    static ValuePtr integerClass = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Integer");
+    return integerClass;
+}
+
+static bool largeIntegerFitsInSmallInteger(const LargeInteger &value, int64_t &result)
+{
+    if(value.words.size() > 1)
+        return false;
+
+    auto magnitude = uint64_t(value.wordAt(0));
+    if(value.isNegative())
+    {
+        if(magnitude > (uint64_t(1) << 63))
+            return false;
+        result = int64_t(uint64_t(0) - magnitude);
+    }
+    else
+    {
+        if(magnitude >= (uint64_t(1) << 63))
+            return false;
+        result = int64_t(magnitude);
+    }
+
+    return true;
+}
+
+IntegerPtr Integer::make(int64_t value)
+{
+    // Small values are shared, so counters and indices do not allocate.
+    static IntegerPtr smallInstances[SmallInstanceCacheMaximum - SmallInstanceCacheMinimum + 1];
+    if(SmallInstanceCacheMinimum <= value && value <= SmallInstanceCacheMaximum)
+    {
+        auto &instance = smallInstances[value - SmallInstanceCacheMinimum];
+        if(!instance)
+        {
+            instance = makeRef<Integer> ();
+            instance->clazz = getIntegerClass();
+            instance->smallValue = value;
+        }
+        return instance;
+    }
+
+    auto result = makeRef<Integer> ();
+    result->clazz = getIntegerClass();
+    result->smallValue = value;
+    return result;
+}
+
+IntegerPtr Integer::make(const LargeInteger &value)
+{
+    int64_t smallValue;
+    if(largeIntegerFitsInSmallInteger(value, smallValue))
+        return make(smallValue);
+
+    auto result = makeRef<Integer> ();
+    result->clazz = getIntegerClass();
+    result->isSmallInteger = false;
+    result->largeValue = value;
+    return result;
+}
+
+IntegerPtr Integer::make(LargeInteger &&value)
+{
+    int64_t smallValue;
+    if(largeIntegerFitsInSmallInteger(value, smallValue))
+        return make(smallValue);
+
+    auto result = makeRef<Integer> ();
+    result->clazz = getIntegerClass();
+    result->isSmallInteger = false;
+    result->largeValue = std::move(value);
+    return result;
+}
+
+const LargeInteger &Integer::asLargeInteger() const
+{
+    // Zero is also the empty large integer, so it never needs to be materialized.
+    if(isSmallInteger && smallValue != 0 && largeValue.words.empty())
+        largeValue.setValue(smallValue);
+    return largeValue;
+}
+
+double Integer::asDouble() const
+{
+    return isSmallInteger ? double(smallValue) : largeValue.asDouble();
+}
+
+int32_t Integer::compareWith(const Integer &other) const
+{
+    if(isSmallInteger && other.isSmallInteger)
+        return smallValue < other.smallValue ? -1 : (smallValue == other.smallValue ? 0 : 1);
+    return asLargeInteger().compareWith(other.asLargeInteger());
+}
+
 SymbolPtr Symbol::internString(const std::string &string)
 {
     auto it = internedSymbols.find(string);
     if (it != internedSymbols.end())
         return it->second;
 
-    auto newSymbol = std::make_shared<Symbol> ();
+    auto newSymbol = makeRef<Symbol> ();
     newSymbol->clazz = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Symbol");
     newSymbol->value = string;
     internedSymbols.insert(std::make_pair(string, newSymbol));
@@ -81,7 +184,7 @@ BinaryFileStreamPtr Stdio::getValidStdinStream()
 {
     if (!stdinStream)
     {
-        stdinStream = std::make_shared<BinaryFileStream> ();
+        stdinStream = makeRef<BinaryFileStream> ();
         stdinStream->file = stdin;
         stdinStream->ownsFile = false;
     }
@@ -92,7 +195,7 @@ BinaryFileStreamPtr Stdio::getValidStdoutStream()
 {
     if (!stdoutStream)
     {
-        stdoutStream = std::make_shared<BinaryFileStream> ();
+        stdoutStream = makeRef<BinaryFileStream> ();
         stdoutStream->file = stdout;
         stdoutStream->ownsFile = false;
     }
@@ -103,7 +206,7 @@ BinaryFileStreamPtr Stdio::getValidStderrStream()
 {
     if (!stderrStream)
     {
-        stderrStream = std::make_shared<BinaryFileStream> ();
+        stderrStream = makeRef<BinaryFileStream> ();
         stderrStream->file = stderr;
         stderrStream->ownsFile = false;
     }
@@ -3,6 +3,8 @@
 
 #include "Value.hpp"
 #include "LargeInteger.hpp"
+#include "InlineCache.hpp"
+#include "MethodLookupCache.hpp"
 #include "stdio.h"
 #include <map>
 #include <functional>
@@ -10,19 +12,21 @@
 namespace Sysmel
 {
 
-typedef std::shared_ptr<class ProtoObject> ProtoObjectPtr;
-typedef std::shared_ptr<class Object> ObjectPtr;
-typedef std::shared_ptr<class UndefinedObject> UndefinedObjectPtr;
-typedef std::shared_ptr<class True> TruePtr;
-typedef std::shared_ptr<class False> FalsePtr;
-typedef std::shared_ptr<class Class> ClassPtr;
-typedef std::shared_ptr<class Metaclass> MetaclassPtr;
-typedef std::shared_ptr<class Symbol> SymbolPtr;
-typedef std::shared_ptr<class BinaryStream> BinaryStreamPtr;
-typedef std::shared_ptr<class BinaryFileStream> BinaryFileStreamPtr;
-typedef std::shared_ptr<class MacroContext> MacroContextPtr;
-typedef std::shared_ptr<class Array> ArrayPtr;
-typedef std::shared_ptr<class OrderedCollection> OrderedCollectionPtr;
+typedef Ref<class ProtoObject> ProtoObjectPtr;
+typedef Ref<class Object> ObjectPtr;
+typedef Ref<class UndefinedObject> UndefinedObjectPtr;
+typedef Ref<class True> TruePtr;
+typedef Ref<class False> FalsePtr;
+typedef Ref<class Class> ClassPtr;
+typedef Ref<class Metaclass> MetaclassPtr;
+typedef Ref<class Symbol> SymbolPtr;
+typedef Ref<class Integer> IntegerPtr;
+typedef Ref<class PrimitiveMethod> PrimitiveMethodPtr;
+typedef Ref<class BinaryStream> BinaryStreamPtr;
+typedef Ref<class BinaryFileStream> BinaryFileStreamPtr;
+typedef Ref<class MacroContext> MacroContextPtr;
+typedef Ref<class Array> ArrayPtr;
+typedef Ref<class OrderedCollection> OrderedCollectionPtr;
 typedef std::function<ValuePtr(const std::vector<ValuePtr> &arguments)> PrimitiveImplementationSignature;
 typedef std::function<ValuePtr(const MacroContextPtr &context, const std::vector<ValuePtr> &arguments)> PrimitiveMacroImplementationSignature;
 
@@ -48,7 +52,7 @@ public:
         return getClass();
     }
 
-    virtual ValuePtr asTypeValue() { return shared_from_this(); }
+    virtual ValuePtr asTypeValue() { return selfRef(); }
 
     virtual bool isSatisfiedByType(const ValuePtr &sourceType)
     {
@@ -63,6 +67,12 @@ public:
         return otherClass->isSubclassOf(myClass);
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(clazz);
+    }
+
     mutable ValuePtr clazz;
     size_t identityHash;
 };
@@ -98,7 +108,7 @@ public:
 
     virtual bool isSatisfiedByType(const ValuePtr &sourceType) override
     {
-        auto myClass = shared_from_this();
+        auto myClass = selfRef();
         // TODO: Add gradual check here
         auto otherClass = sourceType->asTypeValue();
         //printf("%s class: %s. sourceType %s\n", myClass->printString().c_str(), printString().c_str(), sourceType->printString().c_str());
@@ -128,30 +138,46 @@ public:
 
     virtual ValuePtr lookupSelector(const ValuePtr &selector) override
     {
-        auto it = methodDict.find(std::static_pointer_cast<Symbol>(selector));
+        auto method = MethodLookupCache::lookup(this, selector);
+        if (method)
+            return method;
+
+        auto it = methodDict.find(staticRefCast<Symbol>(selector));
         if (it != methodDict.end())
-            return it->second;
-        if (superclass)
-            return superclass->lookupSelector(selector);
-        return nullptr;
+            method = it->second;
+        else if (superclass)
+            method = superclass->lookupSelector(selector);
+
+        if (method)
+            MethodLookupCache::store(selfRef(), selector, method);
+        return method;
     }
 
+    void addMethodWithSelector(const SymbolPtr &selector, const ValuePtr &method);
+
     virtual bool isSubclassOf(const ValuePtr &targetSuperclass) override
     {
         //printf("target %s\n", targetSuperclass->printString().c_str());
-        auto currentBehavior = std::static_pointer_cast<Behavior>(shared_from_this());
+        auto currentBehavior = staticRefCast<Behavior>(selfRef());
         while (currentBehavior && !currentBehavior->isNil())
         {
             //printf("cur %s\n", currentBehavior->printString().c_str());
             if (currentBehavior == targetSuperclass)
                 return true;
 
-            currentBehavior = std::static_pointer_cast<Behavior>(currentBehavior->superclass);
+            currentBehavior = staticRefCast<Behavior>(currentBehavior->superclass);
         }
 
         return false;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(superclass);
+        visitor.visit(methodDict);
+    }
+
     ValuePtr superclass;
     std::map<SymbolPtr, ValuePtr> methodDict;
     uint32_t format = 0;
@@ -170,7 +196,7 @@ class Class : public ClassDescription
 public:
     Class()
     {
-        subclasses = std::make_shared<Array> ();
+        subclasses = makeRef<Array> ();
     }
 
     virtual const char *getClassName() const override { return "Class"; }
@@ -183,11 +209,17 @@ public:
     void registerInSuperclass()
     {
         if(superclass)
-            superclass->addSubclass(shared_from_this());
+            superclass->addSubclass(selfRef());
     }
 
     virtual void addSubclass(const ValuePtr &subclass) override;
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        ClassDescription::visitSlots(visitor);
+        visitor.visit(subclasses);
+    }
+
     ArrayPtr subclasses;
     std::string name;
 };
@@ -199,10 +231,9 @@ public:
 
     virtual void printStringOn(std::ostream &out) const override
     {
-        auto clazz = thisClass.lock();
-        if (clazz)
+        if (thisClass)
         {
-            clazz->printStringOn(out);
+            thisClass->printStringOn(out);
             out << " class";
         }
         else
@@ -211,7 +242,7 @@ public:
         }
     }
 
-    ClassWeakPtr thisClass;
+    Class *thisClass = nullptr;
 };
 
 class Boolean : public Object
@@ -264,19 +295,35 @@ public:
         : type(ctype), implementation(cimplementation) {}
 
     virtual const char *getClassName() const override { return "PrimitiveMethod"; }
+    virtual bool isPureFunction() const override { return isPure; }
     virtual ValuePtr applyWithArguments(const std::vector<ValuePtr> &arguments) override;
     virtual ValuePtr getType() const override
     {
         return type;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(type);
+    }
+
     ValuePtr type;
     PrimitiveImplementationSignature implementation;
+
+    // Pure primitives can be evaluated ahead of time when all of their arguments are known.
+    bool isPure = false;
 };
 
 class MacroContext : public Object
 {
 public:
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(environment);
+    }
+
     EnvironmentPtr environment;
 };
 
@@ -296,6 +343,12 @@ public:
         return type;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(type);
+    }
+
     ValuePtr type;
     PrimitiveMacroImplementationSignature implementation;
 };
@@ -335,39 +388,67 @@ public:
     virtual const char *getClassName() const override { return "Number"; }
 };
 
+/**
+ * I am an arbitrary precision integer. Values that fit in a machine word are kept as an immediate small integer,
+ * and only the values that overflow it use a LargeInteger.
+ */
 class Integer : public Number
 {
 public:
+    static constexpr int64_t SmallInstanceCacheMinimum = -128;
+    static constexpr int64_t SmallInstanceCacheMaximum = 1023;
+
+    static IntegerPtr make(int64_t value);
+    static IntegerPtr make(const LargeInteger &value);
+    static IntegerPtr make(LargeInteger &&value);
+
     virtual const char *getClassName() const override { return "Integer"; }
 
     virtual void printStringOn(std::ostream &out) const override
     {
-        out << value;
+        if(isSmallInteger)
+            out << smallValue;
+        else
+            out << largeValue;
     }
 
     virtual std::pair<size_t, const uint8_t *> getBinaryContentsData() const override
     {
-        return std::make_pair(value.words.size() * 4, reinterpret_cast<const uint8_t *>(value.words.data()));
+        auto &value = asLargeInteger();
+        return std::make_pair(value.magnitudeByteSize(), reinterpret_cast<const uint8_t *>(value.words.data()));
     }
 
     virtual uint8_t evaluateAsSingleByte()
     {
-        auto firstWord = value.wordAt(0);
-        if(value.signBit)
-            firstWord = -firstWord;
-
-        return firstWord & 0xFF;
+        return castTo<uint8_t> ();
     }
 
     virtual size_t evaluateAsIndex()
     {
-        size_t index = size_t(value.wordAt(0)) | (size_t(value.wordAt(1)) << 32);
-        if (value.signBit)
+        if(isSmallInteger)
+            return size_t(smallValue);
+
+        size_t index = size_t(largeValue.wordAt(0));
+        if (largeValue.signBit)
             index = -index;
         return index;
     }
 
-    LargeInteger value;
+    template<typename T>
+    T castTo() const
+    {
+        return isSmallInteger ? T(smallValue) : T(largeValue);
+    }
+
+    const LargeInteger &asLargeInteger() const;
+    double asDouble() const;
+    int32_t compareWith(const Integer &other) const;
+
+    bool isSmallInteger = true;
+    int64_t smallValue = 0;
+
+    // For small integers this is only materialized on demand, when mixing with large integer arithmetic.
+    mutable LargeInteger largeValue;
 };
 
 class Float : public Number
@@ -450,15 +531,21 @@ public:
         for(auto &value : values)
         {
             if(value == extraValue)
-                return std::static_pointer_cast<Array> (shared_from_this());
+                return staticRefCast<Array> (selfRef());
         }
 
-        auto result = std::make_shared<Array> ();
+        auto result = makeRef<Array> ();
         result->values = values;
         result->values.push_back(extraValue);
         return result;
     }
     
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        ArrayedCollection::visitSlots(visitor);
+        visitor.visit(values);
+    }
+
     std::vector<ValuePtr> values;
 };
 
@@ -497,9 +584,7 @@ public:
         if(index >= values.size())
             throwExceptionWithMessage("Index is out of bounds.");
         
-        auto integer = std::make_shared<Integer> ();
-        integer->value = LargeInteger(values[index]);
-        return integer;
+        return Integer::make(int64_t(values[index]));
     }
 
     virtual ValuePtr setElementAtIndex(size_t index, const ValuePtr &value) override
@@ -538,7 +623,7 @@ public:
         if(index >= value.size())
             throwExceptionWithMessage("Index is out of bounds.");
         
-        auto character = std::make_shared<Character> ();
+        auto character = makeRef<Character> ();
         character->value = value[index];
         return character;
     }
@@ -548,7 +633,7 @@ public:
         if(index >= value.size())
             throwExceptionWithMessage("Index is out of bounds.");
         value[index] = newValue->evaluateAsSingleByte();
-        return shared_from_this();
+        return selfRef();
     }
 
     std::string value;
@@ -562,7 +647,7 @@ public:
 
     virtual SymbolPtr asAnalyzedSymbolValue() override
     {
-        return std::static_pointer_cast<Symbol>(shared_from_this());
+        return staticRefCast<Symbol>(selfRef());
     }
 
     virtual void printStringOn(std::ostream &out) const override
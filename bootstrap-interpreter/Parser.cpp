@@ -1,15 +1,19 @@
 #include "Parser.hpp"
 #include "Syntax.hpp"
 #include <assert.h>
+#include <algorithm>
+#include <iterator>
 
 namespace Sysmel
 {
 
     struct ParserState
     {
-        SourceCodePtr sourceCode;
-        const std::vector<TokenPtr> *tokens;
+        const ScannedSourceCode *scannedSourceCode;
+        const std::vector<Token> *tokens;
         size_t position = 0;
+        size_t nestingDepth = 0;
+        size_t syntaxErrorCount = 0;
 
         bool atEnd() const
         {
@@ -20,16 +24,16 @@ namespace Sysmel
         {
             auto peekPosition = position + offset;
             if (peekPosition < tokens->size())
-                return tokens->at(peekPosition)->kind;
+                return (*tokens)[peekPosition].kind;
             else
                 return TokenKind::EndOfSource;
         }
 
-        TokenPtr peek(int offset = 0) const
+        const Token *peek(int offset = 0) const
         {
             auto peekPosition = position + offset;
             if (peekPosition < tokens->size())
-                return tokens->at(peekPosition);
+                return &(*tokens)[peekPosition];
             else
                 return nullptr;
         }
@@ -40,27 +44,43 @@ namespace Sysmel
             ++position;
         }
 
-        TokenPtr next()
+        const Token *next()
         {
             assert(position < tokens->size());
-            auto token = tokens->at(position);
+            auto token = &(*tokens)[position];
             ++position;
             return token;
         }
 
+        std::string_view tokenValue(const Token *token) const
+        {
+            return scannedSourceCode->getTokenValue(*token);
+        }
+
+        SourcePositionPtr tokenSourcePosition(const Token *token) const
+        {
+            return scannedSourceCode->makeTokenSourcePosition(*token);
+        }
+
+        SyntaxErrorPtr makeSyntaxError()
+        {
+            ++syntaxErrorCount;
+            return makeRef<SyntaxError>();
+        }
+
         ValuePtr advanceWithExpectedError(const char *message)
         {
             if (peekKind() == TokenKind::Error)
             {
-                auto errorToken = next();
-                auto errorNode = std::make_shared<SyntaxError>();
-                errorNode->sourcePosition = errorToken->position;
-                errorNode->errorMessage = errorToken->errorMessage;
+                auto errorNode = makeSyntaxError();
+                errorNode->errorMessage = scannedSourceCode->getErrorMessage(position);
+                errorNode->sourcePosition = tokenSourcePosition(next());
                 return errorNode;
             }
-            else if (atEnd())
+            else if (atEnd() || peekKind() == TokenKind::EndOfSource)
             {
-                auto errorNode = std::make_shared<SyntaxError>();
+                // The end of the source is not consumed, because the positions of the enclosing nodes start before it.
+                auto errorNode = makeSyntaxError();
                 errorNode->sourcePosition = currentSourcePosition();
                 errorNode->errorMessage = message;
                 return errorNode;
@@ -69,62 +89,84 @@ namespace Sysmel
             {
                 auto errorPosition = currentSourcePosition();
                 advance();
-                auto errorNode = std::make_shared<SyntaxError>();
+                auto errorNode = makeSyntaxError();
                 errorNode->sourcePosition = errorPosition;
                 errorNode->errorMessage = message;
                 return errorNode;
             }
         }
 
-        size_t memento() const
-        {
-            return position;
-        }
-
-        void restore(size_t memento)
-        {
-            position = memento;
-        }
-
         SourcePositionPtr sourcePositionFrom(size_t startingPosition)
         {
             assert(startingPosition < tokens->size());
-            auto startSourcePosition = tokens->at(startingPosition)->position;
+            auto startIndex = (*tokens)[startingPosition].startIndex;
             if (position > 0)
-            {
-                auto endSourcePosition = previousSourcePosition();
-                return startSourcePosition->to(endSourcePosition);
-            }
+                return scannedSourceCode->makeSourcePosition(startIndex, (*tokens)[position - 1].endIndex);
             else
-            {
-                auto endSourcePosition = currentSourcePosition();
-                return startSourcePosition->until(endSourcePosition);
-            }
+                return scannedSourceCode->makeSourcePosition(startIndex, currentToken().startIndex);
         }
 
         SourcePositionPtr previousSourcePosition()
         {
             assert(position > 0);
-            return tokens->at(position - 1)->position;
+            return tokenSourcePosition(&(*tokens)[position - 1]);
         }
 
-        SourcePositionPtr currentSourcePosition()
+        const Token &currentToken() const
         {
             if (position < tokens->size())
-                return tokens->at(position)->position;
+                return (*tokens)[position];
             assert(!tokens->empty());
-            // assert(!tokens->at(tokens->size() - 1)->kind == TokenKind::EndOfSource);
-            return tokens->at(tokens->size() - 1)->position;
+            return tokens->back();
+        }
+
+        SourcePositionPtr currentSourcePosition()
+        {
+            return tokenSourcePosition(&currentToken());
         }
 
         ValuePtr makeErrorAtCurrentSourcePosition(const char *errorMessage)
         {
-            auto node = std::make_shared<SyntaxError>();
+            auto node = makeSyntaxError();
             node->sourcePosition = currentSourcePosition();
             node->errorMessage = errorMessage;
             return node;
         }
 
+        // Skips the rest of the enclosing group, and stops on its closing delimiter or on the end.
+        ValuePtr skipUntilUnmatchedDelimiterWithError(const char *errorMessage)
+        {
+            auto startPosition = position;
+            size_t groupDepth = 0;
+            for (;;)
+            {
+                auto kind = peekKind();
+                if (kind == TokenKind::EndOfSource)
+                    break;
+
+                if (kind == TokenKind::LeftParent || kind == TokenKind::LeftBracket || kind == TokenKind::LeftCurlyBracket ||
+                    kind == TokenKind::ByteArrayStart || kind == TokenKind::DictionaryStart || kind == TokenKind::LiteralArrayStart)
+                {
+                    ++groupDepth;
+                }
+                else if (kind == TokenKind::RightParent || kind == TokenKind::RightBracket || kind == TokenKind::RightCurlyBracket)
+                {
+                    if (groupDepth == 0)
+                        break;
+                    --groupDepth;
+                }
+                advance();
+            }
+
+            if (position == startPosition)
+                return makeErrorAtCurrentSourcePosition(errorMessage);
+
+            auto node = makeSyntaxError();
+            node->sourcePosition = sourcePositionFrom(startPosition);
+            node->errorMessage = errorMessage;
+            return node;
+        }
+
         ValuePtr expectAddingErrorToNode(TokenKind expectedKind, ValuePtr node)
         {
             if (peekKind() == expectedKind)
@@ -134,7 +176,7 @@ namespace Sysmel
             }
 
             auto errorPosition = currentSourcePosition();
-            auto syntaxErrorNode = std::make_shared<SyntaxError>();
+            auto syntaxErrorNode = makeSyntaxError();
             syntaxErrorNode->sourcePosition = errorPosition;
             syntaxErrorNode->innerNode = node;
 
@@ -153,8 +195,29 @@ namespace Sysmel
     ValuePtr parseDictionary(ParserState &state);
     ValuePtr parseExpression(ParserState &state);
 
-    LargeInteger parseIntegerConstant(const std::string &constant)
+    // The parser is predictive, so each token is only visited once, but it recurses on every nested
+    // production. The recursive productions go through me, so that a deeply nested input is reported
+    // instead of exhausting the stack. A nested parenthesis or block takes two levels.
+    static constexpr size_t MaximumNestingDepth = 2000;
+
+    template<typename ParseFunction>
+    ValuePtr parseNested(ParserState &state, const ParseFunction &parseFunction)
+    {
+        if (state.nestingDepth >= MaximumNestingDepth)
+            return state.skipUntilUnmatchedDelimiterWithError("Maximum nesting depth exceeded.");
+
+        ++state.nestingDepth;
+        auto result = parseFunction(state);
+        --state.nestingDepth;
+        return result;
+    }
+
+    LargeInteger parseIntegerConstant(std::string_view constant)
     {
+        // Decimal literals are parsed by halves, which keeps the long ones subquadratic.
+        if (constant.find_first_of("rR") == std::string_view::npos)
+            return LargeInteger(std::string(constant));
+
         LargeInteger result = LargeInteger::Zero;
         LargeInteger radix = LargeInteger::Ten;
         bool hasSeenRadix = false;
@@ -184,9 +247,9 @@ namespace Sysmel
     {
         auto token = state.next();
         assert(token->kind == TokenKind::Nat);
-        auto literal = std::make_shared<SyntaxLiteralInteger>();
-        literal->sourcePosition = token->position;
-        literal->value = parseIntegerConstant(token->getValue());
+        auto literal = makeRef<SyntaxLiteralInteger>();
+        literal->sourcePosition = state.tokenSourcePosition(token);
+        literal->value = parseIntegerConstant(state.tokenValue(token));
         return literal;
     }
 
@@ -194,13 +257,13 @@ namespace Sysmel
     {
         auto token = state.next();
         assert(token->kind == TokenKind::Float);
-        auto literal = std::make_shared<SyntaxLiteralFloat>();
-        literal->sourcePosition = token->position;
-        literal->value = atof(token->getValue().c_str());
+        auto literal = makeRef<SyntaxLiteralFloat>();
+        literal->sourcePosition = state.tokenSourcePosition(token);
+        literal->value = atof(std::string(state.tokenValue(token)).c_str());
         return literal;
     }
 
-    std::string parseCEscapedString(const std::string &str)
+    std::string parseCEscapedString(std::string_view str)
     {
         std::string unescaped;
         unescaped.reserve(str.size());
@@ -208,7 +271,7 @@ namespace Sysmel
         for (size_t i = 0; i < str.size(); ++i)
         {
             auto c = str[i];
-            if (c == '\\')
+            if (c == '\\' && i + 1 < str.size())
             {
                 auto c1 = str[++i];
                 switch (c1)
@@ -240,9 +303,9 @@ namespace Sysmel
     {
         auto token = state.next();
         assert(token->kind == TokenKind::Character);
-        auto literal = std::make_shared<SyntaxLiteralCharacter>();
-        literal->sourcePosition = token->position;
-        auto tokenValue = token->getValue();
+        auto literal = makeRef<SyntaxLiteralCharacter>();
+        literal->sourcePosition = state.tokenSourcePosition(token);
+        auto tokenValue = state.tokenValue(token);
         literal->value = parseCEscapedString(tokenValue.substr(1, tokenValue.size() - 2))[0];
         return literal;
     }
@@ -251,9 +314,9 @@ namespace Sysmel
     {
         auto token = state.next();
         assert(token->kind == TokenKind::String);
-        auto literal = std::make_shared<SyntaxLiteralString>();
-        literal->sourcePosition = token->position;
-        auto tokenValue = token->getValue();
+        auto literal = makeRef<SyntaxLiteralString>();
+        literal->sourcePosition = state.tokenSourcePosition(token);
+        auto tokenValue = state.tokenValue(token);
         literal->value = parseCEscapedString(tokenValue.substr(1, tokenValue.size() - 2));
         return literal;
     }
@@ -262,9 +325,9 @@ namespace Sysmel
     {
         auto token = state.next();
         assert(token->kind == TokenKind::Symbol);
-        auto literal = std::make_shared<SyntaxLiteralSymbol>();
-        literal->sourcePosition = token->position;
-        auto tokenValue = token->getValue().substr(1);
+        auto literal = makeRef<SyntaxLiteralSymbol>();
+        literal->sourcePosition = state.tokenSourcePosition(token);
+        auto tokenValue = state.tokenValue(token).substr(1);
         if (tokenValue[0] == '\"')
             literal->value = parseCEscapedString(tokenValue.substr(1, tokenValue.size() - 2));
         else
@@ -297,9 +360,9 @@ namespace Sysmel
         auto token = state.next();
         assert(token->kind == TokenKind::Identifier);
 
-        auto node = std::make_shared<SyntaxIdentifierReference>();
-        node->sourcePosition = token->position;
-        node->value = token->getValue();
+        auto node = makeRef<SyntaxIdentifierReference>();
+        node->sourcePosition = state.tokenSourcePosition(token);
+        node->value = state.tokenValue(token);
         return node;
     }
 
@@ -326,14 +389,14 @@ namespace Sysmel
 
         if (isBinaryExpressionOperator(state.peekKind()) && state.peekKind(1) == TokenKind::RightParent)
         {
-            auto token = state.next();
+            state.advance();
             state.advance();
         }
 
         if (state.peekKind() == TokenKind::RightParent)
         {
             state.advance();
-            auto tuple = std::make_shared<SyntaxTuple>();
+            auto tuple = makeRef<SyntaxTuple>();
             tuple->sourcePosition = state.sourcePositionFrom(startPosition);
             return tuple;
         }
@@ -357,12 +420,11 @@ namespace Sysmel
         }
         else
         {
-            // TODO: add an error
-            abort();
+            expressions.push_back(state.makeErrorAtCurrentSourcePosition("Expected a right bracket"));
         }
         
         // Array
-        auto array = std::make_shared<SyntaxArray> ();
+        auto array = makeRef<SyntaxArray> ();
         array->sourcePosition = state.sourcePositionFrom(startPosition);
         array->expressions.swap(expressions);
         return array;
@@ -382,12 +444,11 @@ namespace Sysmel
         }
         else
         {
-            // TODO: an error
-            abort();
+            expressions.push_back(state.makeErrorAtCurrentSourcePosition("Expected a right bracket"));
         }
         
         // Byte
-        auto byteArray = std::make_shared<SyntaxByteArray> ();
+        auto byteArray = makeRef<SyntaxByteArray> ();
         byteArray->sourcePosition = state.sourcePositionFrom(startPosition);
         byteArray->byteExpressions.swap(expressions);
         return byteArray;
@@ -412,7 +473,7 @@ namespace Sysmel
     ValuePtr parseUnaryPostfixExpression(ParserState &state)
     {
         auto startPosition = state.position;
-        auto receiver = parseTerm(state);
+        auto receiver = parseNested(state, parseTerm);
 
         while (isUnaryPostfixTokenKind(state.peekKind()))
         {
@@ -422,11 +483,11 @@ namespace Sysmel
             case TokenKind::Identifier:
                 {
                     state.advance();
-                    auto selector = std::make_shared<SyntaxLiteralSymbol> ();
-                    selector->sourcePosition = token->position;
-                    selector->value = token->getValue();
+                    auto selector = makeRef<SyntaxLiteralSymbol> ();
+                    selector->sourcePosition = state.tokenSourcePosition(token);
+                    selector->value = state.tokenValue(token);
 
-                    auto message = std::make_shared<SyntaxMessageSend> ();
+                    auto message = makeRef<SyntaxMessageSend> ();
                     message->sourcePosition = state.sourcePositionFrom(startPosition);
                     message->receiver = receiver;
                     message->selector = selector;
@@ -443,7 +504,7 @@ namespace Sysmel
                     else
                         arguments.push_back(state.makeErrorAtCurrentSourcePosition("Expected a right parenthesis"));
                     
-                    auto application = std::make_shared<SyntaxApplication> ();
+                    auto application = makeRef<SyntaxApplication> ();
                     application->sourcePosition = state.sourcePositionFrom(startPosition);
                     application->functional = receiver;
                     application->arguments = arguments;
@@ -461,7 +522,7 @@ namespace Sysmel
                     else
                         arguments.push_back(state.makeErrorAtCurrentSourcePosition("Expected a right bracket"));
                     
-                    auto application = std::make_shared<SyntaxApplication> ();
+                    auto application = makeRef<SyntaxApplication> ();
                     application->sourcePosition = state.sourcePositionFrom(startPosition);
                     application->functional = receiver;
                     application->arguments = arguments;
@@ -472,7 +533,7 @@ namespace Sysmel
             case TokenKind::LeftCurlyBracket:
                 {
                     auto argument = parseBlock(state);
-                    auto application = std::make_shared<SyntaxApplication> ();
+                    auto application = makeRef<SyntaxApplication> ();
                     application->sourcePosition = state.sourcePositionFrom(startPosition);
                     application->functional = receiver;
                     application->arguments.push_back(argument);
@@ -483,7 +544,7 @@ namespace Sysmel
             case TokenKind::DictionaryStart:
                 {
                     auto argument = parseDictionary(state);
-                    auto application = std::make_shared<SyntaxApplication> ();
+                    auto application = makeRef<SyntaxApplication> ();
                     application->sourcePosition = state.sourcePositionFrom(startPosition);
                     application->functional = receiver;
                     application->arguments.push_back(argument);
@@ -503,8 +564,8 @@ namespace Sysmel
         auto startPosition = state.position;
         assert(state.peekKind() == TokenKind::Quote);
         state.advance();
-        auto term = parseUnaryPrefixExpression(state);
-        auto quoteNode = std::make_shared<SyntaxQuote>();
+        auto term = parseNested(state, parseUnaryPrefixExpression);
+        auto quoteNode = makeRef<SyntaxQuote>();
         quoteNode->sourcePosition = state.sourcePositionFrom(startPosition);
         quoteNode->value = term;
         return quoteNode;
@@ -515,8 +576,8 @@ namespace Sysmel
         auto startPosition = state.position;
         assert(state.peekKind() == TokenKind::QuasiQuote);
         state.advance();
-        auto term = parseUnaryPrefixExpression(state);
-        auto quoteNode = std::make_shared<SyntaxQuasiQuote>();
+        auto term = parseNested(state, parseUnaryPrefixExpression);
+        auto quoteNode = makeRef<SyntaxQuasiQuote>();
         quoteNode->sourcePosition = state.sourcePositionFrom(startPosition);
         quoteNode->value = term;
         return quoteNode;
@@ -527,8 +588,8 @@ namespace Sysmel
         auto startPosition = state.position;
         assert(state.peekKind() == TokenKind::QuasiUnquote);
         state.advance();
-        auto term = parseUnaryPrefixExpression(state);
-        auto quoteNode = std::make_shared<SyntaxQuasiUnquote>();
+        auto term = parseNested(state, parseUnaryPrefixExpression);
+        auto quoteNode = makeRef<SyntaxQuasiUnquote>();
         quoteNode->sourcePosition = state.sourcePositionFrom(startPosition);
         quoteNode->value = term;
         return quoteNode;
@@ -539,8 +600,8 @@ namespace Sysmel
         auto startPosition = state.position;
         assert(state.peekKind() == TokenKind::Splice);
         state.advance();
-        auto term = parseUnaryPrefixExpression(state);
-        auto spliceNode = std::make_shared<SyntaxSplice>();
+        auto term = parseNested(state, parseUnaryPrefixExpression);
+        auto spliceNode = makeRef<SyntaxSplice>();
         spliceNode->sourcePosition = state.sourcePositionFrom(startPosition);
         spliceNode->value = term;
         return spliceNode;
@@ -575,16 +636,16 @@ namespace Sysmel
         while (isBinaryExpressionOperator(state.peekKind()))
         {
             auto operatorToken = state.next();
-            auto operatorNode = std::make_shared<SyntaxLiteralSymbol>();
-            operatorNode->sourcePosition = operatorToken->position;
-            operatorNode->value = operatorToken->getValue();
+            auto operatorNode = makeRef<SyntaxLiteralSymbol>();
+            operatorNode->sourcePosition = state.tokenSourcePosition(operatorToken);
+            operatorNode->value = state.tokenValue(operatorToken);
             elements.push_back(operatorNode);
 
             auto operand = parseUnaryPrefixExpression(state);
             elements.push_back(operand);
         }
 
-        auto binaryExpression = std::make_shared<SyntaxBinaryExpressionSequence>();
+        auto binaryExpression = makeRef<SyntaxBinaryExpressionSequence>();
         binaryExpression->sourcePosition = state.sourcePositionFrom(startPosition);
         binaryExpression->elements.swap(elements);
         return binaryExpression;
@@ -599,8 +660,8 @@ namespace Sysmel
             return key;
 
         state.advance();
-        auto value = parseAssociationExpression(state);
-        auto assoc = std::make_shared<SyntaxAssociation>();
+        auto value = parseNested(state, parseAssociationExpression);
+        auto assoc = makeRef<SyntaxAssociation>();
         assoc->sourcePosition = state.sourcePositionFrom(startPosition);
         assoc->key = key;
         assoc->value = value;
@@ -618,17 +679,17 @@ namespace Sysmel
         while (state.peekKind() == TokenKind::Keyword)
         {
             auto keywordToken = state.next();
-            symbolValue.append(keywordToken->getValue());
+            symbolValue.append(state.tokenValue(keywordToken));
 
-            auto argument = parseAssociationExpression(state);
+            auto argument = parseNested(state, parseAssociationExpression);
             arguments.push_back(argument);
         }
 
-        auto identifier = std::make_shared<SyntaxLiteralSymbol>();
+        auto identifier = makeRef<SyntaxLiteralSymbol>();
         identifier->sourcePosition = state.sourcePositionFrom(startPosition);
         identifier->value = symbolValue;
 
-        auto messageSend = std::make_shared<SyntaxMessageSend>();
+        auto messageSend = makeRef<SyntaxMessageSend>();
         messageSend->sourcePosition = state.sourcePositionFrom(startPosition);
         messageSend->selector = identifier;
         messageSend->arguments = arguments;
@@ -648,17 +709,17 @@ namespace Sysmel
         while(state.peekKind() == TokenKind::Keyword)
         {
             auto keywordToken = state.next();
-            selectorValue.append(keywordToken->getValue());
+            selectorValue.append(state.tokenValue(keywordToken));
 
-            auto argument = parseAssociationExpression(state);
+            auto argument = parseNested(state, parseAssociationExpression);
             arguments.push_back(argument);
         }
 
-        auto selectorSymbol = std::make_shared<SyntaxLiteralSymbol> ();
+        auto selectorSymbol = makeRef<SyntaxLiteralSymbol> ();
         selectorSymbol->sourcePosition = state.sourcePositionFrom(startPosition);
         selectorSymbol->value = selectorValue;
 
-        auto messageSend = std::make_shared<SyntaxMessageSend> ();
+        auto messageSend = makeRef<SyntaxMessageSend> ();
         messageSend->sourcePosition = state.sourcePositionFrom(startPosition);
         messageSend->receiver = receiver;
         messageSend->selector = selectorSymbol;
@@ -674,11 +735,11 @@ namespace Sysmel
         {
             state.advance();
             
-            auto selector = std::make_shared<SyntaxLiteralSymbol> ();
-            selector->sourcePosition = token->getSourcePosition();
-            selector->value = token->getValue();
+            auto selector = makeRef<SyntaxLiteralSymbol> ();
+            selector->sourcePosition = state.tokenSourcePosition(token);
+            selector->value = state.tokenValue(token);
 
-            auto cascadedMessage = std::make_shared<SyntaxMessageCascadeMessage> ();
+            auto cascadedMessage = makeRef<SyntaxMessageCascadeMessage> ();
             cascadedMessage->sourcePosition = state.sourcePositionFrom(startPosition);
             cascadedMessage->selector = selector;
             return cascadedMessage;
@@ -691,17 +752,17 @@ namespace Sysmel
             while(state.peekKind() == TokenKind::Keyword)
             {
                 auto keywordToken = state.next();
-                selectorValue.append(keywordToken->getValue());
+                selectorValue.append(state.tokenValue(keywordToken));
 
-                auto argument = parseBinaryExpressionSequence(state);
+                auto argument = parseNested(state, parseBinaryExpressionSequence);
                 arguments.push_back(argument);
             }
 
-            auto selector = std::make_shared<SyntaxLiteralSymbol> ();
+            auto selector = makeRef<SyntaxLiteralSymbol> ();
             selector->sourcePosition = state.sourcePositionFrom(startPosition);
             selector->value = selectorValue;
 
-            auto cascadedMessage = std::make_shared<SyntaxMessageCascadeMessage> ();
+            auto cascadedMessage = makeRef<SyntaxMessageCascadeMessage> ();
             cascadedMessage->sourcePosition = state.sourcePositionFrom(startPosition);
             cascadedMessage->selector = selector;
             cascadedMessage->arguments.swap(arguments);
@@ -710,13 +771,13 @@ namespace Sysmel
         else if(isBinaryExpressionOperator(state.peekKind()))
         {
             state.advance();
-            auto selector = std::make_shared<SyntaxLiteralSymbol> ();
+            auto selector = makeRef<SyntaxLiteralSymbol> ();
             selector->sourcePosition = state.sourcePositionFrom(startPosition);
-            selector->value = token->getValue();
+            selector->value = state.tokenValue(token);
 
             auto argument = parseUnaryPostfixExpression(state);
 
-            auto cascadedMessage = std::make_shared<SyntaxMessageCascadeMessage> ();
+            auto cascadedMessage = makeRef<SyntaxMessageCascadeMessage> ();
             cascadedMessage->sourcePosition = state.sourcePositionFrom(startPosition);
             cascadedMessage->selector = selector;
             cascadedMessage->arguments.push_back(argument);
@@ -736,6 +797,14 @@ namespace Sysmel
             return firstMessage;
         
         auto messageCascade = firstMessage->asMessageCascade();
+        if (!messageCascade)
+        {
+            // Only message sends can be cascaded.
+            messageCascade = makeRef<SyntaxMessageCascade>();
+            messageCascade->receiver = firstMessage;
+            messageCascade->messages.push_back(state.makeErrorAtCurrentSourcePosition("Expected a message send before the cascade."));
+        }
+
         while (state.peekKind() == TokenKind::Semicolon)
         {
             state.advance();
@@ -761,8 +830,8 @@ namespace Sysmel
         if (state.peekKind() == TokenKind::Assignment)
         {
             state.advance();
-            auto assignedValue = parseAssignmentExpression(state);
-            auto assignment = std::make_shared<SyntaxAssignment>();
+            auto assignedValue = parseNested(state, parseAssignmentExpression);
+            auto assignment = makeRef<SyntaxAssignment>();
             assignment->sourcePosition = state.sourcePositionFrom(startPosition);
             assignment->store = assignedStore;
             assignment->value = assignedValue;
@@ -792,7 +861,7 @@ namespace Sysmel
             elements.push_back(element);
         }
 
-        auto tuple = std::make_shared<SyntaxTuple>();
+        auto tuple = makeRef<SyntaxTuple>();
         tuple->sourcePosition = state.sourcePositionFrom(startingPosition);
         tuple->elements = elements;
         return tuple;
@@ -806,8 +875,8 @@ namespace Sysmel
         if (state.peekKind() == TokenKind::ColonColon)
         {
             state.advance();
-            auto resultTypeExpression = parseFunctionalType(state);
-            auto functionalType = std::make_shared<SyntaxFunctionalDependentType>();
+            auto resultTypeExpression = parseNested(state, parseFunctionalType);
+            auto functionalType = makeRef<SyntaxFunctionalDependentType>();
             functionalType->sourcePosition = state.sourcePositionFrom(startPosition);
             functionalType->argumentPattern = argumentPatternOrExpression;
             functionalType->resultType = resultTypeExpression;
@@ -830,7 +899,7 @@ namespace Sysmel
             state.advance();
             if (state.peekKind() == TokenKind::Bar)
             {
-                auto functionalTypeNode = std::make_shared<SyntaxFunctionalDependentType>();
+                auto functionalTypeNode = makeRef<SyntaxFunctionalDependentType>();
                 functionalTypeNode->sourcePosition = state.currentSourcePosition();
                 functionalType = functionalTypeNode;
             }
@@ -846,7 +915,7 @@ namespace Sysmel
 
         if (functionalType)
         {
-            auto block = std::make_shared<SyntaxBlock>();
+            auto block = makeRef<SyntaxBlock>();
             block->sourcePosition = state.sourcePositionFrom(startPosition);
             block->functionType = functionalType;
             block->body = body;
@@ -854,7 +923,7 @@ namespace Sysmel
         }
         else
         {
-            auto lexicalBlock = std::make_shared<SyntaxLexicalBlock>();
+            auto lexicalBlock = makeRef<SyntaxLexicalBlock>();
             lexicalBlock->sourcePosition = state.sourcePositionFrom(startPosition);
             lexicalBlock->body = body;
             return lexicalBlock;
@@ -869,14 +938,14 @@ namespace Sysmel
         if(state.peekKind() == TokenKind::Keyword)
         {
             auto keyToken = state.next();
-            auto keyTokenValue = keyToken->getValue();
-            auto keySymbol = std::make_shared<SyntaxLiteralSymbol> ();
-            keySymbol->sourcePosition = keyToken->position;
+            auto keyTokenValue = state.tokenValue(keyToken);
+            auto keySymbol = makeRef<SyntaxLiteralSymbol> ();
+            keySymbol->sourcePosition = state.tokenSourcePosition(keyToken);
             keySymbol->value = keyTokenValue.substr(0, keyTokenValue.size() - 1);
             key = keySymbol;
 
             if(state.peekKind() != TokenKind::Dot && state.peekKind() != TokenKind::RightCurlyBracket)
-                value = parseAssociationExpression(state);
+                value = parseNested(state, parseAssociationExpression);
         }
         else
         {
@@ -884,11 +953,11 @@ namespace Sysmel
             if(state.peekKind() == TokenKind::Colon)
             {
                 state.advance();
-                value = parseAssociationExpression(state);
+                value = parseNested(state, parseAssociationExpression);
             }
         }
 
-        auto dictAssociation = std::make_shared<SyntaxAssociation> ();
+        auto dictAssociation = makeRef<SyntaxAssociation> ();
         dictAssociation->sourcePosition = state.sourcePositionFrom(startPosition);
         dictAssociation->key = key;
         dictAssociation->value = value;
@@ -909,7 +978,7 @@ namespace Sysmel
         // Parse the next expression
         bool expectsExpression = true;
         std::vector<ValuePtr> elements;
-        while (!state.atEnd() and state.peekKind() != TokenKind::RightCurlyBracket)
+        while (!state.atEnd() and state.peekKind() != TokenKind::EndOfSource and state.peekKind() != TokenKind::RightCurlyBracket)
         {
             if (!expectsExpression)
                 elements.push_back(state.makeErrorAtCurrentSourcePosition("Expected dot before association."));
@@ -932,7 +1001,7 @@ namespace Sysmel
         else
             elements.push_back(state.makeErrorAtCurrentSourcePosition("Expected a right curly bracket."));
 
-        auto dictionary = std::make_shared<SyntaxDictionary> ();
+        auto dictionary = makeRef<SyntaxDictionary> ();
         dictionary->sourcePosition = state.sourcePositionFrom(startPosition);
         dictionary->elements.swap(elements);
         return dictionary;
@@ -967,9 +1036,9 @@ namespace Sysmel
         if(state.peekKind() == TokenKind::Identifier)
         {
             auto token = state.next();
-            auto nameSymbol = std::make_shared<SyntaxLiteralSymbol> ();
-            nameSymbol->sourcePosition = token->position;
-            nameSymbol->value = token->getValue();
+            auto nameSymbol = makeRef<SyntaxLiteralSymbol> ();
+            nameSymbol->sourcePosition = state.tokenSourcePosition(token);
+            nameSymbol->value = state.tokenValue(token);
             return nameSymbol;
         }
         else
@@ -1027,7 +1096,7 @@ namespace Sysmel
             }
         }
 
-        auto bindableName = std::make_shared<SyntaxBindableName> ();
+        auto bindableName = makeRef<SyntaxBindableName> ();
         bindableName->sourcePosition = state.sourcePositionFrom(startPosition);
         bindableName->typeExpression = typeExpression;
         bindableName->nameExpression = nameExpression;
@@ -1070,7 +1139,7 @@ namespace Sysmel
         {
             state.advance();
             auto resultTypeExpression = parseFunctionalType(state);
-            auto functionalNode = std::make_shared<SyntaxFunctionalDependentType>();
+            auto functionalNode = makeRef<SyntaxFunctionalDependentType>();
             functionalNode->sourcePosition = state.sourcePositionFrom(startPosition);
             functionalNode->resultType = resultTypeExpression;
             return functionalNode;
@@ -1088,8 +1157,8 @@ namespace Sysmel
         if (state.peekKind() == TokenKind::BindOperator)
         {
             state.advance();
-            auto boundValue = parseBindExpression(state);
-            auto bindPattern = std::make_shared<SyntaxBindPattern>();
+            auto boundValue = parseNested(state, parseBindExpression);
+            auto bindPattern = makeRef<SyntaxBindPattern>();
             bindPattern->sourcePosition = state.sourcePositionFrom(startPosition);
             bindPattern->pattern = patternExpressionOrValue;
             bindPattern->value = boundValue;
@@ -1103,7 +1172,7 @@ namespace Sysmel
 
     ValuePtr parseExpression(ParserState &state)
     {
-        return parseBindExpression(state);
+        return parseNested(state, parseBindExpression);
     }
 
     std::vector<ValuePtr> parseExpressionListUntilEndOrDelimiter(ParserState &state, TokenKind delimiter)
@@ -1116,7 +1185,7 @@ namespace Sysmel
 
         bool expectsExpression = true;
 
-        while (!state.atEnd() && state.peekKind() != delimiter)
+        while (!state.atEnd() && state.peekKind() != TokenKind::EndOfSource && state.peekKind() != delimiter)
         {
             if (!expectsExpression)
                 elements.push_back(state.makeErrorAtCurrentSourcePosition("Expected dot before expression."));
@@ -1141,7 +1210,7 @@ namespace Sysmel
         if (expressions.size() == 1)
             return expressions[0];
 
-        auto syntaxSequence = std::make_shared<SyntaxValueSequence>();
+        auto syntaxSequence = makeRef<SyntaxValueSequence>();
         syntaxSequence->sourcePosition = state.sourcePositionFrom(initialPosition);
         syntaxSequence->elements = expressions;
         return syntaxSequence;
@@ -1152,10 +1221,163 @@ namespace Sysmel
         return parseSequenceUntilEndOrDelimiter(state, TokenKind::EndOfSource);
     }
 
-    ValuePtr parseTokens(const SourceCodePtr &sourceCode, const std::vector<TokenPtr> &tokens)
+    ValuePtr parseTokens(const ScannedSourceCode &scannedSourceCode, size_t &syntaxErrorCount)
+    {
+        auto &sourceCode = scannedSourceCode.sourceCode;
+        if(!sourceCode->syntaxArena)
+            sourceCode->syntaxArena = makeRef<SyntaxArena> ();
+
+        SyntaxArena::CurrentScope arenaScope(sourceCode->syntaxArena.get());
+        auto state = ParserState{&scannedSourceCode, &scannedSourceCode.tokens};
+        auto parseTree = parseTopLevelExpression(state);
+        syntaxErrorCount = state.syntaxErrorCount;
+        return parseTree;
+    }
+
+    template<typename T>
+    static void replaceInPlace(std::vector<T> &vector, size_t firstIndex, size_t replacedCount, std::vector<T> &replacement)
+    {
+        auto keptCount = std::min(replacedCount, replacement.size());
+        std::move(replacement.begin(), replacement.begin() + keptCount, vector.begin() + firstIndex);
+        if (replacement.size() < replacedCount)
+            vector.erase(vector.begin() + firstIndex + keptCount, vector.begin() + firstIndex + replacedCount);
+        else
+            vector.insert(vector.begin() + firstIndex + keptCount,
+                std::make_move_iterator(replacement.begin() + keptCount), std::make_move_iterator(replacement.end()));
+    }
+
+    IncrementalParser::IncrementalParser(const SourceCodePtr &sourceCode)
+        : scannedSourceCode(scanSourceCode(sourceCode))
+    {
+        if(!sourceCode->syntaxArena)
+            sourceCode->syntaxArena = makeRef<SyntaxArena> ();
+
+        SyntaxArena::CurrentScope arenaScope(sourceCode->syntaxArena.get());
+        topLevelSequence = makeRef<SyntaxValueSequence>();
+        std::vector<ExpressionTokenRange> parsedTokenRanges;
+        parseExpressionsFrom(0, 0, 0, topLevelSequence->elements, parsedTokenRanges);
+        expressionTokenRanges.swap(parsedTokenRanges);
+        for (auto &range : expressionTokenRanges)
+            syntaxErrorCount += range.syntaxErrorCount;
+        updateSequenceSourcePosition();
+    }
+
+    IncrementalParser::~IncrementalParser()
+    {
+    }
+
+    ValuePtr IncrementalParser::getParseTree() const
+    {
+        // The same tree as the one of parseTokens.
+        if (topLevelSequence->elements.size() == 1)
+            return topLevelSequence->elements[0];
+        return topLevelSequence;
+    }
+
+    ValuePtr IncrementalParser::applyEdit(size_t startIndex, size_t endIndex, std::string_view replacement)
+    {
+        auto edit = scannedSourceCode.sourceCode->applyEdit(startIndex, endIndex, replacement);
+        auto window = rescanSourceCodeEdit(scannedSourceCode, edit);
+        lastRescannedTokenCount = window.newEndTokenIndex - window.firstTokenIndex;
+
+        // Parsing an expression peeks at most one token after the token that ends it.
+        static constexpr size_t ExpressionLookahead = 2;
+        auto &ranges = expressionTokenRanges;
+        auto firstChangedIndex = size_t(std::partition_point(ranges.begin(), ranges.end(), [&](const ExpressionTokenRange &range) {
+            return range.endTokenIndex + ExpressionLookahead <= window.firstTokenIndex;
+        }) - ranges.begin());
+        auto oldSuffixIndex = size_t(std::partition_point(ranges.begin() + firstChangedIndex, ranges.end(), [&](const ExpressionTokenRange &range) {
+            return range.startTokenIndex < window.oldEndTokenIndex;
+        }) - ranges.begin());
+
+        // The arena memory is only released with the whole tree, so the nodes of the edits
+        // are allocated in the garbage collector heap, where the replaced ones are recycled.
+        SyntaxArena::CurrentScope garbageCollectedScope(nullptr);
+        auto startTokenIndex = firstChangedIndex > 0 ? ranges[firstChangedIndex - 1].endTokenIndex : 0;
+        auto tokenDelta = int64_t(window.newEndTokenIndex) - int64_t(window.oldEndTokenIndex);
+        std::vector<ValuePtr> reparsedExpressions;
+        std::vector<ExpressionTokenRange> reparsedTokenRanges;
+        auto keptSuffixIndex = parseExpressionsFrom(startTokenIndex, oldSuffixIndex, tokenDelta, reparsedExpressions, reparsedTokenRanges);
+
+        for (auto i = firstChangedIndex; i < keptSuffixIndex; ++i)
+            syntaxErrorCount -= ranges[i].syntaxErrorCount;
+        for (auto &range : reparsedTokenRanges)
+            syntaxErrorCount += range.syntaxErrorCount;
+
+        for (auto i = keptSuffixIndex; i < ranges.size(); ++i)
+        {
+            ranges[i].startTokenIndex += tokenDelta;
+            ranges[i].endTokenIndex += tokenDelta;
+        }
+
+        replaceInPlace(topLevelSequence->elements, firstChangedIndex, keptSuffixIndex - firstChangedIndex, reparsedExpressions);
+        replaceInPlace(ranges, firstChangedIndex, keptSuffixIndex - firstChangedIndex, reparsedTokenRanges);
+        updateSequenceSourcePosition();
+
+        // A kept node is moved through every edit since it was parsed, so the edits are discarded
+        // from time to time, which bounds both their memory and the cost of moving a node.
+        static constexpr size_t MaximumRetainedEditCount = 64;
+        if (scannedSourceCode.sourceCode->getRetainedEditCount() >= MaximumRetainedEditCount)
+            discardSourceEdits();
+        return getParseTree();
+    }
+
+    void IncrementalParser::discardSourceEdits()
+    {
+        auto synchronizeNode = [](Value *node) {
+            if (node->sourcePosition)
+                node->sourcePosition->synchronizeWithSourceCode();
+        };
+        synchronizeNode(topLevelSequence.get());
+        topLevelSequence->traverseChildren(synchronizeNode);
+        scannedSourceCode.sourceCode->discardEdits();
+    }
+
+    size_t IncrementalParser::parseExpressionsFrom(size_t startTokenIndex, size_t oldSuffixIndex, int64_t tokenDelta,
+        std::vector<ValuePtr> &parsedExpressions, std::vector<ExpressionTokenRange> &parsedTokenRanges)
+    {
+        auto state = ParserState{&scannedSourceCode, &scannedSourceCode.tokens};
+        state.position = startTokenIndex;
+        lastReparsedExpressionCount = 0;
+
+        // Leading dots.
+        if (startTokenIndex == 0)
+        {
+            while (state.peekKind() == TokenKind::Dot)
+                state.advance();
+        }
+
+        auto &oldRanges = expressionTokenRanges;
+        while (!state.atEnd() && state.peekKind() != TokenKind::EndOfSource)
+        {
+            // A top-level expression only depends on the tokens from its start, so the old expressions
+            // are kept once the parsing reaches the start of one of them after the edit.
+            while (oldSuffixIndex < oldRanges.size() && int64_t(oldRanges[oldSuffixIndex].startTokenIndex) + tokenDelta < int64_t(state.position))
+                ++oldSuffixIndex;
+            if (oldSuffixIndex < oldRanges.size() && int64_t(oldRanges[oldSuffixIndex].startTokenIndex) + tokenDelta == int64_t(state.position))
+                return oldSuffixIndex;
+
+            auto expressionStartTokenIndex = state.position;
+            auto expressionStartSyntaxErrorCount = state.syntaxErrorCount;
+            parsedExpressions.push_back(parseExpression(state));
+
+            // Trailing dots.
+            while (state.peekKind() == TokenKind::Dot)
+                state.advance();
+
+            parsedTokenRanges.push_back(ExpressionTokenRange{expressionStartTokenIndex, state.position, state.syntaxErrorCount - expressionStartSyntaxErrorCount});
+            ++lastReparsedExpressionCount;
+        }
+
+        return oldRanges.size();
+    }
+
+    void IncrementalParser::updateSequenceSourcePosition()
     {
-        auto state = ParserState{sourceCode, &tokens};
-        return parseTopLevelExpression(state);
+        // An expression can also consume the end of the source after an error.
+        auto state = ParserState{&scannedSourceCode, &scannedSourceCode.tokens};
+        state.position = expressionTokenRanges.empty() ? scannedSourceCode.tokens.size() - 1 : expressionTokenRanges.back().endTokenIndex;
+        topLevelSequence->sourcePosition = state.sourcePositionFrom(0);
     }
 
-} // End of namespace Sysmel
\ No newline at end of file
+} // End of namespace Sysmel
@@ -8,7 +8,74 @@
 namespace Sysmel
 {
 
-ValuePtr parseTokens(const SourceCodePtr &sourceCode, const std::vector<TokenPtr> &tokens);
+// The parser counts the syntax errors that it makes, so that the trees without them are not searched for them.
+ValuePtr parseTokens(const ScannedSourceCode &scannedSourceCode, size_t &syntaxErrorCount);
+
+typedef Ref<class SyntaxValueSequence> SyntaxValueSequencePtr;
+
+/**
+ * I keep the tokens and the top-level expressions of a source code for an editor,
+ * so that an edit of its text only rescans the tokens around the edit, and only
+ * reparses the top-level expressions that can see the changed tokens. The other
+ * expressions are kept, and their source positions are moved by the edit. The
+ * top-level sequence is updated in place. The source positions of the nodes that
+ * are no longer in my tree are not moved after the source edits are discarded.
+ */
+class IncrementalParser
+{
+public:
+    IncrementalParser(const SourceCodePtr &sourceCode);
+    ~IncrementalParser();
+
+    // Replaces the text between startIndex and endIndex, and returns the new parse tree.
+    ValuePtr applyEdit(size_t startIndex, size_t endIndex, std::string_view replacement);
+
+    ValuePtr getParseTree() const;
+
+    const ScannedSourceCode &getScannedSourceCode() const
+    {
+        return scannedSourceCode;
+    }
+
+    size_t getSyntaxErrorCount() const
+    {
+        return syntaxErrorCount;
+    }
+
+    size_t getLastRescannedTokenCount() const
+    {
+        return lastRescannedTokenCount;
+    }
+
+    size_t getLastReparsedExpressionCount() const
+    {
+        return lastReparsedExpressionCount;
+    }
+
+private:
+    // The tokens of an expression include the dots that follow it.
+    struct ExpressionTokenRange
+    {
+        size_t startTokenIndex;
+        size_t endTokenIndex;
+        size_t syntaxErrorCount;
+    };
+
+    // Stops on the first old expression that starts after the edit at the same token, and returns its index.
+    size_t parseExpressionsFrom(size_t startTokenIndex, size_t oldSuffixIndex, int64_t tokenDelta,
+        std::vector<ValuePtr> &parsedExpressions, std::vector<ExpressionTokenRange> &parsedTokenRanges);
+    void updateSequenceSourcePosition();
+
+    // Moves the source positions of every node to the current source version first.
+    void discardSourceEdits();
+
+    ScannedSourceCode scannedSourceCode;
+    SyntaxValueSequencePtr topLevelSequence;
+    std::vector<ExpressionTokenRange> expressionTokenRanges;
+    size_t syntaxErrorCount = 0;
+    size_t lastRescannedTokenCount = 0;
+    size_t lastReparsedExpressionCount = 0;
+};
 
 } // End of namespace Sysmel
 
@@ -0,0 +1,213 @@
+#ifndef SYSMEL_REF_HPP
+#define SYSMEL_REF_HPP
+
+#pragma once
+
+#include <stddef.h>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace Sysmel
+{
+
+/**
+ * I am a strong reference onto an object that keeps its own reference count,
+ * such as a Value. Retaining and releasing me is a plain, non-atomic increment
+ * and decrement on the referenced object header.
+ */
+template<typename T>
+class Ref
+{
+public:
+    typedef T element_type;
+
+    Ref() = default;
+    Ref(std::nullptr_t) {}
+
+    explicit Ref(T *object)
+        : pointer(object)
+    {
+        if(pointer)
+            pointer->retainReference();
+    }
+
+    Ref(const Ref<T> &other)
+        : pointer(other.pointer)
+    {
+        if(pointer)
+            pointer->retainReference();
+    }
+
+    Ref(Ref<T> &&other) noexcept
+        : pointer(other.pointer)
+    {
+        other.pointer = nullptr;
+    }
+
+    template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    Ref(const Ref<U> &other)
+        : pointer(other.get())
+    {
+        if(pointer)
+            pointer->retainReference();
+    }
+
+    template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    Ref(Ref<U> &&other) noexcept
+        : pointer(other.release())
+    {
+    }
+
+    ~Ref()
+    {
+        if(pointer)
+            pointer->releaseReference();
+    }
+
+    Ref<T> &operator=(const Ref<T> &other)
+    {
+        Ref<T> (other).swap(*this);
+        return *this;
+    }
+
+    Ref<T> &operator=(Ref<T> &&other) noexcept
+    {
+        Ref<T> (std::move(other)).swap(*this);
+        return *this;
+    }
+
+    template<typename U>
+    Ref<T> &operator=(const Ref<U> &other)
+    {
+        Ref<T> (other).swap(*this);
+        return *this;
+    }
+
+    template<typename U>
+    Ref<T> &operator=(Ref<U> &&other)
+    {
+        Ref<T> (std::move(other)).swap(*this);
+        return *this;
+    }
+
+    Ref<T> &operator=(std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    void reset()
+    {
+        Ref<T> ().swap(*this);
+    }
+
+    void swap(Ref<T> &other)
+    {
+        std::swap(pointer, other.pointer);
+    }
+
+    /// Gives up the ownership of the referenced object without releasing it.
+    T *release()
+    {
+        auto result = pointer;
+        pointer = nullptr;
+        return result;
+    }
+
+    /// Takes the ownership of an already retained object.
+    static Ref<T> adopt(T *object)
+    {
+        Ref<T> result;
+        result.pointer = object;
+        return result;
+    }
+
+    T *get() const
+    {
+        return pointer;
+    }
+
+    T *operator->() const
+    {
+        return pointer;
+    }
+
+    T &operator*() const
+    {
+        return *pointer;
+    }
+
+    explicit operator bool() const
+    {
+        return pointer != nullptr;
+    }
+
+private:
+    T *pointer = nullptr;
+};
+
+template<typename T, typename U>
+inline bool operator==(const Ref<T> &a, const Ref<U> &b)
+{
+    return a.get() == b.get();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const Ref<T> &a, const Ref<U> &b)
+{
+    return a.get() != b.get();
+}
+
+template<typename T, typename U>
+inline bool operator<(const Ref<T> &a, const Ref<U> &b)
+{
+    return std::less<const void*> ()(a.get(), b.get());
+}
+
+template<typename T>
+inline bool operator==(const Ref<T> &a, std::nullptr_t)
+{
+    return !a;
+}
+
+template<typename T>
+inline bool operator==(std::nullptr_t, const Ref<T> &a)
+{
+    return !a;
+}
+
+template<typename T>
+inline bool operator!=(const Ref<T> &a, std::nullptr_t)
+{
+    return bool(a);
+}
+
+template<typename T>
+inline bool operator!=(std::nullptr_t, const Ref<T> &a)
+{
+    return bool(a);
+}
+
+/// Allocates a new reference counted object, with its counter living in the same allocation.
+template<typename T, typename... Args>
+inline Ref<T> makeRef(Args&&... args)
+{
+    return Ref<T> (new T(std::forward<Args> (args)...));
+}
+
+template<typename T, typename U>
+inline Ref<T> staticRefCast(const Ref<U> &object)
+{
+    return Ref<T> (static_cast<T*> (object.get()));
+}
+
+template<typename T, typename U>
+inline Ref<T> staticRefCast(Ref<U> &&object)
+{
+    return Ref<T>::adopt(static_cast<T*> (object.release()));
+}
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_REF_HPP
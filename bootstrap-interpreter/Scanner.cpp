@@ -1,5 +1,15 @@
 #include "Scanner.hpp"
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SYSMEL_SCANNER_USE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
 namespace Sysmel
 {
@@ -15,157 +25,234 @@ const char *getTokenKindName(TokenKind kind)
     return TokenKindNames[int(kind)];
 }
 
+enum CharacterClass : uint8_t
+{
+    CharacterClassDigit = 1<<0,
+    CharacterClassIdentifierStart = 1<<1,
+    CharacterClassOperator = 1<<2,
+};
+
+// The scanner classifies each character with a single table lookup.
+struct CharacterClassTable
+{
+    constexpr CharacterClassTable()
+        : classes()
+    {
+        for(int c = '0'; c <= '9'; ++c)
+            classes[c] |= CharacterClassDigit;
+        for(int c = 'A'; c <= 'Z'; ++c)
+            classes[c] |= CharacterClassIdentifierStart;
+        for(int c = 'a'; c <= 'z'; ++c)
+            classes[c] |= CharacterClassIdentifierStart;
+        classes['_'] |= CharacterClassIdentifierStart;
+
+        const char operatorCharacters[] = "+-/\\*~<>=@%|&?!^";
+        for(size_t i = 0; operatorCharacters[i]; ++i)
+            classes[uint8_t(operatorCharacters[i])] |= CharacterClassOperator;
+    }
+
+    uint8_t classes[256];
+};
+
+static constexpr CharacterClassTable characterClassTable;
+
+inline bool hasCharacterClass(int character, uint8_t characterClasses)
+{
+    // Negative characters are either the end of the source or bytes outside of ASCII.
+    return unsigned(character) < 256 && (characterClassTable.classes[character] & characterClasses) != 0;
+}
+
 inline bool isDigit(int character)
 {
-    return '0' <= character && character <= '9';
+    return hasCharacterClass(character, CharacterClassDigit);
 }
 
 inline bool isIdentifierStart(int character)
 {
-    return
-        ('A' <= character && character <= 'Z') ||
-        ('a' <= character && character <= 'z') ||
-        (character == '_')
-        ;
+    return hasCharacterClass(character, CharacterClassIdentifierStart);
 }
 
 inline bool isIdentifierMiddle(int character)
 {
-    return isIdentifierStart(character) || isDigit(character);
+    return hasCharacterClass(character, CharacterClassIdentifierStart | CharacterClassDigit);
 }
 
-bool isOperatorCharacter(int character)
+inline bool isOperatorCharacter(int character)
 {
-    for (auto c : "+-/\\*~<>=@%|&?!^")
-        if(c == character)
-            return true;
-    return false;
+    return hasCharacterClass(character, CharacterClassOperator);
+}
+
+#ifdef SYSMEL_SCANNER_USE_SSE2
+inline uint32_t countTrailingZeros(uint32_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, word);
+    return index;
+#else
+    return __builtin_ctz(word);
+#endif
+}
+
+// The kernels compute a mask of the characters where the scanning stops for a block of 16 characters.
+// Blocks are only loaded when they are completely inside of the text, and the tail is scanned one character at a time.
+template<typename BlockMaskFunction>
+inline uint32_t findFirstInBlocks(const char *text, uint32_t position, uint32_t size, const BlockMaskFunction &blockMask)
+{
+    while(position + 16 <= size)
+    {
+        auto mask = uint32_t(_mm_movemask_epi8(blockMask(_mm_loadu_si128(reinterpret_cast<const __m128i*> (text + position)))));
+        if(mask)
+            return position + countTrailingZeros(mask);
+        position += 16;
+    }
+
+    return position;
+}
+#endif
+
+// Returns the position of the first character that is not white, or the end of the text.
+// Bytes outside of ASCII are negative, so they are also skipped as white.
+uint32_t findFirstNonWhite(const char *text, uint32_t position, uint32_t size)
+{
+#ifdef SYSMEL_SCANNER_USE_SSE2
+    position = findFirstInBlocks(text, position, size, [](__m128i block) {
+        return _mm_cmpgt_epi8(block, _mm_set1_epi8(' '));
+    });
+#endif
+    while(position < size && text[position] <= ' ')
+        ++position;
+    return position;
+}
+
+// Returns the position of the first carriage return or new line, or the end of the text.
+uint32_t findLineEnd(const char *text, uint32_t position, uint32_t size)
+{
+#ifdef SYSMEL_SCANNER_USE_SSE2
+    position = findFirstInBlocks(text, position, size, [](__m128i block) {
+        return _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+    });
+#endif
+    while(position < size && text[position] != '\r' && text[position] != '\n')
+        ++position;
+    return position;
+}
+
+// Returns the position of the first occurrence of the character, or the end of the text.
+uint32_t findCharacter(const char *text, uint32_t position, uint32_t size, char character)
+{
+    auto found = reinterpret_cast<const char*> (memchr(text + position, character, size - position));
+    return found ? uint32_t(found - text) : size;
+}
+
+// Returns the position of the first delimiter or escape character, or the end of the text.
+uint32_t findDelimiterOrEscape(const char *text, uint32_t position, uint32_t size, char delimiter)
+{
+#ifdef SYSMEL_SCANNER_USE_SSE2
+    auto delimiters = _mm_set1_epi8(delimiter);
+    position = findFirstInBlocks(text, position, size, [&](__m128i block) {
+        return _mm_or_si128(_mm_cmpeq_epi8(block, delimiters), _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+    });
+#endif
+    while(position < size && text[position] != delimiter && text[position] != '\\')
+        ++position;
+    return position;
+}
+
+// Returns the position of the first character that cannot continue an identifier, or the end of the text.
+uint32_t findIdentifierEnd(const char *text, uint32_t position, uint32_t size)
+{
+#ifdef SYSMEL_SCANNER_USE_SSE2
+    position = findFirstInBlocks(text, position, size, [](__m128i block) {
+        // Setting the case bit maps only the letters into a..z. The comparisons are signed, so they reject the bytes outside of ASCII.
+        auto lowerCase = _mm_or_si128(block, _mm_set1_epi8(0x20));
+        auto isLetter = _mm_and_si128(_mm_cmpgt_epi8(lowerCase, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lowerCase, _mm_set1_epi8('z' + 1)));
+        auto isDigit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+        auto isUnderscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+        auto isIdentifierMiddle = _mm_or_si128(_mm_or_si128(isLetter, isDigit), isUnderscore);
+        return _mm_xor_si128(isIdentifierMiddle, _mm_set1_epi8(-1));
+    });
+#endif
+    while(position < size && isIdentifierMiddle(uint8_t(text[position])))
+        ++position;
+    return position;
 }
 
 struct ScannerState
 {
-    SourceCodePtr sourceCode;
-    int32_t position = 0;
-    int32_t line = 1;
-    int32_t column = 1;
-    bool isPreviousCR = false;
+    ScannedSourceCode *scannedSourceCode = nullptr;
+    const char *text = nullptr;
+    uint32_t size = 0;
+    uint32_t position = 0;
 
     bool atEnd() const
     {
-        return size_t(position) >= sourceCode->text.size();
+        return position >= size;
     }
 
     int peek(int peekOffset = 0)
     {
         size_t peekPosition = position + peekOffset;
-        if(peekPosition < sourceCode->text.size())
-            return sourceCode->text[peekPosition];
+        if(peekPosition < size)
+            return text[peekPosition];
         else
             return -1;
     }
 
-    void advanceSinglePosition()
+    void advance(int count = 1)
     {
-        assert(!atEnd());
-        auto c = sourceCode->text[position];
-        ++position;
-        switch(c)
-        {
-        case '\r':
-            ++line;
-            column = 1;
-            isPreviousCR = true;
-            break;
-        case '\n':
-            if (!isPreviousCR)
-            {
-                ++line;
-                column = 1;
-            }
-            isPreviousCR = false;
-            break;
-        case '\t':
-            column = (column + 4) % 4 * 4 + 1;
-            isPreviousCR = false;
-            break;
-        default:
-            ++column;
-            isPreviousCR = false;
-            break;
-        }
+        assert(position + count <= size);
+        position += count;
     }
 
-    void advance(int count = 1)
+    void advanceWhileIdentifierMiddle()
     {
-        for(int i = 0; i < count; ++i)
+        position = findIdentifierEnd(text, position, size);
+    }
+
+    // Stops on the delimiter or on the end of the text, and skips the escaped characters.
+    void advanceUntilUnescapedDelimiter(char delimiter)
+    {
+        for(;;)
         {
-            advanceSinglePosition();
+            position = findDelimiterOrEscape(text, position, size, delimiter);
+            if(peek() != '\\')
+                break;
+
+            if(peek(1) > 0)
+                advance(2);
+            else
+                advance();
         }
     }
 
-    TokenPtr makeToken(TokenKind kind)
+    Token makeToken(TokenKind kind)
     {
-        auto sourcePosition = std::make_shared<SourcePosition> ();
-        sourcePosition->sourceCode  = sourceCode;
-        sourcePosition->startIndex  = position;
-        sourcePosition->startLine   = line;
-        sourcePosition->startColumn = column;
-        sourcePosition->endIndex    = position;
-        sourcePosition->endLine     = line;
-        sourcePosition->endColumn   = column;
-        
-        auto token = std::make_shared<Token> ();
-        token->kind = kind;
-        token->position = sourcePosition;
-        return token;
+        return Token{kind, position, position};
     }
 
-    TokenPtr makeTokenStartingFrom(TokenKind kind, const ScannerState &initialState)
+    Token makeTokenStartingFrom(TokenKind kind, const ScannerState &initialState)
     {
-        auto sourcePosition = std::make_shared<SourcePosition> ();
-        sourcePosition->sourceCode  = sourceCode;
-        sourcePosition->startIndex  = initialState.position;
-        sourcePosition->startLine   = initialState.line;
-        sourcePosition->startColumn = initialState.column;
-        sourcePosition->endIndex    = position;
-        sourcePosition->endLine     = line;
-        sourcePosition->endColumn   = column;
-
-        auto token = std::make_shared<Token> ();
-        token->kind = kind;
-        token->position = sourcePosition;
-        return token;
+        return Token{kind, initialState.position, position};
     }
 
-    TokenPtr makeErrorTokenStartingFrom(const std::string &errorMessage, const ScannerState &initialState)
+    Token makeErrorTokenStartingFrom(const std::string &errorMessage, const ScannerState &initialState)
     {
-        auto sourcePosition = std::make_shared<SourcePosition> ();
-        sourcePosition->sourceCode  = sourceCode;
-        sourcePosition->startIndex  = initialState.position;
-        sourcePosition->startLine   = initialState.line;
-        sourcePosition->startColumn = initialState.column;
-        sourcePosition->endIndex    = position;
-        sourcePosition->endLine     = line;
-        sourcePosition->endColumn   = column;
-
-        auto token = std::make_shared<Token> ();
-        token->kind = TokenKind::Error;
-        token->position = sourcePosition;
-        token->errorMessage = errorMessage;
-        return token;
+        // The error token is the next one that is appended to the token array.
+        scannedSourceCode->errorMessages[scannedSourceCode->tokens.size()] = errorMessage;
+        return Token{TokenKind::Error, initialState.position, position};
     }
 };
 
 
-TokenPtr skipWhite(ScannerState &state)
+bool skipWhite(ScannerState &state, Token &errorToken)
 {
     bool hasSeenComment = false;
     
     do
     {
         hasSeenComment = false;
-        while (!state.atEnd() && state.peek() <= ' ')
-            state.advance();
+        state.position = findFirstNonWhite(state.text, state.position, state.size);
 
         if(state.peek() == '#')
         {
@@ -173,13 +260,7 @@ TokenPtr skipWhite(ScannerState &state)
             if(state.peek(1) == '#')
             {
                 state.advance(2);
-
-                while (!state.atEnd())
-                {
-                    if (state.peek() == '\r' || state.peek() == '\n')
-                        break;
-                    state.advance();
-                }
+                state.position = findLineEnd(state.text, state.position, state.size);
                 hasSeenComment = true;
             }
             else if(state.peek(1) == '*')
@@ -189,22 +270,28 @@ TokenPtr skipWhite(ScannerState &state)
                 bool hasCommentEnd = false;
                 while (!state.atEnd())
                 {
-                    hasCommentEnd = state.peek() == '*' &&  state.peek() == '#';
+                    state.position = findCharacter(state.text, state.position, state.size, '*');
+                    hasCommentEnd = state.peek() == '*' && state.peek(1) == '#';
                     if (hasCommentEnd)
                     {
                         state.advance(2);
                         break;
                     }
+
+                    if (!state.atEnd())
+                        state.advance();
                 }
                 if (!hasCommentEnd)
                 {
-                    return state.makeErrorTokenStartingFrom("Incomplete multiline comment.", commentInitialState);
+                    errorToken = state.makeErrorTokenStartingFrom("Incomplete multiline comment.", commentInitialState);
+                    return true;
                 }
+                hasSeenComment = true;
             }
         }
     } while (hasSeenComment);
     
-    return nullptr;
+    return false;
 }
 
 bool scanAdvanceKeyword(ScannerState &state)
@@ -213,8 +300,7 @@ bool scanAdvanceKeyword(ScannerState &state)
         return false;
 
     auto initialState = state;
-    while (isIdentifierMiddle(state.peek()))
-        state.advance();
+    state.advanceWhileIdentifierMiddle();
 
     if(state.peek() != ':')
     {
@@ -224,11 +310,11 @@ bool scanAdvanceKeyword(ScannerState &state)
 
     return true;
 }
-TokenPtr scanSingleToken(ScannerState &state)
+Token scanSingleToken(ScannerState &state)
 {
-    auto whiteToken = skipWhite(state);
-    if(whiteToken)
-        return whiteToken;
+    Token whiteErrorToken;
+    if(skipWhite(state, whiteErrorToken))
+        return whiteErrorToken;
 
     if(state.atEnd())
         return state.makeToken(TokenKind::EndOfSource);
@@ -240,8 +326,7 @@ TokenPtr scanSingleToken(ScannerState &state)
     if(isIdentifierStart(c))
     {
         state.advance();
-        while (isIdentifierMiddle(state.peek()))
-            state.advance();
+        state.advanceWhileIdentifierMiddle();
 
         if(state.peek() == ':')
         {
@@ -274,8 +359,7 @@ TokenPtr scanSingleToken(ScannerState &state)
         if(state.peek() == 'r')
         {
             state.advance();
-            while(isIdentifierMiddle(state.peek()))
-                state.advance();
+            state.advanceWhileIdentifierMiddle();
             return state.makeTokenStartingFrom(TokenKind::Nat, initialState);
         }
 
@@ -311,8 +395,7 @@ TokenPtr scanSingleToken(ScannerState &state)
         if(isIdentifierStart(c1))
         {
             state.advance(2);
-            while (isIdentifierMiddle(state.peek()))
-                state.advance();
+            state.advanceWhileIdentifierMiddle();
 
 
             if (state.peek() == ':')
@@ -338,13 +421,7 @@ TokenPtr scanSingleToken(ScannerState &state)
         else if(c1 == '"')
         {
             state.advance(2);
-            while (!state.atEnd() && state.peek() != '"')
-            {
-                if(state.peek() == '\\' && state.peek(1) > 0)
-                    state.advance(2);
-                else
-                    state.advance();
-            }
+            state.advanceUntilUnescapedDelimiter('"');
 
             if (state.peek() != '"')
                 return state.makeErrorTokenStartingFrom("Incomplete symbol string literal.", initialState);
@@ -373,13 +450,7 @@ TokenPtr scanSingleToken(ScannerState &state)
     if(c == '"')
     {
         state.advance();
-        while (!state.atEnd() && state.peek() != '"')
-        {
-            if(state.peek() == '\\' && state.peek(1) > 0)
-                state.advance(2);
-            else
-                state.advance();
-        }
+        state.advanceUntilUnescapedDelimiter('"');
 
         if (state.peek() != '"')
             return state.makeErrorTokenStartingFrom("Incomplete string literal.", initialState);
@@ -392,13 +463,7 @@ TokenPtr scanSingleToken(ScannerState &state)
     if(c == '\'')
     {
         state.advance();
-        while (!state.atEnd() && state.peek() != '\'')
-        {
-            if(state.peek() == '\\' && state.peek(1) > 0)
-                state.advance(2);
-            else
-                state.advance();
-        }
+        state.advanceUntilUnescapedDelimiter('\'');
 
         if (state.peek() != '\'')
             return state.makeErrorTokenStartingFrom("Incomplete character literal.", initialState);
@@ -497,19 +562,19 @@ TokenPtr scanSingleToken(ScannerState &state)
             state.advance();
 
         auto token = state.makeTokenStartingFrom(TokenKind::Operator, initialState);
-        auto tokenValue = token->getValue();
+        auto tokenValue = state.scannedSourceCode->getTokenValue(token);
         if (tokenValue == "<")
-            token->kind = TokenKind::LessThan;
+            token.kind = TokenKind::LessThan;
         else if (tokenValue == ">")
-            token->kind = TokenKind::GreaterThan;
+            token.kind = TokenKind::GreaterThan;
         else if (tokenValue == "*")
-            token->kind = TokenKind::Star;
+            token.kind = TokenKind::Star;
         else if (tokenValue == "?")
-            token->kind = TokenKind::Question;
+            token.kind = TokenKind::Question;
         else if (tokenValue == "!")
-            token->kind = TokenKind::Bang;
+            token.kind = TokenKind::Bang;
         else if (tokenValue == "<-")
-            token->kind = TokenKind::BindOperator;
+            token.kind = TokenKind::BindOperator;
         return token;
     }
 
@@ -519,27 +584,141 @@ TokenPtr scanSingleToken(ScannerState &state)
     return state.makeErrorTokenStartingFrom("Unknown character: " + unknownCharacter, initialState);
 }
 
-std::vector<TokenPtr> scanSourceCode(const SourceCodePtr &sourceCode)
+const std::string &ScannedSourceCode::getErrorMessage(size_t tokenIndex) const
+{
+    static const std::string noErrorMessage;
+    auto it = errorMessages.find(tokenIndex);
+    return it != errorMessages.end() ? it->second : noErrorMessage;
+}
+
+SourcePositionPtr ScannedSourceCode::makeSourcePosition(uint32_t startIndex, uint32_t endIndex) const
 {
-    std::vector<TokenPtr> tokens;
+    auto sourcePosition = makeRef<SourcePosition> ();
+    sourcePosition->sourceCode = sourceCode;
+    sourcePosition->startIndex = startIndex;
+    sourcePosition->endIndex = endIndex;
+    sourcePosition->sourceVersion = sourceCode->getVersion();
+    return sourcePosition;
+}
+
+ScannedSourceCode scanSourceCode(const SourceCodePtr &sourceCode)
+{
+    auto &text = sourceCode->text;
+    assert(text.size() <= UINT32_MAX);
+
+    ScannedSourceCode result;
+    result.sourceCode = sourceCode;
+
     ScannerState currentState;
-    TokenPtr scannedToken;
-    currentState.sourceCode = sourceCode;
+    currentState.scannedSourceCode = &result;
+    currentState.text = text.data();
+    currentState.size = uint32_t(text.size());
 
-    do
+    for(;;)
+    {
+        auto scannedToken = scanSingleToken(currentState);
+        result.tokens.push_back(scannedToken);
+        if (scannedToken.kind == TokenKind::EndOfSource)
+            break;
+    }
+
+    return result;
+}
+
+RescannedTokenWindow rescanSourceCodeEdit(ScannedSourceCode &scannedSourceCode, const SourceEdit &edit)
+{
+    auto &text = scannedSourceCode.sourceCode->text;
+    assert(text.size() <= UINT32_MAX);
+    auto &oldTokens = scannedSourceCode.tokens;
+
+    // The lookahead of a token only reads the characters up to the first one that is not part of the adjacent tokens,
+    // so the scanning restarts from the first token that can have seen the edit, or from the adjacent tokens before it.
+    auto firstTokenIndex = size_t(std::lower_bound(oldTokens.begin(), oldTokens.end(), edit.startIndex, [](const Token &token, size_t index) {
+        return token.endIndex < index;
+    }) - oldTokens.begin());
+    while(firstTokenIndex > 0 && firstTokenIndex < oldTokens.size() &&
+        oldTokens[firstTokenIndex - 1].endIndex == oldTokens[firstTokenIndex].startIndex)
+        --firstTokenIndex;
+
+    ScannedSourceCode window;
+    window.sourceCode = scannedSourceCode.sourceCode;
+
+    ScannerState currentState;
+    currentState.scannedSourceCode = &window;
+    currentState.text = text.data();
+    currentState.size = uint32_t(text.size());
+    currentState.position = firstTokenIndex > 0 ? oldTokens[firstTokenIndex - 1].endIndex : 0;
+
+    // The scanning only depends on the position, so it is back in sync with the old tokens
+    // when a token after the edit starts where a moved old token starts.
+    auto delta = int64_t(edit.newEndIndex) - int64_t(edit.oldEndIndex);
+    auto oldEndTokenIndex = firstTokenIndex;
+    for(;;)
     {
-        scannedToken = scanSingleToken(currentState);
-        if(scannedToken)
+        auto scannedToken = scanSingleToken(currentState);
+        if(scannedToken.startIndex >= edit.newEndIndex)
         {
-            tokens.push_back(scannedToken);
-            if (scannedToken->kind == TokenKind::EndOfSource)
+            while(oldEndTokenIndex < oldTokens.size() && int64_t(oldTokens[oldEndTokenIndex].startIndex) + delta < int64_t(scannedToken.startIndex))
+                ++oldEndTokenIndex;
+            if(oldEndTokenIndex < oldTokens.size() && oldTokens[oldEndTokenIndex].startIndex >= edit.oldEndIndex &&
+                int64_t(oldTokens[oldEndTokenIndex].startIndex) + delta == int64_t(scannedToken.startIndex))
+            {
+                window.errorMessages.erase(window.tokens.size());
                 break;
+            }
         }
-        
+
+        window.tokens.push_back(scannedToken);
+        if (scannedToken.kind == TokenKind::EndOfSource)
+        {
+            oldEndTokenIndex = oldTokens.size();
+            break;
+        }
+    }
+
+    RescannedTokenWindow result;
+    result.firstTokenIndex = firstTokenIndex;
+    result.oldEndTokenIndex = oldEndTokenIndex;
+    result.newEndTokenIndex = firstTokenIndex + window.tokens.size();
+
+    // Splice the window in place. The tokens after it are moved and shifted in a single pass.
+    auto oldTokenCount = oldTokens.size();
+    auto indexDelta = uint32_t(delta);
+    auto shiftedToken = [&](size_t index) {
+        auto token = oldTokens[index];
+        token.startIndex += indexDelta;
+        token.endIndex += indexDelta;
+        return token;
+    };
+    if(result.newEndTokenIndex > oldEndTokenIndex)
+    {
+        oldTokens.resize(oldTokenCount + result.newEndTokenIndex - oldEndTokenIndex);
+        for(auto i = oldTokenCount; i > oldEndTokenIndex; --i)
+            oldTokens[i - 1 - oldEndTokenIndex + result.newEndTokenIndex] = shiftedToken(i - 1);
+    }
+    else
+    {
+        for(auto i = oldEndTokenIndex; i < oldTokenCount; ++i)
+            oldTokens[i - oldEndTokenIndex + result.newEndTokenIndex] = shiftedToken(i);
+        oldTokens.resize(oldTokenCount - oldEndTokenIndex + result.newEndTokenIndex);
+    }
+    std::copy(window.tokens.begin(), window.tokens.end(), oldTokens.begin() + firstTokenIndex);
+
+    auto &errorMessages = scannedSourceCode.errorMessages;
+    std::vector<std::pair<size_t, std::string>> movedErrorMessages;
+    auto firstChangedErrorMessage = errorMessages.lower_bound(firstTokenIndex);
+    for(auto it = firstChangedErrorMessage; it != errorMessages.end(); ++it)
+    {
+        if(it->first >= oldEndTokenIndex)
+            movedErrorMessages.emplace_back(it->first - oldEndTokenIndex + result.newEndTokenIndex, std::move(it->second));
     }
-    while(scannedToken);
+    errorMessages.erase(firstChangedErrorMessage, errorMessages.end());
+    for(auto &[tokenIndex, message] : window.errorMessages)
+        errorMessages.emplace(tokenIndex + firstTokenIndex, std::move(message));
+    for(auto &[tokenIndex, message] : movedErrorMessages)
+        errorMessages.emplace(tokenIndex, std::move(message));
 
-    return tokens;
+    return result;
 }
 
-} // End of namespace Sysmel
\ No newline at end of file
+} // End of namespace Sysmel
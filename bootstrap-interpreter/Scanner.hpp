@@ -3,8 +3,10 @@
 
 #include "Source.hpp"
 #include "Value.hpp"
+#include <stdint.h>
 #include <vector>
 #include <string>
+#include <map>
 
 #pragma once
 
@@ -13,7 +15,7 @@ namespace Sysmel
 /**
  * TokenKind. The different kinds of token used in Sysmel.
  */
-enum class TokenKind
+enum class TokenKind : uint8_t
 {
 #define TokenKindName(name) name,
 #include "TokenKind.inc"
@@ -22,20 +24,59 @@ enum class TokenKind
 
 const char *getTokenKindName(TokenKind kind);
 
-struct Token : public Object
+/**
+ * I am a scanned token. I only keep the span of my text in the source code,
+ * so that the tokens of a source are a flat array of plain records.
+ */
+struct Token
 {
-    SourcePositionPtr position;
     TokenKind kind;
-    std::string errorMessage;
+    uint32_t startIndex;
+    uint32_t endIndex;
+};
+
+/**
+ * The tokens of a source code. The messages of the error tokens are kept aside
+ * by token index, and the source positions are only built when a diagnostic or
+ * a syntax node asks for them.
+ */
+struct ScannedSourceCode
+{
+    SourceCodePtr sourceCode;
+    std::vector<Token> tokens;
+    std::map<size_t, std::string> errorMessages;
+
+    std::string_view getTokenValue(const Token &token) const
+    {
+        return sourceCode->text.substr(token.startIndex, token.endIndex - token.startIndex);
+    }
+
+    const std::string &getErrorMessage(size_t tokenIndex) const;
+
+    SourcePositionPtr makeSourcePosition(uint32_t startIndex, uint32_t endIndex) const;
 
-    std::string getValue() const
+    SourcePositionPtr makeTokenSourcePosition(const Token &token) const
     {
-        return position->getValue();
+        return makeSourcePosition(token.startIndex, token.endIndex);
     }
 };
-typedef std::shared_ptr<Token> TokenPtr;
 
-std::vector<TokenPtr> scanSourceCode(const SourceCodePtr &sourceCode);
+ScannedSourceCode scanSourceCode(const SourceCodePtr &sourceCode);
+
+/**
+ * I am the span of tokens that is replaced when an edit is rescanned. The tokens
+ * before my first index are kept, and the tokens after my old end index are moved
+ * to start from my new end index.
+ */
+struct RescannedTokenWindow
+{
+    size_t firstTokenIndex;
+    size_t oldEndTokenIndex;
+    size_t newEndTokenIndex;
+};
+
+// The edit must already be applied to the source code of the tokens.
+RescannedTokenWindow rescanSourceCodeEdit(ScannedSourceCode &scannedSourceCode, const SourceEdit &edit);
 
 } // End of namespace Sysmel
 #endif
\ No newline at end of file
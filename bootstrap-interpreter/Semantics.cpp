@@ -27,8 +27,8 @@ public:
 
 ArgumentTypeAnalysisContextPtr SemanticPi::createArgumentTypeAnalysisContext()
 {
-    auto context = std::make_shared<SemanticPiArgumentAnalysisContext> ();
-    context->semanticPi = std::static_pointer_cast<SemanticPi> (shared_from_this());
+    auto context = makeRef<SemanticPiArgumentAnalysisContext> ();
+    context->semanticPi = staticRefCast<SemanticPi> (selfRef());
     return context;
 }
 
@@ -7,6 +7,7 @@
 #include "Environment.hpp"
 #include "Assert.hpp"
 #include "Type.hpp"
+#include "Bytecode.hpp"
 
 namespace Sysmel
 {
@@ -25,6 +26,12 @@ public:
         return getClass();
     }
     
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Object::visitSlots(visitor);
+        visitor.visit(type);
+    }
+
     ValuePtr type;
 };
 
@@ -33,6 +40,8 @@ class SemanticValueSequence : public SemanticValue
 public:
     virtual const char *getClassName() const { return "SemanticValueSequence"; }
 
+    virtual bool isSemanticValueSequence() const override { return true; }
+
     virtual void printStringOn(std::ostream &out) const override
     {
         out << "SemanticValueSequence(";
@@ -45,13 +54,27 @@ public:
         out << ")";
     }
 
-    virtual void traverseChildren(const std::function<void (ValuePtr)> &function) const override
+    virtual void collectChildren(ChildList &children) const override
     {
-        for(auto &element : elements)
-        {
-            function(element);
-            element->traverseChildren(function);
-        }
+        children.add(elements);
+    }
+
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual void compileBytecodeForEffect(BytecodeCompiler &compiler) override;
+    virtual ValuePtr foldConstants() override;
+
+    virtual ValuePtr markTailPosition() override
+    {
+        if(elements.empty())
+            return selfRef();
+
+        auto tailElement = elements.back()->markTailPosition();
+        if(tailElement == elements.back())
+            return selfRef();
+
+        auto tailSequence = makeRef<SemanticValueSequence> (*this);
+        tailSequence->elements.back() = tailElement;
+        return tailSequence;
     }
 
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
@@ -62,6 +85,12 @@ public:
         return result;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(elements);
+    }
+
     std::vector<ValuePtr> elements;
 };
 
@@ -85,19 +114,20 @@ public:
         out << ")";
     }
 
-    virtual void traverseChildren(const std::function<void (ValuePtr)> &function) const override
+    virtual void collectChildren(ChildList &children) const override
     {
-        if(functional)
-        {
-            function(functional);
-            functional->traverseChildren(function);
-        }
+        children.add(functional);
+        children.add(arguments);
+    }
 
-        for(const auto &argument : arguments)
-        {
-            function(argument);
-            argument->traverseChildren(function);
-        }
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
+    virtual ValuePtr markTailPosition() override
+    {
+        auto tailCall = makeRef<SemanticApplication> (*this);
+        tailCall->isTailCall = true;
+        return tailCall;
     }
 
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
@@ -113,10 +143,21 @@ public:
             argumentValues.push_back(argumentValue);
         }
 
+        if(isTailCall && functionalValue->isLambdaValue())
+            return LambdaValue::requestTailCall(functionalValue, std::move(argumentValues));
+
         auto result = functionalValue->applyWithArguments(argumentValues);
         return result;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(functional);
+        visitor.visit(arguments);
+    }
+
+    bool isTailCall = false;
     ValuePtr functional;
     std::vector<ValuePtr> arguments;
 };
@@ -144,43 +185,47 @@ public:
         out << ")";
     }
 
-    virtual void traverseChildren(const std::function<void (ValuePtr)> &function) const override
+    virtual void collectChildren(ChildList &children) const override
     {
-        if(receiver)
-        {
-            function(receiver);
-            receiver->traverseChildren(function);
-        }
-        if(selector)
-        {
-            function(selector);
-            selector->traverseChildren(function);
-        }
-        for(const auto &argument : arguments)
-        {
-            function(argument);
-            argument->traverseChildren(function);
-        }
+        children.add(receiver);
+        children.add(selector);
+        children.add(arguments);
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual void compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind) override;
+    virtual ValuePtr foldConstants() override;
+
+    bool getUnboxedOperation(BytecodeOpcode &opcode, PrimitiveNumberKind &kind);
+    ValuePtr evaluatePureSendWithLiteralOperands();
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto receiverValue = receiver->evaluateInEnvironment(environment);
+        std::vector<ValuePtr> receiverAndArguments;
+        receiverAndArguments.reserve(1 + arguments.size());
+        receiverAndArguments.push_back(receiver->evaluateInEnvironment(environment));
         auto selectorValue = selector->evaluateInEnvironment(environment);
-        std::vector<ValuePtr> argumentValues;
-        argumentValues.reserve(arguments.size());
         for (auto& arg: arguments)
         {
             auto evaluatedArgument = arg->evaluateInEnvironment(environment);
-            argumentValues.push_back(evaluatedArgument);
+            receiverAndArguments.push_back(evaluatedArgument);
         }
 
-        return receiverValue->performWithArguments(selectorValue, argumentValues);
+        return inlineCache.sendWithArguments(selectorValue, receiverAndArguments);
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(receiver);
+        visitor.visit(selector);
+        visitor.visit(arguments);
     }
 
     ValuePtr receiver;
     ValuePtr selector;
     std::vector<ValuePtr> arguments;
+    InlineCache inlineCache;
 };
 
 class SemanticArgumentNode : public SemanticValue
@@ -200,6 +245,12 @@ public:
         abort();
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(binding);
+    }
+
     SymbolArgumentBindingPtr binding;
     bool isImplicit = false;
     bool isExistential = false;
@@ -222,7 +273,7 @@ public:
         if(simpleFunctionTypeCache)
             return simpleFunctionTypeCache;
 
-        auto simpleFunctionType = std::make_shared<SimpleFunctionType> ();
+        auto simpleFunctionType = makeRef<SimpleFunctionType> ();
         simpleFunctionType->argumentTypes = argumentTypes;
         simpleFunctionType->argumentNames = argumentNames;
         simpleFunctionType->resultType = resultType;
@@ -234,6 +285,15 @@ public:
         return evaluateInEnvironment(nullptr)->createArgumentTypeAnalysisContext();
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(argumentTypes);
+        visitor.visit(argumentNames);
+        visitor.visit(resultType);
+        visitor.visit(simpleFunctionTypeCache);
+    }
+
     std::vector<ValuePtr> argumentTypes;
     std::vector<SymbolPtr> argumentNames;
     ValuePtr resultType;
@@ -257,11 +317,20 @@ public:
         abort();
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(name);
+        visitor.visit(closure);
+        visitor.visit(argumentBindings);
+        visitor.visit(body);
+        visitor.visit(fixpointBinding);
+    }
+
     SymbolPtr name;
     EnvironmentPtr closure;
     std::vector<SymbolArgumentBindingPtr> argumentBindings;
     bool isVariadic = false;
-    std::vector<SymbolCaptureBindingPtr> captureBindings;
     ValuePtr body;
     SymbolFixpointBindingPtr fixpointBinding;
 };
@@ -279,17 +348,30 @@ public:
 
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        (void)environment;
-        auto lambdaValue = std::make_shared<LambdaValue> ();
+        if(!bytecode && getEvaluationEngine() == EvaluationEngine::Bytecode)
+            bytecode = BytecodeCompiler::compileFunctionBody(body);
+
+        auto lambdaValue = makeRef<LambdaValue> ();
         lambdaValue->name = name;
         lambdaValue->type = type;
-        lambdaValue->closure = closure;
+        lambdaValue->closure = environment;
+        lambdaValue->frameSize = frameSize;
         lambdaValue->body = body;
         lambdaValue->argumentBindings = argumentBindings;
         lambdaValue->fixpointBinding = fixpointBinding;
+        lambdaValue->bytecode = bytecode;
     
         return lambdaValue;
     }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticFunctionalValue::visitSlots(visitor);
+        visitor.visit(bytecode);
+    }
+
+    size_t frameSize = 0;
+    BytecodeFunctionPtr bytecode;
 };
 
 class SemanticPi : public SemanticFunctionalValue
@@ -325,7 +407,7 @@ public:
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
         (void)environment;
-        auto pi = std::make_shared<PiType> ();
+        auto pi = makeRef<PiType> ();
         pi->nameExpression = name;
         pi->arguments = argumentBindings;
         pi->resultType = body;
@@ -341,7 +423,7 @@ public:
         {
             auto argType = binding->getType()->asTypeValue();
             if(!argType)
-                return shared_from_this();
+                return selfRef();
 
             argumentTypes.push_back(argType);
             argumentNames.push_back(binding->name);
@@ -349,9 +431,9 @@ public:
 
         ValuePtr resultType = body->asTypeValue();
         if(!resultType)
-            return shared_from_this();
+            return selfRef();
 
-        auto reducedType = std::make_shared<SemanticSimpleFunctionType> ();
+        auto reducedType = makeRef<SemanticSimpleFunctionType> ();
         reducedType->argumentTypes = argumentTypes;
         reducedType->argumentNames = argumentNames;
         reducedType->resultType = resultType;
@@ -359,7 +441,7 @@ public:
     }
 };
 
-typedef std::shared_ptr<SemanticPi> SemanticPiPtr;
+typedef Ref<SemanticPi> SemanticPiPtr;
 
 class SemanticSigma : public SemanticFunctionalValue
 {
@@ -385,6 +467,8 @@ class SemanticLiteralValue : public SemanticValue
 public:
     virtual const char *getClassName() const { return "SemanticLiteralValue"; }
 
+    virtual bool isSemanticLiteralValue() const override { return true; }
+
     virtual void printStringOn(std::ostream &out) const override {
         out << "SemanticLiteralValue(";
         value->printStringOn(out);
@@ -418,6 +502,9 @@ public:
 
     virtual ValuePtr asTypeValue() override { return value->asTypeValue(); }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual void compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind) override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
         (void)environment;
@@ -434,6 +521,12 @@ public:
         return value->applyMacroWithContextAndArguments(context, arguments);
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(value);
+    }
+
     ValuePtr value;
 };
 
@@ -457,9 +550,12 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto arrayObject = std::make_shared<Array> ();
+        auto arrayObject = makeRef<Array> ();
         arrayObject->values.reserve(expressions.size());
 
         for (const auto &expression: expressions)
@@ -471,6 +567,12 @@ public:
         return arrayObject;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(expressions);
+    }
+
     std::vector<ValuePtr> expressions;
 };
 
@@ -494,10 +596,13 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto tupleObject = std::make_shared<ProductTypeValue> ();
-        tupleObject->type = std::static_pointer_cast<ProductType> (type);
+        auto tupleObject = makeRef<ProductTypeValue> ();
+        tupleObject->type = staticRefCast<ProductType> (type);
         tupleObject->elements.reserve(expressions.size());
 
         for (const auto &expression: expressions)
@@ -509,6 +614,12 @@ public:
         return tupleObject;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(expressions);
+    }
+
     std::vector<ValuePtr> expressions;
 };
 
@@ -532,9 +643,12 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto byteArrayObject = std::make_shared<ByteArray> ();
+        auto byteArrayObject = makeRef<ByteArray> ();
         byteArrayObject->values.reserve(byteExpressions.size());
 
         for (const auto &byteExpression: byteExpressions)
@@ -546,6 +660,12 @@ public:
         return byteArrayObject;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(byteExpressions);
+    }
+
     std::vector<ValuePtr> byteExpressions;
 };
 
@@ -561,16 +681,94 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto foundValue = environment->lookupValueForBinding(identifierBinding);
-        if(!foundValue)
-            throwExceptionWithMessage("Failed to find value for binding");
-        
-        return foundValue;
+        auto frame = FunctionalActivationEnvironment::frameAtDepthFrom(environment.get(), frameDepth);
+        return frame->slots[frameSlotIndex];
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(identifierBinding);
     }
 
     ValuePtr identifierBinding;
+    size_t frameDepth = 0;
+    size_t frameSlotIndex = 0;
+};
+
+class SemanticGlobalValueReference : public SemanticValue
+{
+public:
+    virtual const char *getClassName() const { return "SemanticGlobalValueReference"; }
+
+    virtual void printStringOn(std::ostream &out) const override
+    {
+        out << "SemanticGlobalValueReference(";
+        binding->name->printStringOn(out);
+        out << ")";
+    }
+
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+
+    virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
+    {
+        (void)environment;
+        if(!binding->globalValue)
+            throwExceptionWithMessage("Failed to find value for binding");
+        return binding->globalValue;
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(binding);
+    }
+
+    SymbolValueBindingPtr binding;
+};
+
+class SemanticLocalDefinition : public SemanticValue
+{
+public:
+    virtual const char *getClassName() const { return "SemanticLocalDefinition"; }
+
+    virtual void printStringOn(std::ostream &out) const override
+    {
+        out << "SemanticLocalDefinition(";
+        binding->name->printStringOn(out);
+        out << " := ";
+        value->printStringOn(out);
+        out << ")";
+    }
+
+    virtual void collectChildren(ChildList &children) const override
+    {
+        children.add(value);
+    }
+
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
+    virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
+    {
+        auto definedValue = value->evaluateInEnvironment(environment);
+        static_cast<FunctionalActivationEnvironment*> (environment.get())->slots[binding->frameSlotIndex] = definedValue;
+        return definedValue;
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(binding);
+        visitor.visit(value);
+    }
+
+    SymbolValueBindingPtr binding;
+    ValuePtr value;
 };
 
 class MutableValueBox : public Value
@@ -600,6 +798,14 @@ public:
         return value;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(value);
+        visitor.visit(valueType);
+        visitor.visit(type);
+    }
+
     ValuePtr value;
     ValuePtr valueType;
     ValuePtr type;
@@ -622,16 +828,39 @@ public:
         }
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto box = std::make_shared<MutableValueBox> ();
+        auto box = makeRef<MutableValueBox> ();
         box->valueType = valueType->evaluateInEnvironment(environment);
         box->type = type->evaluateInEnvironment(environment);
         if(initialValueExpression)
             box->value = initialValueExpression->evaluateInEnvironment(environment);
+        storeBoxInBinding(box, environment);
         return box;
     }
 
+    void storeBoxInBinding(const ValuePtr &box, const EnvironmentPtr &environment)
+    {
+        if(!binding)
+            return;
+        if(binding->isFrameLocal)
+            static_cast<FunctionalActivationEnvironment*> (environment.get())->slots[binding->frameSlotIndex] = box;
+        else
+            binding->globalValue = box;
+    }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(binding);
+        visitor.visit(initialValueExpression);
+        visitor.visit(valueType);
+    }
+
+    SymbolValueBindingPtr binding;
     ValuePtr initialValueExpression;
     ValuePtr valueType;
     //ValuePtr type;
@@ -647,6 +876,10 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual void compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
         auto evalPointer = pointer->evaluateInEnvironment(environment);
@@ -654,6 +887,12 @@ public:
         return evalValue;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(pointer);
+    }
+
     ValuePtr pointer;
 };
 
@@ -669,6 +908,10 @@ public:
         out << ")";
     }
 
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual void compileBytecodeForEffect(BytecodeCompiler &compiler) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
         auto evalValue = value->evaluateInEnvironment(environment);
@@ -677,6 +920,13 @@ public:
         return evalValue;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(pointer);
+        visitor.visit(value);
+    }
+
     ValuePtr pointer;
     ValuePtr value;
 };
@@ -684,6 +934,26 @@ public:
 class SemanticIf : public SemanticValue
 {
 public:
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
+    virtual ValuePtr markTailPosition() override
+    {
+        // The result of an if without a value is void, and not the result of its cases.
+        if(!returnsValue)
+            return selfRef();
+
+        auto tailTrueCase = trueCase->markTailPosition();
+        auto tailFalseCase = falseCase->markTailPosition();
+        if(tailTrueCase == trueCase && tailFalseCase == falseCase)
+            return selfRef();
+
+        auto tailIf = makeRef<SemanticIf> (*this);
+        tailIf->trueCase = tailTrueCase;
+        tailIf->falseCase = tailFalseCase;
+        return tailIf;
+    }
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
         ValuePtr resultValue = VoidValue::uniqueInstance();
@@ -708,6 +978,14 @@ public:
         return resultValue;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(condition);
+        visitor.visit(trueCase);
+        visitor.visit(falseCase);
+    }
+
     bool returnsValue = false;
     ValuePtr condition;
     ValuePtr trueCase;
@@ -717,11 +995,14 @@ public:
 class SemanticWhile : public SemanticValue
 {
 public:
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister) override;
+    virtual ValuePtr foldConstants() override;
+
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment) override
     {
-        auto conditionValue = condition->evaluateInEnvironment(environment);
-        while(conditionValue->isTrue())
+        while(condition->evaluateInEnvironment(environment)->isTrue())
         {
+            GarbageCollector::safepoint();
             if(body)
                 body->evaluateInEnvironment(environment);
             if(continueAction)
@@ -731,6 +1012,14 @@ public:
         return VoidValue::uniqueInstance();
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        SemanticValue::visitSlots(visitor);
+        visitor.visit(condition);
+        visitor.visit(body);
+        visitor.visit(continueAction);
+    }
+
     ValuePtr condition;
     ValuePtr body;
     ValuePtr continueAction;
@@ -0,0 +1,202 @@
+#include "Source.hpp"
+#include "Assert.hpp"
+#include <algorithm>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Sysmel
+{
+
+SourceCode::~SourceCode()
+{
+    releaseMappedText();
+}
+
+void SourceCode::releaseMappedText()
+{
+#ifndef _WIN32
+    if(mappedText)
+        munmap(mappedText, mappedTextSize);
+#endif
+    mappedText = nullptr;
+    mappedTextSize = 0;
+}
+
+void SourceCode::setText(std::string newText)
+{
+    ownedText = std::move(newText);
+    text = ownedText;
+    releaseMappedText();
+    lineStartIndices.clear();
+    lastQueriedLineIndex = 0;
+}
+
+SourceEdit SourceCode::applyEdit(size_t startIndex, size_t endIndex, std::string_view replacement)
+{
+    sysmelAssert(startIndex <= endIndex && endIndex <= text.size());
+    SourceEdit edit{startIndex, endIndex, startIndex + replacement.size()};
+
+    // A mapped text is copied by the first edit, and the later ones are done in place.
+    if(!mappedText && text.data() == ownedText.data())
+    {
+        ownedText.replace(startIndex, endIndex - startIndex, replacement);
+        text = ownedText;
+        lineStartIndices.clear();
+        lastQueriedLineIndex = 0;
+    }
+    else
+    {
+        std::string newText;
+        newText.reserve(text.size() - (endIndex - startIndex) + replacement.size());
+        newText.append(text.substr(0, startIndex));
+        newText.append(replacement);
+        newText.append(text.substr(endIndex));
+        setText(std::move(newText));
+    }
+
+    edits.push_back(edit);
+    return edit;
+}
+
+void SourceCode::mapIndicesFromVersion(size_t version, size_t &startIndex, size_t &endIndex) const
+{
+    sysmelAssert(version >= baseVersion);
+    for(auto i = version - baseVersion; i < edits.size(); ++i)
+    {
+        auto &edit = edits[i];
+        startIndex = edit.mapStartIndex(startIndex);
+        endIndex = edit.mapEndIndex(endIndex);
+    }
+}
+
+void SourceCode::discardEdits()
+{
+    baseVersion += edits.size();
+    edits.clear();
+}
+
+bool SourceCode::loadTextFromFile(const std::string &fileName)
+{
+#ifdef _WIN32
+    std::ifstream in(fileName, std::ios::binary);
+    if(!in.good())
+        return false;
+
+    setText(std::string { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() });
+    return true;
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat fileStatus;
+    if(fstat(fd, &fileStatus) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Empty files cannot be mapped, and they do not need to.
+    mappedTextSize = size_t(fileStatus.st_size);
+    if(mappedTextSize > 0)
+    {
+        mappedText = mmap(nullptr, mappedTextSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mappedText == MAP_FAILED)
+        {
+            mappedText = nullptr;
+            mappedTextSize = 0;
+            close(fd);
+            return false;
+        }
+
+        text = std::string_view(reinterpret_cast<const char*> (mappedText), mappedTextSize);
+    }
+
+    // The mapping stays valid after closing the file descriptor.
+    close(fd);
+    return true;
+#endif
+}
+
+void SourceCode::computeLineStartIndices()
+{
+    lineStartIndices.push_back(0);
+
+    // memchr is vectorized by the C library, so sources without carriage returns only search for line feeds.
+    const char *textStart = text.data();
+    const char *textEnd = textStart + text.size();
+    if(!memchr(textStart, '\r', text.size()))
+    {
+        auto lineFeed = reinterpret_cast<const char*> (memchr(textStart, '\n', text.size()));
+        while(lineFeed)
+        {
+            lineStartIndices.push_back(uint32_t(lineFeed - textStart + 1));
+            ++lineFeed;
+            lineFeed = reinterpret_cast<const char*> (memchr(lineFeed, '\n', textEnd - lineFeed));
+        }
+        return;
+    }
+
+    // A CR LF pair only ends a single line.
+    for(size_t i = 0; i < text.size(); ++i)
+    {
+        auto c = text[i];
+        if(c == '\r' || (c == '\n' && (i == 0 || text[i - 1] != '\r')))
+            lineStartIndices.push_back(uint32_t(i + 1));
+    }
+}
+
+void SourceCode::computeLineAndColumn(size_t index, size_t &line, size_t &column)
+{
+    if(lineStartIndices.empty())
+        computeLineStartIndices();
+
+    // Diagnostics are usually requested for nearby positions, so the line of the previous query is tried first.
+    auto lineIndex = lastQueriedLineIndex;
+    if(index < lineStartIndices[lineIndex] ||
+        (lineIndex + 1 < lineStartIndices.size() && lineStartIndices[lineIndex + 1] <= index))
+    {
+        lineIndex = size_t(std::upper_bound(lineStartIndices.begin(), lineStartIndices.end(), index) - lineStartIndices.begin()) - 1;
+        lastQueriedLineIndex = lineIndex;
+    }
+
+    line = lineIndex + 1;
+    size_t lineStartIndex = lineStartIndices[lineIndex];
+
+    // Without tabs, the column is the distance from the start of the line.
+    if(!memchr(text.data() + lineStartIndex, '\t', index - lineStartIndex))
+    {
+        column = index - lineStartIndex + 1;
+        if(index > lineStartIndex && text[lineStartIndex] == '\n')
+            --column;
+        return;
+    }
+
+    column = 1;
+    for(auto i = lineStartIndex; i < index; ++i)
+    {
+        switch(text[i])
+        {
+        case '\t':
+            column = (column + 4) % 4 * 4 + 1;
+            break;
+        case '\n':
+            // Only the line feed of a CR LF pair can be inside of a line.
+            break;
+        default:
+            ++column;
+            break;
+        }
+    }
+}
+
+} // End of namespace Sysmel
@@ -4,45 +4,152 @@
 #pragma once
 
 #include "Object.hpp"
+#include "SyntaxArena.hpp"
 #include "Utilities.hpp"
 
 #include <stdint.h>
 #include <string>
-#include <memory>
+#include <string_view>
+#include <vector>
 #include <ostream>
 
 namespace Sysmel
 {
+/**
+ * I am an edit of a source code text. I replace the text between my start index
+ * and my old end index, and the replacement ends at my new end index.
+ */
+struct SourceEdit
+{
+    size_t startIndex;
+    size_t oldEndIndex;
+    size_t newEndIndex;
+
+    // The indices inside of the replaced text are moved to the bounds of the replacement.
+    size_t mapStartIndex(size_t index) const
+    {
+        if(index >= oldEndIndex)
+            return index - oldEndIndex + newEndIndex;
+        return index > startIndex ? startIndex : index;
+    }
+
+    size_t mapEndIndex(size_t index) const
+    {
+        if(index <= startIndex)
+            return index;
+        return index >= oldEndIndex ? index - oldEndIndex + newEndIndex : newEndIndex;
+    }
+};
+
 /**
  * Source code. Text plus additional metadata.
  */
 struct SourceCode : public Object
 {
+    SourceCode() = default;
+    SourceCode(const SourceCode &) = delete;
+    SourceCode &operator=(const SourceCode &) = delete;
+    ~SourceCode();
+
     std::string directory;
     std::string name;
     std::string language;
-    std::string text;
+
+    // A read-only view of the text, which is either owned by me or mapped from a file.
+    std::string_view text;
+
+    void setText(std::string newText);
+
+    // Replaces a span of the text. The source positions that were made before are moved on their next use.
+    SourceEdit applyEdit(size_t startIndex, size_t endIndex, std::string_view replacement);
+
+    size_t getVersion() const
+    {
+        return baseVersion + edits.size();
+    }
+
+    // The edits before my base version are discarded, so the source positions must be synchronized before.
+    void mapIndicesFromVersion(size_t version, size_t &startIndex, size_t &endIndex) const;
+
+    size_t getRetainedEditCount() const
+    {
+        return edits.size();
+    }
+
+    // Discards the edits, once every source position that is still used is at the current version.
+    void discardEdits();
+
+    // Maps the file read-only instead of copying it. I am left empty when the file cannot be opened.
+    bool loadTextFromFile(const std::string &fileName);
+
+    // The syntax nodes that are parsed from me.
+    SyntaxArenaPtr syntaxArena;
+
+    // Lines and columns are only needed for diagnostics, so the line start table is built on the first query.
+    void computeLineAndColumn(size_t index, size_t &line, size_t &column);
+
+private:
+    void computeLineStartIndices();
+    void releaseMappedText();
+
+    std::string ownedText;
+    void *mappedText = nullptr;
+    size_t mappedTextSize = 0;
+
+    std::vector<uint32_t> lineStartIndices;
+    size_t lastQueriedLineIndex = 0;
+
+    size_t baseVersion = 0;
+    std::vector<SourceEdit> edits;
 };
 
-typedef std::shared_ptr<SourceCode> SourceCodePtr;
+typedef Ref<SourceCode> SourceCodePtr;
 
+/**
+ * I am a span of a source code. I only keep byte offsets, and the lines and
+ * columns are derived from them when they are requested. My offsets are for
+ * a version of the source code, and they are moved through the later edits
+ * when I am used.
+ */
 struct SourcePosition : public Object
 {
     SourceCodePtr sourceCode;
-    size_t startIndex;
-    size_t endIndex;
-    size_t startLine;
-    size_t startColumn;
-    size_t endLine;
-    size_t endColumn;
+    mutable size_t startIndex;
+    mutable size_t endIndex;
+    mutable size_t sourceVersion = 0;
 
-    std::string getValue() const
+    void synchronizeWithSourceCode() const
     {
+        if(sourceVersion != sourceCode->getVersion())
+        {
+            sourceCode->mapIndicesFromVersion(sourceVersion, startIndex, endIndex);
+            sourceVersion = sourceCode->getVersion();
+        }
+    }
+
+    std::string_view getValue() const
+    {
+        synchronizeWithSourceCode();
         return sourceCode->text.substr(startIndex, endIndex - startIndex);
     }
 
+    void computeStartLineAndColumn(size_t &line, size_t &column) const
+    {
+        synchronizeWithSourceCode();
+        sourceCode->computeLineAndColumn(startIndex, line, column);
+    }
+
+    void computeEndLineAndColumn(size_t &line, size_t &column) const
+    {
+        synchronizeWithSourceCode();
+        sourceCode->computeLineAndColumn(endIndex, line, column);
+    }
+
     void formatIn(std::ostream &out)
     {
+        size_t startLine, startColumn, endLine, endColumn;
+        computeStartLineAndColumn(startLine, startColumn);
+        computeEndLineAndColumn(endLine, endColumn);
         out << joinPath(sourceCode->directory, sourceCode->name)
             << ':' << startLine << '.' << startColumn
             << '-' << startLine << '.' << endColumn;
@@ -50,36 +157,30 @@ struct SourcePosition : public Object
 
     SourcePositionPtr until(const SourcePositionPtr &endSourcePosition) const
     {
-        auto merged = std::make_shared<SourcePosition> ();
+        synchronizeWithSourceCode();
+        endSourcePosition->synchronizeWithSourceCode();
+        auto merged = makeRef<SourcePosition> ();
         merged->sourceCode = sourceCode;
-        
-        merged->startIndex  = startIndex;
-        merged->startLine   = startLine;
-        merged->startColumn = startColumn;
-
-        merged->endIndex  = endSourcePosition->startIndex;
-        merged->endLine   = endSourcePosition->startLine;
-        merged->endColumn = endSourcePosition->startColumn;
+        merged->startIndex = startIndex;
+        merged->endIndex = endSourcePosition->startIndex;
+        merged->sourceVersion = sourceVersion;
         return merged;
     }
 
     SourcePositionPtr to(const SourcePositionPtr &endSourcePosition) const
     {
-        auto merged = std::make_shared<SourcePosition> ();
+        synchronizeWithSourceCode();
+        endSourcePosition->synchronizeWithSourceCode();
+        auto merged = makeRef<SourcePosition> ();
         merged->sourceCode = sourceCode;
-        
-        merged->startIndex  = startIndex;
-        merged->startLine   = startLine;
-        merged->startColumn = startColumn;
-
-        merged->endIndex  = endSourcePosition->endIndex;
-        merged->endLine   = endSourcePosition->endLine;
-        merged->endColumn = endSourcePosition->endColumn;
+        merged->startIndex = startIndex;
+        merged->endIndex = endSourcePosition->endIndex;
+        merged->sourceVersion = sourceVersion;
         return merged;
     }
 };
 
-typedef std::shared_ptr<SourcePosition> SourcePositionPtr;
+typedef Ref<SourcePosition> SourcePositionPtr;
 
 } // end of namespace Sysmel
 
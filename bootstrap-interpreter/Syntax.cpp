@@ -12,7 +12,7 @@ ValuePtr SyntaxBinaryExpressionSequence::analyzeInEnvironment(const EnvironmentP
         auto operatorSymbol = elements[i];
         auto operand = elements[i + 1];
 
-        auto messageSend = std::make_shared<SyntaxMessageSend> ();
+        auto messageSend = makeRef<SyntaxMessageSend> ();
         messageSend->sourcePosition = result->getSourcePosition()->to(operand->getSourcePosition());
         messageSend->receiver = result;
         messageSend->selector = operatorSymbol;
@@ -29,11 +29,11 @@ ValuePtr SyntaxMessageSend::analyzeInEnvironment(const EnvironmentPtr &environme
     auto analyzedSelectorSymbol = analyzedSelector->asAnalyzedSymbolValue();
     if(!receiver && analyzedSelectorSymbol)
     {
-        auto functionalIdentifier = std::make_shared<SyntaxIdentifierReference> ();
+        auto functionalIdentifier = makeRef<SyntaxIdentifierReference> ();
         functionalIdentifier->sourcePosition = analyzedSelector->sourcePosition;
         functionalIdentifier->value = analyzedSelectorSymbol->value;
 
-        auto functionApplication = std::make_shared<SyntaxApplication>();
+        auto functionApplication = makeRef<SyntaxApplication>();
         functionApplication->functional = functionalIdentifier;
         functionApplication->sourcePosition = sourcePosition;
         functionApplication->arguments = arguments;
@@ -42,7 +42,7 @@ ValuePtr SyntaxMessageSend::analyzeInEnvironment(const EnvironmentPtr &environme
     
     auto analyzedReceiver = receiver->analyzeInEnvironment(environment);
     auto receiverTypeOrClass = analyzedReceiver->getTypeOrClass()->asTypeValue();
-    auto self = std::static_pointer_cast<SyntaxMessageSend> (shared_from_this());
+    auto self = staticRefCast<SyntaxMessageSend> (selfRef());
     return receiverTypeOrClass->analyzeSyntaxMessageSendOfInstance(self, environment, analyzedReceiver, analyzedSelector);
 }
 
@@ -67,7 +67,7 @@ ValuePtr SyntaxMessageSend::analyzeOrdinarySendWithReceiverTypeAndSelector(const
 
         }
 
-        auto analyzedMessage = std::make_shared<SemanticMessageSend> ();
+        auto analyzedMessage = makeRef<SemanticMessageSend> ();
         analyzedMessage->sourcePosition = sourcePosition;
         analyzedMessage->receiver = coercedReceiver;
         analyzedMessage->selector = analyzedSelectorSymbol;
@@ -93,14 +93,14 @@ ValuePtr SyntaxMessageCascade::analyzeInEnvironment(const EnvironmentPtr &enviro
     if(messages.empty())
         return analyzedReceiver;
 
-    auto sequence = std::make_shared<SemanticValueSequence> ();
+    auto sequence = makeRef<SemanticValueSequence> ();
     sequence->sourcePosition = sourcePosition;
     sequence->elements.reserve(1 + messages.size());
     sequence->elements.push_back(analyzedReceiver);
 
     for (auto &message : messages)
     {
-        auto cascadeMessage = std::static_pointer_cast<SyntaxMessageCascadeMessage> (message);
+        auto cascadeMessage = staticRefCast<SyntaxMessageCascadeMessage> (message);
         auto nonCascadedMessage = cascadeMessage->asMessageSendWithReceiver(analyzedReceiver);
         auto analyzedMessage = nonCascadedMessage->analyzeInEnvironment(environment);
         sequence->elements.push_back(analyzedMessage);
@@ -111,7 +111,7 @@ ValuePtr SyntaxMessageCascade::analyzeInEnvironment(const EnvironmentPtr &enviro
 
 SyntaxMessageSendPtr SyntaxMessageCascadeMessage::asMessageSendWithReceiver(const ValuePtr &receiver)
 {
-    auto messageSend = std::make_shared<SyntaxMessageSend> ();
+    auto messageSend = makeRef<SyntaxMessageSend> ();
     messageSend->sourcePosition = sourcePosition;
     messageSend->receiver = receiver;
     messageSend->selector = selector;
@@ -124,25 +124,25 @@ ValuePtr SyntaxAssignment::analyzeInEnvironment(const EnvironmentPtr &environmen
     auto expandedStore = store->analyzeInEnvironmentForMacroExpansionOnly(environment);
     if (expandedStore->isFunctionalDependentTypeNode())
     {
-        auto function = std::make_shared<SyntaxFunction> ();
+        auto function = makeRef<SyntaxFunction> ();
         function->sourcePosition = sourcePosition;
-        function->functionalType = std::static_pointer_cast<SyntaxFunctionalDependentType> (expandedStore);
+        function->functionalType = staticRefCast<SyntaxFunctionalDependentType> (expandedStore);
         function->body = value;
         return function->analyzeInEnvironment(environment);
     } 
     else if (expandedStore->isBindableName())
     {
-        auto bindableName = std::static_pointer_cast<SyntaxBindableName>(expandedStore);
+        auto bindableName = staticRefCast<SyntaxBindableName>(expandedStore);
         if(bindableName->typeExpression && bindableName->typeExpression->isFunctionalDependentTypeNode())
         {
-            auto function = std::make_shared<SyntaxFunction> ();
+            auto function = makeRef<SyntaxFunction> ();
             function->sourcePosition = sourcePosition;
             function->nameExpression = bindableName->nameExpression;
-            function->functionalType = std::static_pointer_cast<SyntaxFunctionalDependentType> (bindableName->typeExpression);
+            function->functionalType = staticRefCast<SyntaxFunctionalDependentType> (bindableName->typeExpression);
             function->body = value;
             function->isFixpoint = bindableName->hasPostTypeExpression;
 
-            auto bindingDefinition = std::make_shared<SyntaxBindingDefinition> ();
+            auto bindingDefinition = makeRef<SyntaxBindingDefinition> ();
             bindingDefinition->nameExpression = bindableName->nameExpression;
             bindingDefinition->expectedTypeExpression = nullptr;
             bindingDefinition->initialValueExpression = function;
@@ -153,7 +153,7 @@ ValuePtr SyntaxAssignment::analyzeInEnvironment(const EnvironmentPtr &environmen
         }
         else
         {
-            auto bindPattern = std::make_shared<SyntaxBindPattern> ();
+            auto bindPattern = makeRef<SyntaxBindPattern> ();
             bindPattern->sourcePosition = sourcePosition;
             bindPattern->pattern = expandedStore;
             bindPattern->value = value;
@@ -164,11 +164,11 @@ ValuePtr SyntaxAssignment::analyzeInEnvironment(const EnvironmentPtr &environmen
     else
     {
         // Treat it as another message.
-        auto selector = std::make_shared<SyntaxLiteralSymbol> ();
+        auto selector = makeRef<SyntaxLiteralSymbol> ();
         selector->sourcePosition = sourcePosition;
         selector->value = ":=";
 
-        auto messageSend = std::make_shared<SyntaxMessageSend> ();
+        auto messageSend = makeRef<SyntaxMessageSend> ();
         messageSend->sourcePosition = sourcePosition;
         messageSend->receiver = expandedStore;
         messageSend->selector = selector;
@@ -179,7 +179,7 @@ ValuePtr SyntaxAssignment::analyzeInEnvironment(const EnvironmentPtr &environmen
 
 ValuePtr SyntaxBindableName::expandBindingOfValueWithAt(const ValuePtr &value, const SourcePositionPtr &position)
 {
-    auto binding = std::make_shared<SyntaxBindingDefinition> ();
+    auto binding = makeRef<SyntaxBindingDefinition> ();
     binding->sourcePosition = position;
     binding->nameExpression = nameExpression;
     binding->expectedTypeExpression = typeExpression;
@@ -16,12 +16,22 @@
 namespace Sysmel
 {
 
-    typedef std::shared_ptr<class SyntaxMessageSend> SyntaxMessageSendPtr;
-    typedef std::shared_ptr<class SyntaxLambda> SyntaxLambdaPtr;
+    typedef Ref<class SyntaxMessageSend> SyntaxMessageSendPtr;
+    typedef Ref<class SyntaxLambda> SyntaxLambdaPtr;
 
     class SyntacticValue : public Object
     {
     public:
+        static void *operator new(size_t size)
+        {
+            return SyntaxArena::allocateNode(size);
+        }
+
+        static void operator delete(void *pointer, size_t size)
+        {
+            SyntaxArena::deallocateNode(pointer, size);
+        }
+
         virtual bool isSyntacticValue() const override { return true; }
         virtual void printStringOn(std::ostream &out) const override { out << "SyntacticValue"; }
 
@@ -47,13 +57,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            for (auto &element : elements)
-            {
-                function(element);
-                element->traverseChildren(function);
-            }
+            children.add(elements);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -66,8 +72,8 @@ namespace Sysmel
                 analyzedElements.push_back(analyzedElement);
             }
 
-            auto analyzedSequence = std::make_shared<SemanticValueSequence>();
-            analyzedSequence->type = elements.empty() ? UnitType::uniqueInstance() : analyzedElements.back()->getClassOrType();
+            auto analyzedSequence = makeRef<SemanticValueSequence>();
+            analyzedSequence->type = elements.empty() ? UnitType::uniqueInstance() : analyzedElements.back()->getTypeOrClass();
             analyzedSequence->elements.swap(analyzedElements);
             return analyzedSequence;
         }
@@ -83,8 +89,8 @@ namespace Sysmel
                 analyzedElements.push_back(analyzedElement);
             }
 
-            auto analyzedSequence = std::make_shared<SemanticValueSequence>();
-            analyzedSequence->type = elements.empty() ? VoidType::uniqueInstance() : analyzedElements.back()->getClassOrType();
+            auto analyzedSequence = makeRef<SemanticValueSequence>();
+            analyzedSequence->type = elements.empty() ? VoidType::uniqueInstance() : analyzedElements.back()->getTypeOrClass();
             analyzedSequence->elements.swap(analyzedElements);
             return analyzedSequence;
 
@@ -107,19 +113,10 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (key)
-            {
-                function(key);
-                key->traverseChildren(function);
-            }
-
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(key);
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -155,26 +152,17 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (typeExpression)
-            {
-                function(typeExpression);
-                typeExpression->traverseChildren(function);
-            }
-
-            if (nameExpression)
-            {
-                function(nameExpression);
-                nameExpression->traverseChildren(function);
-            }
+            children.add(typeExpression);
+            children.add(nameExpression);
         }
 
         virtual ValuePtr expandBindingOfValueWithAt(const ValuePtr &value, const SourcePositionPtr &position) override;
 
         bool parseAndUnpackArgumentsPattern(std::vector<ValuePtr> &argumentNodes, bool &isExistential, bool &isVariadic)
         {
-            argumentNodes.push_back(shared_from_this());
+            argumentNodes.push_back(selfRef());
             isExistential = this->isExistential;
             isVariadic = this->isVariadic;
             return true;
@@ -201,7 +189,7 @@ namespace Sysmel
                 type = typeExpression->analyzeInEnvironment(environment);
             
 
-            auto binding = std::make_shared<SymbolArgumentBinding> ();
+            auto binding = makeRef<SymbolArgumentBinding> ();
             binding->sourcePosition = sourcePosition;
             binding->name = name;
             binding->type = type;
@@ -239,13 +227,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            for (const auto &element : elements)
-            {
-                function(element);
-                element->traverseChildren(function);
-            }
+            children.add(elements);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -272,13 +256,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            for (const auto &element : elements)
-            {
-                function(element);
-                element->traverseChildren(function);
-            }
+            children.add(elements);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -294,7 +274,7 @@ namespace Sysmel
                 elementTypes.push_back(analyzedElement->getClassOrType());
             }
 
-            auto semanticTuple = std::make_shared<SemanticTuple>();
+            auto semanticTuple = makeRef<SemanticTuple>();
             semanticTuple->sourcePosition = sourcePosition;
             semanticTuple->type = ProductType::getOrCreateWithElementTypes(elementTypes);
             semanticTuple->expressions = analyzedElements;
@@ -308,7 +288,7 @@ namespace Sysmel
                 if(!element->isBindableName())
                     throwExceptionWithMessageAt("Expected a bindable name", element->getSourcePosition());
                 
-                auto bindableElement = std::static_pointer_cast<SyntaxBindableName> (element);
+                auto bindableElement = staticRefCast<SyntaxBindableName> (element);
                 argumentNodes.push_back(bindableElement);
 
                 isExistential = isExistential || bindableElement->isExistential;
@@ -340,13 +320,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (innerNode)
-            {
-                function(innerNode);
-                innerNode->traverseChildren(function);
-            }
+            children.add(innerNode);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -374,7 +350,7 @@ namespace Sysmel
             if (!lookupResult)
                 throwExceptionWithMessage(("Failed to find " + symbol->printString() + " in current lexical scope.").c_str());
 
-            return lookupResult->analyzeIdentifierReferenceInEnvironment(shared_from_this(), environment);
+            return lookupResult->analyzeIdentifierReferenceInEnvironment(selfRef(), environment);
         }
 
         std::string value;
@@ -408,7 +384,7 @@ namespace Sysmel
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
-            auto functionalEnvironment = std::make_shared<FunctionalAnalysisEnvironment> (environment, sourcePosition);
+            auto functionalEnvironment = makeRef<FunctionalAnalysisEnvironment> (environment, sourcePosition);
             std::vector<SymbolArgumentBindingPtr> analyzedArguments;
             for (auto &argument : arguments)
             {
@@ -427,7 +403,7 @@ namespace Sysmel
                 name = nameExpression->asAnalyzedSymbolValue();
 
             // Construct the Pi type of the lambda.
-            auto semanticPi = std::make_shared<SemanticPi> ();
+            auto semanticPi = makeRef<SemanticPi> ();
             semanticPi->sourcePosition = sourcePosition;
             semanticPi->closure = environment;
             semanticPi->argumentBindings = analyzedArguments;
@@ -440,7 +416,7 @@ namespace Sysmel
 
             if(isFixpoint && name)
             {
-                fixpointBinding = std::make_shared<SymbolFixpointBinding> ();
+                fixpointBinding = makeRef<SymbolFixpointBinding> ();
                 fixpointBinding->sourcePosition = sourcePosition;
                 fixpointBinding->name = name;
                 fixpointBinding->typeExpression = functionType;
@@ -448,7 +424,7 @@ namespace Sysmel
             }
 
             // Analyze the body
-            auto bodyEnvironment = std::make_shared<LexicalEnvironment> (functionalEnvironment, sourcePosition);
+            auto bodyEnvironment = makeRef<LexicalEnvironment> (functionalEnvironment, sourcePosition);
             auto analyzedBody = body->analyzeInEnvironment(bodyEnvironment);
 
             // Body coercion
@@ -463,12 +439,17 @@ namespace Sysmel
                 if(!analyzedResultType)
                     analyzedResultType = GradualType::uniqueInstance();
 
-                auto literal = std::make_shared<SemanticLiteralValue> ();
+                auto literal = makeRef<SemanticLiteralValue> ();
                 literal->value = analyzedResultType;
                 analyzedResultType = literal;
             }
 
-            auto semanticLambda = std::make_shared<SemanticLambda> ();
+            analyzedBody = analyzedBody->foldConstants();
+
+            // Calls in tail position reuse the activation of this lambda instead of nesting a new one.
+            analyzedBody = analyzedBody->markTailPosition();
+
+            auto semanticLambda = makeRef<SemanticLambda> ();
             semanticLambda->sourcePosition = sourcePosition;
             semanticLambda->closure = environment;
             semanticLambda->type = functionType;
@@ -476,6 +457,7 @@ namespace Sysmel
             semanticLambda->isVariadic = isVariadic;
             semanticLambda->body = analyzedBody;
             semanticLambda->fixpointBinding = fixpointBinding;
+            semanticLambda->frameSize = functionalEnvironment->frameSize;
 
             return semanticLambda;
         }
@@ -512,7 +494,7 @@ namespace Sysmel
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
-            auto functionalEnvironment = std::make_shared<FunctionalAnalysisEnvironment> (environment, sourcePosition);
+            auto functionalEnvironment = makeRef<FunctionalAnalysisEnvironment> (environment, sourcePosition);
             std::vector<SymbolArgumentBindingPtr> analyzedArguments;
             for (auto &argument : arguments)
             {
@@ -523,7 +505,7 @@ namespace Sysmel
             ValuePtr analyzedBody;
             if(!body)
             {
-                auto literal = std::make_shared<SemanticLiteralValue> ();
+                auto literal = makeRef<SemanticLiteralValue> ();
                 literal->value = GradualType::uniqueInstance();
                 analyzedBody = literal;
             }
@@ -532,7 +514,7 @@ namespace Sysmel
                 analyzedBody = body->analyzeInEnvironment(functionalEnvironment);
             }
 
-            auto semanticPi = std::make_shared<SemanticPi> ();
+            auto semanticPi = makeRef<SemanticPi> ();
             semanticPi->closure = environment;
             semanticPi->argumentBindings.swap(analyzedArguments);
             semanticPi->isVariadic = isVariadic;
@@ -596,25 +578,17 @@ namespace Sysmel
                 out << " :: " << resultType->printString();
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (argumentPattern)
-            {
-                function(argumentPattern);
-                argumentPattern->traverseChildren(function);
-            }
-            if (resultType)
-            {
-                function(resultType);
-                resultType->traverseChildren(function);
-            }
+            children.add(argumentPattern);
+            children.add(resultType);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
             if(!argumentPattern)
             {
-                auto pi = std::make_shared<SyntaxPi> ();
+                auto pi = makeRef<SyntaxPi> ();
                 pi->isVariadic = false;
                 pi->body = resultType;
                 pi->callingConvention = callingConvention;
@@ -628,14 +602,14 @@ namespace Sysmel
 
             if(isExistential)
             {
-                auto sigma = std::make_shared<SyntaxSigma> ();
+                auto sigma = makeRef<SyntaxSigma> ();
                 sigma->sourcePosition = sourcePosition;
                 sigma->arguments = argumentNodes;
                 return sigma->analyzeInEnvironment(environment);
             }
             else
             {
-                auto pi = std::make_shared<SyntaxPi> ();
+                auto pi = makeRef<SyntaxPi> ();
                 pi->sourcePosition = sourcePosition;
                 pi->arguments = argumentNodes;
                 pi->isVariadic = isVariadic;
@@ -650,7 +624,7 @@ namespace Sysmel
             auto bodyOrInnerLambda = body;
             if (this->resultType->isFunctionalDependentTypeNode())
             {
-                auto resultDependentType = std::static_pointer_cast<SyntaxFunctionalDependentType> (this->resultType);
+                auto resultDependentType = staticRefCast<SyntaxFunctionalDependentType> (this->resultType);
                 bodyOrInnerLambda = resultDependentType->constructLambdaWithBody(nullptr, body, false);
             }
 
@@ -661,7 +635,7 @@ namespace Sysmel
             if (argumentPattern)
                 argumentPattern->parseAndUnpackArgumentsPattern(arguments, isExistential, isVariadic);
 
-            auto lambda = std::make_shared<SyntaxLambda> ();
+            auto lambda = makeRef<SyntaxLambda> ();
             lambda->sourcePosition = sourcePosition;
             lambda->nameExpression = nameExpression;
             lambda->arguments = arguments;
@@ -678,7 +652,7 @@ namespace Sysmel
         SymbolPtr callingConvention;
     };
 
-    typedef std::shared_ptr<SyntaxFunctionalDependentType> SyntaxFunctionalDependentTypePtr;
+    typedef Ref<SyntaxFunctionalDependentType> SyntaxFunctionalDependentTypePtr;
 
     class SyntaxFunction : public SyntacticValue
     {
@@ -720,18 +694,10 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (store)
-            {
-                function(store);
-                store->traverseChildren(function);
-            }
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(store);
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override;
@@ -769,7 +735,8 @@ namespace Sysmel
                 analyzedInitialValueExpression = initialValueExpression->analyzeInEnvironment(environment);
             }
 
-            auto semanticAlloca = std::make_shared<SemanticAlloca> ();
+            auto semanticAlloca = makeRef<SemanticAlloca> ();
+            semanticAlloca->sourcePosition = sourcePosition;
             semanticAlloca->initialValueExpression = analyzedInitialValueExpression;
             semanticAlloca->valueType = valueType;
             semanticAlloca->type = type;
@@ -795,7 +762,8 @@ namespace Sysmel
         ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
             auto analyzedPointer = pointer->analyzeInEnvironment(environment);
-            auto semanticLoadValue = std::make_shared<SemanticLoadValue> ();
+            auto semanticLoadValue = makeRef<SemanticLoadValue> ();
+            semanticLoadValue->sourcePosition = sourcePosition;
             semanticLoadValue->pointer = analyzedPointer;
             semanticLoadValue->type = type;
             return semanticLoadValue;
@@ -821,7 +789,8 @@ namespace Sysmel
         {
             auto analyzedPointer = pointer->analyzeInEnvironment(environment);
             auto analyzedValue = value->analyzeInEnvironment(environment);
-            auto semanticStore = std::make_shared<SemanticStoreValue> ();
+            auto semanticStore = makeRef<SemanticStoreValue> ();
+            semanticStore->sourcePosition = sourcePosition;
             semanticStore->pointer = analyzedPointer;
             semanticStore->value = analyzedValue;
             return semanticStore;
@@ -870,14 +839,29 @@ namespace Sysmel
                 currentModule = environment->getModule();
             }
 
+            auto functionalEnvironment = environment->getFunctionalAnalysisEnvironment();
             if(!isMutable && analyzedInitialValueExpression)
             {
-                auto valueBinding = std::make_shared<SymbolValueBinding> ();
+                auto valueBinding = makeRef<SymbolValueBinding> ();
                 valueBinding->sourcePosition = sourcePosition;
                 valueBinding->name = localName;
                 valueBinding->analyzedValue = analyzedInitialValueExpression;
                 environment->addLocalSymbolBinding(localName, valueBinding);
-                return analyzedInitialValueExpression;
+
+                // Function locals are evaluated once into their frame slot.
+                if(!functionalEnvironment || !analyzedInitialValueExpression->isSemanticValue() || analyzedInitialValueExpression->isSemanticLiteralValue())
+                    return analyzedInitialValueExpression;
+
+                valueBinding->isFrameLocal = true;
+                valueBinding->frameDepth = functionalEnvironment->frameDepth;
+                valueBinding->frameSlotIndex = functionalEnvironment->allocateFrameSlot();
+
+                auto localDefinition = makeRef<SemanticLocalDefinition> ();
+                localDefinition->sourcePosition = sourcePosition;
+                localDefinition->type = analyzedInitialValueExpression->getType();
+                localDefinition->binding = valueBinding;
+                localDefinition->value = analyzedInitialValueExpression;
+                return localDefinition;
             }
 
             sysmelAssert(isMutable);
@@ -885,17 +869,25 @@ namespace Sysmel
             if(!analyzedExpectedType && analyzedInitialValueExpression)
                 analyzedExpectedType = analyzedInitialValueExpression->getTypeOrClass();
 
-            auto alloca = std::make_shared<SyntaxAlloca> ();
+            auto alloca = makeRef<SyntaxAlloca> ();
+            alloca->sourcePosition = sourcePosition;
             alloca->valueType = analyzedExpectedType;
             alloca->type = ReferenceType::make(analyzedExpectedType);
             alloca->initialValueExpression = analyzedInitialValueExpression;
-            auto analyzedAlloca = alloca->analyzeInEnvironment(environment);
+            auto analyzedAlloca = staticRefCast<SemanticAlloca> (alloca->analyzeInEnvironment(environment));
 
-            auto allocaBinding = std::make_shared<SymbolValueBinding> ();
+            auto allocaBinding = makeRef<SymbolValueBinding> ();
             allocaBinding->sourcePosition = sourcePosition;
             allocaBinding->name = localName;
             allocaBinding->analyzedValue = analyzedAlloca;
             allocaBinding->isAlloca = true;
+            if(functionalEnvironment)
+            {
+                allocaBinding->isFrameLocal = true;
+                allocaBinding->frameDepth = functionalEnvironment->frameDepth;
+                allocaBinding->frameSlotIndex = functionalEnvironment->allocateFrameSlot();
+            }
+            analyzedAlloca->binding = allocaBinding;
             environment->addLocalSymbolBinding(localName, allocaBinding);
             return analyzedAlloca;
         }
@@ -904,18 +896,10 @@ namespace Sysmel
     class SyntaxBindPattern : public SyntacticValue
     {
     public:
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (pattern)
-            {
-                function(pattern);
-                pattern->traverseChildren(function);
-            }
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(pattern);
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -941,18 +925,10 @@ namespace Sysmel
             out << body->printString() << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (functionType)
-            {
-                function(functionType);
-                functionType->traverseChildren(function);
-            }
-            if (body)
-            {
-                function(body);
-                body->traverseChildren(function);
-            }
+            children.add(functionType);
+            children.add(body);
         }
 
         ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -976,18 +952,14 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (body)
-            {
-                function(body);
-                body->traverseChildren(function);
-            }
+            children.add(body);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
-            auto newEnvironment = std::make_shared<LexicalEnvironment>(environment, getSourcePosition());
+            auto newEnvironment = makeRef<LexicalEnvironment>(environment, getSourcePosition());
             return body->analyzeInEnvironment(newEnvironment);
         }
 
@@ -1012,6 +984,11 @@ namespace Sysmel
             out << ")";
         }
 
+        virtual void collectChildren(ChildList &children) const override
+        {
+            children.add(expressions);
+        }
+
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment)
         {
             std::vector<ValuePtr> analyzedElements;
@@ -1019,7 +996,7 @@ namespace Sysmel
             for (const auto &expression : expressions)
                 analyzedElements.push_back(expression->analyzeInEnvironment(environment));
 
-            auto semanticArray = std::make_shared<SemanticArray>();
+            auto semanticArray = makeRef<SemanticArray>();
             semanticArray->sourcePosition = sourcePosition;
             semanticArray->type = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Array");
             semanticArray->expressions = analyzedElements;
@@ -1047,6 +1024,11 @@ namespace Sysmel
             out << ")";
         }
 
+        virtual void collectChildren(ChildList &children) const override
+        {
+            children.add(byteExpressions);
+        }
+
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment)
         {
             std::vector<ValuePtr> analyzedBytes;
@@ -1054,7 +1036,7 @@ namespace Sysmel
             for (const auto &byteExpression : byteExpressions)
                 analyzedBytes.push_back(byteExpression->analyzeInEnvironment(environment));
 
-            auto semanticByteArray = std::make_shared<SemanticByteArray>();
+            auto semanticByteArray = makeRef<SemanticByteArray>();
             semanticByteArray->sourcePosition = sourcePosition;
             semanticByteArray->type = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("ByteArray");
             semanticByteArray->byteExpressions = analyzedBytes;
@@ -1080,11 +1062,11 @@ namespace Sysmel
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
             (void)environment;
-            auto floatObject = std::make_shared<Float>();
+            auto floatObject = makeRef<Float>();
             floatObject->clazz = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Float");
             floatObject->value = value;
 
-            auto semanticLiteral = std::make_shared<SemanticLiteralValue>();
+            auto semanticLiteral = makeRef<SemanticLiteralValue>();
             semanticLiteral->sourcePosition = sourcePosition;
             semanticLiteral->type = floatObject->clazz;
             semanticLiteral->value = floatObject;
@@ -1105,11 +1087,9 @@ namespace Sysmel
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment)
         {
             (void)environment;
-            auto integer = std::make_shared<Integer>();
-            integer->clazz = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Integer");
-            integer->value = value;
+            auto integer = Integer::make(value);
 
-            auto semanticLiteral = std::make_shared<SemanticLiteralValue>();
+            auto semanticLiteral = makeRef<SemanticLiteralValue>();
             semanticLiteral->sourcePosition = sourcePosition;
             semanticLiteral->type = integer->clazz;
             semanticLiteral->value = integer;
@@ -1130,11 +1110,11 @@ namespace Sysmel
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment)
         {
             (void)environment;
-            auto character = std::make_shared<Character>();
+            auto character = makeRef<Character>();
             character->clazz = IntrinsicsEnvironment::uniqueInstance()->lookupValidClass("Character");
             character->value = value;
 
-            auto semanticLiteral = std::make_shared<SemanticLiteralValue>();
+            auto semanticLiteral = makeRef<SemanticLiteralValue>();
             semanticLiteral->sourcePosition = sourcePosition;
             semanticLiteral->type = character->clazz;
             semanticLiteral->value = character;
@@ -1155,11 +1135,11 @@ namespace Sysmel
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
         {
             (void)environment;
-            auto string = std::make_shared<String>();
+            auto string = makeRef<String>();
             string->sourcePosition = sourcePosition;
             string->value = value;
 
-            auto semanticLiteral = std::make_shared<SemanticLiteralValue>();
+            auto semanticLiteral = makeRef<SemanticLiteralValue>();
             semanticLiteral->sourcePosition = sourcePosition;
             semanticLiteral->type = string->getClass();
             semanticLiteral->value = string;
@@ -1181,7 +1161,7 @@ namespace Sysmel
         {
             (void)environment;
             auto symbol = Symbol::internString(value);
-            auto semanticLiteral = std::make_shared<SemanticLiteralValue>();
+            auto semanticLiteral = makeRef<SemanticLiteralValue>();
             semanticLiteral->sourcePosition = sourcePosition;
             semanticLiteral->type = symbol->clazz;
             semanticLiteral->value = symbol;
@@ -1214,13 +1194,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            for (const auto &element : elements)
-            {
-                function(element);
-                element->traverseChildren(function);
-            }
+            children.add(elements);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override;
@@ -1244,18 +1220,10 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (receiver)
-            {
-                function(receiver);
-                receiver->traverseChildren(function);
-            }
-            for (const auto &element : messages)
-            {
-                function(element);
-                element->traverseChildren(function);
-            }
+            children.add(receiver);
+            children.add(messages);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override;
@@ -1279,18 +1247,10 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (selector)
-            {
-                function(selector);
-                selector->traverseChildren(function);
-            }
-            for (const auto &argument : arguments)
-            {
-                function(argument);
-                argument->traverseChildren(function);
-            }
+            children.add(selector);
+            children.add(arguments);
         }
 
         SyntaxMessageSendPtr asMessageSendWithReceiver(const ValuePtr &receiver);
@@ -1314,18 +1274,10 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (functional)
-            {
-                function(functional);
-                functional->traverseChildren(function);
-            }
-            for (const auto &argument : arguments)
-            {
-                function(argument);
-                argument->traverseChildren(function);
-            }
+            children.add(functional);
+            children.add(arguments);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1333,7 +1285,7 @@ namespace Sysmel
             auto analyzedFunctional = functional->analyzeInEnvironment(environment);
             if(analyzedFunctional->isMacro())
             {
-                auto context = std::make_shared<MacroContext> ();
+                auto context = makeRef<MacroContext> ();
                 context->environment = environment;
                 context->sourcePosition = sourcePosition;
                 auto expandedMacro = analyzedFunctional->applyMacroWithContextAndArguments(context, arguments);
@@ -1350,10 +1302,10 @@ namespace Sysmel
                 auto argument = arguments[i];
                 auto analyzedArgument = argument->analyzeInEnvironment(environment);
                 auto coercedArgument = argumentAnalysisContext->coerceArgumentWithIndex(i, analyzedArgument);
-                analyzedArguments.push_back(analyzedArgument);
+                analyzedArguments.push_back(coercedArgument);
             }
 
-            auto application = std::make_shared<SemanticApplication> ();
+            auto application = makeRef<SemanticApplication> ();
             application->sourcePosition = sourcePosition;
             application->type = argumentAnalysisContext->getResultType();
             application->functional = analyzedFunctional;
@@ -1366,7 +1318,7 @@ namespace Sysmel
         TokenKind kind;
     };
 
-    typedef std::shared_ptr<SyntaxMessageCascade> SyntaxMessageCascadePtr;
+    typedef Ref<SyntaxMessageCascade> SyntaxMessageCascadePtr;
 
     class SyntaxMessageSend : public SyntacticValue
     {
@@ -1391,35 +1343,23 @@ namespace Sysmel
 
         virtual SyntaxMessageCascadePtr asMessageCascade() const override
         {
-            auto firstMessage = std::make_shared<SyntaxMessageCascadeMessage>();
+            auto firstMessage = makeRef<SyntaxMessageCascadeMessage>();
             firstMessage->sourcePosition = sourcePosition;
             firstMessage->selector = selector;
             firstMessage->arguments = arguments;
 
-            auto messageCascade = std::make_shared<SyntaxMessageCascade>();
+            auto messageCascade = makeRef<SyntaxMessageCascade>();
             messageCascade->sourcePosition = sourcePosition;
             messageCascade->receiver = receiver;
             messageCascade->messages.push_back(firstMessage);
             return messageCascade;
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (receiver)
-            {
-                function(receiver);
-                receiver->traverseChildren(function);
-            }
-            if (selector)
-            {
-                function(selector);
-                selector->traverseChildren(function);
-            }
-            for (const auto &argument : arguments)
-            {
-                function(argument);
-                argument->traverseChildren(function);
-            }
+            children.add(receiver);
+            children.add(selector);
+            children.add(arguments);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override;
@@ -1440,13 +1380,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1468,13 +1404,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1496,13 +1428,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1524,13 +1452,9 @@ namespace Sysmel
             out << ")";
         }
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (value)
-            {
-                function(value);
-                value->traverseChildren(function);
-            }
+            children.add(value);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1549,23 +1473,11 @@ namespace Sysmel
         ValuePtr trueCase;
         ValuePtr falseCase;
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (condition)
-            {
-                function(condition);
-                condition->traverseChildren(function);
-            }
-            if (trueCase)
-            {
-                function(trueCase);
-                trueCase->traverseChildren(function);
-            }
-            if (falseCase)
-            {
-                function(falseCase);
-                falseCase->traverseChildren(function);
-            }
+            children.add(condition);
+            children.add(trueCase);
+            children.add(falseCase);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1576,14 +1488,14 @@ namespace Sysmel
             ValuePtr analyzedTrueCase;
             if(trueCase)
             {
-                auto lexicalEnvironment = std::make_shared<LexicalEnvironment> (environment, trueCase->sourcePosition);
+                auto lexicalEnvironment = makeRef<LexicalEnvironment> (environment, trueCase->sourcePosition);
                 analyzedTrueCase = trueCase->analyzeInEnvironment(lexicalEnvironment);
             }
 
             ValuePtr analyzedFalseCase;
             if(falseCase)
             {
-                auto lexicalEnvironment = std::make_shared<LexicalEnvironment> (environment, falseCase->sourcePosition);
+                auto lexicalEnvironment = makeRef<LexicalEnvironment> (environment, falseCase->sourcePosition);
                 analyzedFalseCase = falseCase->analyzeInEnvironment(lexicalEnvironment);
             }
             ValuePtr resultType = VoidType::uniqueInstance();
@@ -1603,7 +1515,8 @@ namespace Sysmel
                 }
             }
 
-            auto semanticIf = std::make_shared<SemanticIf> ();
+            auto semanticIf = makeRef<SemanticIf> ();
+            semanticIf->sourcePosition = sourcePosition;
             semanticIf->type = resultType;
             semanticIf->returnsValue = returnsValue;
             semanticIf->condition = analyzedCondition;
@@ -1620,23 +1533,11 @@ namespace Sysmel
         ValuePtr body;
         ValuePtr continueAction;
 
-        virtual void traverseChildren(const std::function<void(ValuePtr)> &function) const override
+        virtual void collectChildren(ChildList &children) const override
         {
-            if (condition)
-            {
-                function(condition);
-                condition->traverseChildren(function);
-            }
-            if (body)
-            {
-                function(body);
-                body->traverseChildren(function);
-            }
-            if (continueAction)
-            {
-                function(continueAction);
-                continueAction->traverseChildren(function);
-            }
+            children.add(condition);
+            children.add(body);
+            children.add(continueAction);
         }
 
         virtual ValuePtr analyzeInEnvironment(const EnvironmentPtr &environment) override
@@ -1645,16 +1546,22 @@ namespace Sysmel
             auto analyzedCondition = condition->analyzeInEnvironment(environment);
             analyzedCondition = analyzedCondition->coerceIntoExpectedTypeAt(booleanType, sourcePosition);
 
-            auto bodyEnvironment = std::make_shared<LexicalEnvironment> (environment, sourcePosition);
+            auto bodyEnvironment = makeRef<LexicalEnvironment> (environment, sourcePosition);
             auto analyzedBody = body->analyzeInEnvironment(bodyEnvironment);
             ValuePtr analyzedContinueAction;
             if(continueAction)
             {
-                auto continueActionEnvironment = std::make_shared<LexicalEnvironment> (environment, sourcePosition);
+                auto continueActionEnvironment = makeRef<LexicalEnvironment> (environment, sourcePosition);
                 analyzedContinueAction = continueAction->analyzeInEnvironment(continueActionEnvironment);
             }
 
-            abort();
+            auto semanticWhile = makeRef<SemanticWhile> ();
+            semanticWhile->sourcePosition = sourcePosition;
+            semanticWhile->type = VoidType::uniqueInstance();
+            semanticWhile->condition = analyzedCondition;
+            semanticWhile->body = analyzedBody;
+            semanticWhile->continueAction = analyzedContinueAction;
+            return semanticWhile;
         }
     };
 
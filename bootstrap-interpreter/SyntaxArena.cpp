@@ -0,0 +1,81 @@
+#include "SyntaxArena.hpp"
+#include "GarbageCollector.hpp"
+#include "Assert.hpp"
+#include <stdlib.h>
+#include <algorithm>
+
+namespace Sysmel
+{
+
+thread_local SyntaxArena *SyntaxArena::current;
+
+// Each node is preceded by the arena that owns it, which is null for the nodes that live in the garbage collector heap.
+struct SyntaxNodeHeader
+{
+    SyntaxArena *arena;
+};
+
+static constexpr size_t SyntaxNodeAlignment = alignof(SyntaxNodeHeader);
+
+SyntaxArena::~SyntaxArena()
+{
+    for(auto chunk : chunks)
+        free(chunk);
+}
+
+void *SyntaxArena::allocate(size_t size)
+{
+    auto allocationSize = (size + SyntaxNodeAlignment - 1) & (~(SyntaxNodeAlignment - 1));
+    if(size_t(bumpLimit - bumpPointer) < allocationSize)
+    {
+        // Chunks grow with the source, so that small sources do not reserve a large chunk.
+        auto chunkSize = std::max(std::min(std::max(MinimumChunkSize, reservedSize), MaximumChunkSize), allocationSize);
+        bumpPointer = reinterpret_cast<uint8_t*> (malloc(chunkSize));
+        sysmelAssert(bumpPointer);
+        bumpLimit = bumpPointer + chunkSize;
+        chunks.push_back(bumpPointer);
+        reservedSize += chunkSize;
+    }
+
+    auto result = bumpPointer;
+    bumpPointer += allocationSize;
+    highWaterMark += allocationSize;
+    ++allocatedNodeCount;
+    return result;
+}
+
+void *SyntaxArena::allocateNode(size_t size)
+{
+    auto allocationSize = sizeof(SyntaxNodeHeader) + size;
+    SyntaxNodeHeader *header;
+    if(current)
+    {
+        header = reinterpret_cast<SyntaxNodeHeader*> (current->allocate(allocationSize));
+        header->arena = current;
+        current->retainReference();
+    }
+    else
+    {
+        header = reinterpret_cast<SyntaxNodeHeader*> (GarbageCollector::allocate(allocationSize));
+        header->arena = nullptr;
+    }
+
+    return header + 1;
+}
+
+void SyntaxArena::deallocateNode(void *pointer, size_t size)
+{
+    auto header = reinterpret_cast<SyntaxNodeHeader*> (pointer) - 1;
+    if(header->arena)
+        header->arena->releaseReference();
+    else
+        GarbageCollector::deallocate(header, sizeof(SyntaxNodeHeader) + size);
+}
+
+void SyntaxArena::printStatisticsOn(FILE *out, const char *sourceName) const
+{
+    fprintf(out, "Syntax arena of %s: %zu nodes, high-water mark %zu bytes, reserved %zu bytes in %zu chunks\n",
+        sourceName, allocatedNodeCount, highWaterMark, reservedSize, chunks.size());
+}
+
+} // End of namespace Sysmel
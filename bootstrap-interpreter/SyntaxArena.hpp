@@ -0,0 +1,90 @@
+#ifndef SYSMEL_SYNTAX_ARENA_HPP
+#define SYSMEL_SYNTAX_ARENA_HPP
+
+#pragma once
+
+#include "Ref.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+namespace Sysmel
+{
+
+/**
+ * I am the arena where the syntax nodes that are parsed from a source code are
+ * allocated. Parsing bump allocates the nodes from my chunks, and deleting a node
+ * does not recycle its memory. Every node keeps me alive through my reference count,
+ * because syntax can escape through quotes and macros, and all of my chunks are
+ * released at once when the source code and the last node are gone.
+ */
+class SyntaxArena
+{
+public:
+    static constexpr size_t MinimumChunkSize = 4*1024;
+    static constexpr size_t MaximumChunkSize = 256*1024;
+
+    ~SyntaxArena();
+
+    // Syntax nodes are allocated from the current arena, or from the garbage collector heap when there is none.
+    static void *allocateNode(size_t size);
+    static void deallocateNode(void *pointer, size_t size);
+
+    void retainReference()
+    {
+        ++referenceCount;
+    }
+
+    void releaseReference()
+    {
+        if(--referenceCount == 0)
+            delete this;
+    }
+
+    size_t getHighWaterMark() const
+    {
+        return highWaterMark;
+    }
+
+    void printStatisticsOn(FILE *out, const char *sourceName) const;
+
+    /**
+     * I make an arena the current one during my lifetime.
+     */
+    class CurrentScope
+    {
+    public:
+        CurrentScope(SyntaxArena *arena)
+            : previousArena(current)
+        {
+            current = arena;
+        }
+
+        ~CurrentScope()
+        {
+            current = previousArena;
+        }
+
+    private:
+        SyntaxArena *previousArena;
+    };
+
+private:
+    void *allocate(size_t size);
+
+    static thread_local SyntaxArena *current;
+
+    std::vector<uint8_t*> chunks;
+    uint8_t *bumpPointer = nullptr;
+    uint8_t *bumpLimit = nullptr;
+    size_t referenceCount = 0;
+    size_t highWaterMark = 0;
+    size_t reservedSize = 0;
+    size_t allocatedNodeCount = 0;
+};
+
+typedef Ref<SyntaxArena> SyntaxArenaPtr;
+
+} // End of namespace Sysmel
+
+#endif //SYSMEL_SYNTAX_ARENA_HPP
@@ -16,14 +16,14 @@ std::vector<TypeUniversePtr> TypeUniverse::uniqueInstances;
 TypeUniversePtr TypeUniverse::uniqueInstanceForIndex(int index)
 {
     for(int currentIndex = 0; currentIndex <= index; ++currentIndex)
-        uniqueInstances.push_back(std::make_shared<TypeUniverse> (currentIndex));
+        uniqueInstances.push_back(makeRef<TypeUniverse> (currentIndex));
     return uniqueInstances[index];
 }
 
 // Generic type that ignores the universe index
 ValuePtr Type::getType()
 {
-    return std::static_pointer_cast<Type> (shared_from_this());
+    return staticRefCast<Type> (selfRef());
 }
 
 // Gradual type
@@ -36,7 +36,7 @@ GradualTypePtr GradualType::singletonValue;
 GradualTypePtr GradualType::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<GradualType> ();
+        singletonValue = makeRef<GradualType> ();
     return singletonValue;
 }
 
@@ -51,7 +51,7 @@ TypePtr Type::singletonValue;
 TypePtr Type::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<Type> ();
+        singletonValue = makeRef<Type> ();
     return singletonValue;
 }
 
@@ -60,7 +60,7 @@ UnitTypePtr UnitType::singletonValue;
 UnitTypePtr UnitType::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<UnitType> ();
+        singletonValue = makeRef<UnitType> ();
     return singletonValue;
 }
 
@@ -69,7 +69,7 @@ BottomTypePtr BottomType::singletonValue;
 BottomTypePtr BottomType::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<BottomType> ();
+        singletonValue = makeRef<BottomType> ();
     return singletonValue;
 }
 
@@ -78,7 +78,7 @@ VoidTypePtr VoidType::singletonValue;
 VoidTypePtr VoidType::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<VoidType> ();
+        singletonValue = makeRef<VoidType> ();
     return singletonValue;
 }
 
@@ -91,7 +91,7 @@ ValuePtr VoidValue::getType() const
 VoidValuePtr VoidValue::uniqueInstance()
 {
     if(!singletonValue)
-        singletonValue = std::make_shared<VoidValue> ();
+        singletonValue = makeRef<VoidValue> ();
     return singletonValue;
 }
 
@@ -109,7 +109,7 @@ ProductTypePtr ProductType::getOrCreateWithElementTypes(const std::vector<ValueP
     if(it != ProductTypeCache.end())
         return it->second;
 
-    auto newProductType = std::make_shared<ProductType> ();
+    auto newProductType = makeRef<ProductType> ();
     newProductType->elementTypes = elements;
     ProductTypeCache.insert(std::make_pair(elements, newProductType));
     return newProductType;
@@ -129,7 +129,7 @@ SumTypePtr SumType::getOrCreateWithAlternativeTypes(const std::vector<ValuePtr>
     if(it != SumTypeCache.end())
         return it->second;
 
-    auto newSumType = std::make_shared<SumType> ();
+    auto newSumType = makeRef<SumType> ();
     newSumType->alternativeTypes = alternatives;
     SumTypeCache.insert(std::make_pair(alternatives, newSumType));
     return newSumType;
@@ -156,7 +156,7 @@ void PiType::printStringOn(std::ostream &out) const
 
 ValuePtr PiType::reduce()
 {
-    return shared_from_this();
+    return selfRef();
 }
 
 void SimpleFunctionType::printStringOn(std::ostream &out) const
@@ -178,8 +178,8 @@ void SimpleFunctionType::printStringOn(std::ostream &out) const
 
 ArgumentTypeAnalysisContextPtr SimpleFunctionType::createArgumentTypeAnalysisContext()
 {
-    auto context = std::make_shared<SimpleFunctionArgumentTypeAnalysisContext> ();
-    context->simpleFunctionalType = std::static_pointer_cast<SimpleFunctionType> (shared_from_this());
+    auto context = makeRef<SimpleFunctionArgumentTypeAnalysisContext> ();
+    context->simpleFunctionalType = staticRefCast<SimpleFunctionType> (selfRef());
     return context;
 }
 ValuePtr SimpleFunctionArgumentTypeAnalysisContext::coerceArgumentWithIndex(size_t index, ValuePtr argument)
@@ -198,7 +198,7 @@ PointerTypePtr PointerType::make(ValuePtr baseType)
     if(it != PointerTypeCache.end())
         return it->second;
     
-    auto pointerType = std::make_shared<PointerType> ();
+    auto pointerType = makeRef<PointerType> ();
     pointerType->baseType = baseType;
     return pointerType;
 }
@@ -210,7 +210,7 @@ ValuePtr ReferenceLikeType::analyzeSyntaxMessageSendOfInstance(const SyntaxMessa
     auto analyzedSelectorSymbol = analyzedSelector->asAnalyzedSymbolValue();
     if(analyzedSelectorSymbol->isSymbolWithValue(":=") && messageSend->arguments.size() == 1)
     {
-        auto storeValue = std::make_shared<SyntaxStoreValue> ();
+        auto storeValue = makeRef<SyntaxStoreValue> ();
         storeValue->sourcePosition = messageSend->sourcePosition;
         storeValue->pointer = analyzedReceiver;
         storeValue->value = messageSend->arguments[0];
@@ -221,12 +221,12 @@ ValuePtr ReferenceLikeType::analyzeSyntaxMessageSendOfInstance(const SyntaxMessa
         abort();        
     }
 
-    auto loadedReceiver = std::make_shared<SyntaxLoadValue> ();
+    auto loadedReceiver = makeRef<SyntaxLoadValue> ();
     loadedReceiver->sourcePosition = messageSend->sourcePosition;
     loadedReceiver->pointer = analyzedReceiver;
     loadedReceiver->type = baseType;
 
-    auto newMessageSend = std::make_shared<SyntaxMessageSend> ();
+    auto newMessageSend = makeRef<SyntaxMessageSend> ();
     newMessageSend->sourcePosition = messageSend->sourcePosition;
     newMessageSend->receiver = loadedReceiver;
     newMessageSend->selector = analyzedSelector;
@@ -241,7 +241,7 @@ ReferenceTypePtr ReferenceType::make(ValuePtr baseType)
     if(it != ReferenceTypeCache.end())
         return it->second;
     
-    auto refType = std::make_shared<ReferenceType> ();
+    auto refType = makeRef<ReferenceType> ();
     refType->baseType = baseType;
     return refType;
 }
@@ -251,7 +251,7 @@ std::map<ValuePtr, ReferenceTypePtr> ReferenceType::ReferenceTypeCache;
 PrimitiveUInt8TypePtr PrimitiveUInt8Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveUInt8Type> ();
+        singleton = makeRef<PrimitiveUInt8Type> ();
     return singleton;
 }
 
@@ -260,7 +260,7 @@ PrimitiveUInt8TypePtr PrimitiveUInt8Type::singleton;
 PrimitiveUInt16TypePtr PrimitiveUInt16Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveUInt16Type> ();
+        singleton = makeRef<PrimitiveUInt16Type> ();
     return singleton;
 }
 
@@ -269,7 +269,7 @@ PrimitiveUInt16TypePtr PrimitiveUInt16Type::singleton;
 PrimitiveUInt32TypePtr PrimitiveUInt32Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveUInt32Type> ();
+        singleton = makeRef<PrimitiveUInt32Type> ();
     return singleton;
 }
 
@@ -278,7 +278,7 @@ PrimitiveUInt32TypePtr PrimitiveUInt32Type::singleton;
 PrimitiveUInt64TypePtr PrimitiveUInt64Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveUInt64Type> ();
+        singleton = makeRef<PrimitiveUInt64Type> ();
     return singleton;
 }
 
@@ -288,7 +288,7 @@ PrimitiveUInt64TypePtr PrimitiveUInt64Type::singleton;
 PrimitiveInt8TypePtr PrimitiveInt8Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveInt8Type> ();
+        singleton = makeRef<PrimitiveInt8Type> ();
     return singleton;
 }
 
@@ -297,7 +297,7 @@ PrimitiveInt8TypePtr PrimitiveInt8Type::singleton;
 PrimitiveInt16TypePtr PrimitiveInt16Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveInt16Type> ();
+        singleton = makeRef<PrimitiveInt16Type> ();
     return singleton;
 }
 
@@ -306,7 +306,7 @@ PrimitiveInt16TypePtr PrimitiveInt16Type::singleton;
 PrimitiveInt32TypePtr PrimitiveInt32Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveInt32Type> ();
+        singleton = makeRef<PrimitiveInt32Type> ();
     return singleton;
 }
 
@@ -315,7 +315,7 @@ PrimitiveInt32TypePtr PrimitiveInt32Type::singleton;
 PrimitiveInt64TypePtr PrimitiveInt64Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveInt64Type> ();
+        singleton = makeRef<PrimitiveInt64Type> ();
     return singleton;
 }
 
@@ -324,7 +324,7 @@ PrimitiveInt64TypePtr PrimitiveInt64Type::singleton;
 PrimitiveChar8TypePtr PrimitiveChar8Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveChar8Type> ();
+        singleton = makeRef<PrimitiveChar8Type> ();
     return singleton;
 }
 
@@ -333,7 +333,7 @@ PrimitiveChar8TypePtr PrimitiveChar8Type::singleton;
 PrimitiveChar16TypePtr PrimitiveChar16Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveChar16Type> ();
+        singleton = makeRef<PrimitiveChar16Type> ();
     return singleton;
 }
 
@@ -342,7 +342,7 @@ PrimitiveChar16TypePtr PrimitiveChar16Type::singleton;
 PrimitiveChar32TypePtr PrimitiveChar32Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveChar32Type> ();
+        singleton = makeRef<PrimitiveChar32Type> ();
     return singleton;
 }
 
@@ -351,7 +351,7 @@ PrimitiveChar32TypePtr PrimitiveChar32Type::singleton;
 PrimitiveFloat32TypePtr PrimitiveFloat32Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveFloat32Type> ();
+        singleton = makeRef<PrimitiveFloat32Type> ();
     return singleton;
 }
 
@@ -360,7 +360,7 @@ PrimitiveFloat32TypePtr PrimitiveFloat32Type::singleton;
 PrimitiveFloat64TypePtr PrimitiveFloat64Type::uniqueInstance()
 {
     if(!singleton)
-        singleton = std::make_shared<PrimitiveFloat64Type> ();
+        singleton = makeRef<PrimitiveFloat64Type> ();
     return singleton;
 }
 
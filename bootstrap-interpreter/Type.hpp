@@ -2,44 +2,46 @@
 #define SYSMEL_TYPE_HPP
 
 #include "Value.hpp"
+#include "InlineCache.hpp"
+#include "MethodLookupCache.hpp"
 #include <sstream>
 #include <vector>
 
 namespace Sysmel
 {
 
-typedef std::shared_ptr<class TypeUniverse> TypeUniversePtr;
-typedef std::shared_ptr<class GradualType>  GradualTypePtr;
-typedef std::shared_ptr<class UnitType>     UnitTypePtr;
-typedef std::shared_ptr<class BottomType>   BottomTypePtr;
-typedef std::shared_ptr<class VoidValue>    VoidValuePtr;
-typedef std::shared_ptr<class VoidType>     VoidTypePtr;
-typedef std::shared_ptr<class ProductType>  ProductTypePtr;
-typedef std::shared_ptr<class SumType>      SumTypePtr;
-typedef std::shared_ptr<class FunctionType> FunctionTypePtr;
-typedef std::shared_ptr<class ObjectType>   ObjectTypePtr;
-typedef std::shared_ptr<class Symbol>       SymbolPtr;
+typedef Ref<class TypeUniverse> TypeUniversePtr;
+typedef Ref<class GradualType>  GradualTypePtr;
+typedef Ref<class UnitType>     UnitTypePtr;
+typedef Ref<class BottomType>   BottomTypePtr;
+typedef Ref<class VoidValue>    VoidValuePtr;
+typedef Ref<class VoidType>     VoidTypePtr;
+typedef Ref<class ProductType>  ProductTypePtr;
+typedef Ref<class SumType>      SumTypePtr;
+typedef Ref<class FunctionType> FunctionTypePtr;
+typedef Ref<class ObjectType>   ObjectTypePtr;
+typedef Ref<class Symbol>       SymbolPtr;
 
-typedef std::shared_ptr<class PointerLikeType> PointerLikeTypePtr;
-typedef std::shared_ptr<class PointerType>     PointerTypePtr;
-typedef std::shared_ptr<class ReferenceType>   ReferenceTypePtr;
+typedef Ref<class PointerLikeType> PointerLikeTypePtr;
+typedef Ref<class PointerType>     PointerTypePtr;
+typedef Ref<class ReferenceType>   ReferenceTypePtr;
 
-typedef std::shared_ptr<class PrimitiveUInt8Type>  PrimitiveUInt8TypePtr;
-typedef std::shared_ptr<class PrimitiveUInt16Type> PrimitiveUInt16TypePtr;
-typedef std::shared_ptr<class PrimitiveUInt32Type> PrimitiveUInt32TypePtr;
-typedef std::shared_ptr<class PrimitiveUInt64Type> PrimitiveUInt64TypePtr;
+typedef Ref<class PrimitiveUInt8Type>  PrimitiveUInt8TypePtr;
+typedef Ref<class PrimitiveUInt16Type> PrimitiveUInt16TypePtr;
+typedef Ref<class PrimitiveUInt32Type> PrimitiveUInt32TypePtr;
+typedef Ref<class PrimitiveUInt64Type> PrimitiveUInt64TypePtr;
 
-typedef std::shared_ptr<class PrimitiveInt8Type>  PrimitiveInt8TypePtr;
-typedef std::shared_ptr<class PrimitiveInt16Type> PrimitiveInt16TypePtr;
-typedef std::shared_ptr<class PrimitiveInt32Type> PrimitiveInt32TypePtr;
-typedef std::shared_ptr<class PrimitiveInt64Type> PrimitiveInt64TypePtr;
+typedef Ref<class PrimitiveInt8Type>  PrimitiveInt8TypePtr;
+typedef Ref<class PrimitiveInt16Type> PrimitiveInt16TypePtr;
+typedef Ref<class PrimitiveInt32Type> PrimitiveInt32TypePtr;
+typedef Ref<class PrimitiveInt64Type> PrimitiveInt64TypePtr;
 
-typedef std::shared_ptr<class PrimitiveChar8Type>  PrimitiveChar8TypePtr;
-typedef std::shared_ptr<class PrimitiveChar16Type> PrimitiveChar16TypePtr;
-typedef std::shared_ptr<class PrimitiveChar32Type> PrimitiveChar32TypePtr;
+typedef Ref<class PrimitiveChar8Type>  PrimitiveChar8TypePtr;
+typedef Ref<class PrimitiveChar16Type> PrimitiveChar16TypePtr;
+typedef Ref<class PrimitiveChar32Type> PrimitiveChar32TypePtr;
 
-typedef std::shared_ptr<class PrimitiveFloat32Type> PrimitiveFloat32TypePtr;
-typedef std::shared_ptr<class PrimitiveFloat64Type> PrimitiveFloat64TypePtr;
+typedef Ref<class PrimitiveFloat32Type> PrimitiveFloat32TypePtr;
+typedef Ref<class PrimitiveFloat64Type> PrimitiveFloat64TypePtr;
 
 
 class TypeBehavior : public Value
@@ -64,11 +66,32 @@ public:
 
     virtual ValuePtr lookupSelector(const ValuePtr &selector) override
     {
+        auto method = MethodLookupCache::lookup(this, selector);
+        if (method)
+            return method;
+
         auto it = methodDict.find(selector);
-        return it != methodDict.end() ? it->second : nullptr;
+        if (it == methodDict.end())
+            return nullptr;
+
+        MethodLookupCache::store(selfRef(), selector, it->second);
+        return it->second;
+    }
+
+    void addMethodWithSelector(const ValuePtr &selector, const ValuePtr &method)
+    {
+        methodDict[selector] = method;
+        MethodLookupCache::flushSelector(selector);
+        InlineCache::invalidateAll();
     }
 
-    virtual ValuePtr asTypeValue() { return shared_from_this(); }
+    virtual ValuePtr asTypeValue() { return selfRef(); }
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(methodDict);
+    }
 
     std::map<ValuePtr, ValuePtr> methodDict;
 };
@@ -122,7 +145,7 @@ public:
 class UnitType : public BasicType
 {
 public:
-    virtual ValuePtr asTypeValue() { return shared_from_this(); }
+    virtual ValuePtr asTypeValue() { return selfRef(); }
 
     virtual void printStringOn(std::ostream &out) const override
     {
@@ -178,7 +201,7 @@ private:
 class GradualType : public BasicType
 {
 public:
-    virtual ValuePtr asTypeValue() { return shared_from_this(); }
+    virtual ValuePtr asTypeValue() { return selfRef(); }
 
     virtual bool isType() const override { return true; }
     virtual bool isGradualType() const {return true;}
@@ -214,6 +237,13 @@ public:
         out << ")";
     }
     
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(type);
+        visitor.visit(elements);
+    }
+
     ProductTypePtr type;
     std::vector<ValuePtr> elements;
 };
@@ -238,6 +268,12 @@ public:
         out << ')';
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        TypeBehavior::visitSlots(visitor);
+        visitor.visit(elementTypes);
+    }
+
     std::vector<ValuePtr> elementTypes;
 private:
     static std::map<std::vector<ValuePtr>, ProductTypePtr> ProductTypeCache;
@@ -255,6 +291,13 @@ public:
         out << ")";
     }
     
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(type);
+        visitor.visit(element);
+    }
+
     SumTypePtr type;
     uint32_t caseIndex;
     ValuePtr element;
@@ -280,6 +323,12 @@ public:
         out << ')';
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        TypeBehavior::visitSlots(visitor);
+        visitor.visit(alternativeTypes);
+    }
+
     std::vector<ValuePtr> alternativeTypes;
 private:
     static std::map<std::vector<ValuePtr>, SumTypePtr> SumTypeCache;
@@ -292,33 +341,49 @@ public:
 
     ValuePtr reduce();
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        TypeBehavior::visitSlots(visitor);
+        visitor.visit(nameExpression);
+        visitor.visit(arguments);
+        visitor.visit(resultType);
+    }
+
     ValuePtr nameExpression;
     std::vector<SymbolArgumentBindingPtr> arguments;
     ValuePtr resultType;
 };
 
 
-typedef std::shared_ptr<class SimpleFunctionType> SimpleFunctionTypePtr;
+typedef Ref<class SimpleFunctionType> SimpleFunctionTypePtr;
 class SimpleFunctionType : public TypeBehavior
 {
 public:
     virtual void printStringOn(std::ostream &out) const override;
     virtual ArgumentTypeAnalysisContextPtr createArgumentTypeAnalysisContext();
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        TypeBehavior::visitSlots(visitor);
+        visitor.visit(argumentTypes);
+        visitor.visit(argumentNames);
+        visitor.visit(resultType);
+    }
+
     std::vector<ValuePtr> argumentTypes;
     std::vector<SymbolPtr> argumentNames;
     ValuePtr resultType;
 
     static SimpleFunctionTypePtr make(const ValuePtr &resultType)
     {
-        auto functionalType = std::make_shared<SimpleFunctionType> ();
+        auto functionalType = makeRef<SimpleFunctionType> ();
         functionalType->resultType = resultType;
         return functionalType;
     }
 
     static SimpleFunctionTypePtr make(const ValuePtr &arg0Type, const std::string &arg0Name, const ValuePtr &resultType)
     {
-        auto functionalType = std::make_shared<SimpleFunctionType> ();
+        auto functionalType = makeRef<SimpleFunctionType> ();
         functionalType->argumentTypes.push_back(arg0Type);
         functionalType->argumentNames.push_back(Symbol::internString(arg0Name));
         functionalType->resultType = resultType;
@@ -330,7 +395,7 @@ public:
         const ValuePtr &arg1Type, const std::string &arg1Name,
         const ValuePtr &resultType)
     {
-        auto functionalType = std::make_shared<SimpleFunctionType> ();
+        auto functionalType = makeRef<SimpleFunctionType> ();
         functionalType->argumentTypes.push_back(arg0Type);
         functionalType->argumentNames.push_back(Symbol::internString(arg0Name));
         functionalType->argumentTypes.push_back(arg1Type);
@@ -345,7 +410,7 @@ public:
         const ValuePtr &arg2Type, const std::string &arg2Name,
         const ValuePtr &resultType)
     {
-        auto functionalType = std::make_shared<SimpleFunctionType> ();
+        auto functionalType = makeRef<SimpleFunctionType> ();
         functionalType->argumentTypes.push_back(arg0Type);
         functionalType->argumentNames.push_back(Symbol::internString(arg0Name));
         functionalType->argumentTypes.push_back(arg1Type);
@@ -363,7 +428,7 @@ public:
         const ValuePtr &arg3Type, const std::string &arg3Name,
         const ValuePtr &resultType)
     {
-        auto functionalType = std::make_shared<SimpleFunctionType> ();
+        auto functionalType = makeRef<SimpleFunctionType> ();
         functionalType->argumentTypes.push_back(arg0Type);
         functionalType->argumentNames.push_back(Symbol::internString(arg0Name));
         functionalType->argumentTypes.push_back(arg1Type);
@@ -377,7 +442,7 @@ public:
     }
 };
 
-typedef std::shared_ptr<class SimpleFunctionType> SimpleFunctionTypePtr;
+typedef Ref<class SimpleFunctionType> SimpleFunctionTypePtr;
 class PrimitiveType : public TypeBehavior
 {
 public:
@@ -391,6 +456,12 @@ public:
         return true;
     }
 
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        PrimitiveType::visitSlots(visitor);
+        visitor.visit(baseType);
+    }
+
     ValuePtr baseType;
 };
 
@@ -443,6 +514,8 @@ private:
 class PrimitiveNumberType : public PrimitiveType
 {
 public:
+    virtual bool isPrimitiveNumberType() const override { return true; }
+
     virtual bool isSigned() const = 0;
     virtual bool isCharacter() const = 0;
     virtual bool isFloatingPoint() const = 0;
@@ -1,6 +1,9 @@
 #include "Assert.cpp"
 #include "LargeInteger.cpp"
+#include "Source.cpp"
 #include "Scanner.cpp"
+#include "GarbageCollector.cpp"
+#include "SyntaxArena.cpp"
 #include "Value.cpp"
 #include "Type.cpp"
 #include "Object.cpp"
@@ -10,4 +13,10 @@
 #include "Namespace.cpp"
 #include "Module.cpp"
 #include "Semantics.cpp"
+#include "ConstantFolding.cpp"
+#include "Bytecode.cpp"
+#include "BytecodeCompiler.cpp"
+#include "InlineCache.cpp"
+#include "MethodLookupCache.cpp"
+#include "BytecodeInterpreter.cpp"
 #include "Main.cpp"
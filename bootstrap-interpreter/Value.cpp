@@ -2,12 +2,16 @@
 #include "Type.hpp"
 #include "Syntax.hpp"
 #include "Semantics.hpp"
+#include "Bytecode.hpp"
+#include <algorithm>
 #include <exception>
 #include <sstream>
 
 namespace Sysmel
 {
-    
+
+thread_local size_t Value::allocatedInstanceCount = 0;
+
 ValuePtr Value::getType() const
 {
     return GradualType::uniqueInstance();
@@ -33,7 +37,7 @@ ValuePtr Value::performWithArguments(const ValuePtr &selector, const std::vector
             throwExceptionWithMessage("Cannot send a message to something without a type or a class.");
     }
 
-    return typeOrClass->performWithArgumentsOnInstance(shared_from_this(), selector, arguments);
+    return typeOrClass->performWithArgumentsOnInstance(selfRef(), selector, arguments);
 }
 
 ValuePtr Value::performWithArgumentsOnInstance(const ValuePtr &receiver, const ValuePtr &selector, const std::vector<ValuePtr> &arguments)
@@ -86,7 +90,7 @@ ValuePtr Value::lookupSelector(const ValuePtr &selector)
 ValuePtr Value::analyzeInEnvironment(const EnvironmentPtr &environment)
 {
     (void)environment;
-    return shared_from_this();
+    return selfRef();
 }
 
 SymbolArgumentBindingPtr Value::analyzeArgumentInEnvironment(const EnvironmentPtr &environment)
@@ -98,29 +102,39 @@ SymbolArgumentBindingPtr Value::analyzeArgumentInEnvironment(const EnvironmentPt
 ValuePtr Value::analyzeInEnvironmentForMacroExpansionOnly(const EnvironmentPtr &environment)
 {
     (void)environment;
-    return shared_from_this();
+    return selfRef();
 }
 
 ValuePtr Value::evaluateInEnvironment(const EnvironmentPtr &environment)
 {
     (void)environment;
-    return shared_from_this();
+    return selfRef();
 }
 
 ValuePtr Value::analyzeAndEvaluateInEnvironment(const EnvironmentPtr &environment)
 {
-    return analyzeInEnvironment(environment)->evaluateInEnvironment(environment);
+    return evaluateAnalyzedValueInEnvironment(analyzeInEnvironment(environment)->foldConstants(), environment);
+}
+
+ValuePtr Value::foldConstants()
+{
+    return selfRef();
+}
+
+ValuePtr Value::markTailPosition()
+{
+    return selfRef();
 }
 
 ValuePtr Value::analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment)
 {
     (void)environment;
     if (isSemanticValue())
-        return shared_from_this();
+        return selfRef();
 
-    auto literal = std::make_shared<SemanticLiteralValue> ();
+    auto literal = makeRef<SemanticLiteralValue> ();
     literal->sourcePosition = syntaxNode->getSourcePosition();
-    literal->value = shared_from_this();
+    literal->value = selfRef();
     return literal;
 }
 
@@ -135,7 +149,7 @@ bool Value::parseAndUnpackArgumentsPattern(std::vector<ValuePtr> &argumentNodes,
 
 bool Value::isSatisfiedByType(const ValuePtr &sourceType)
 {
-    auto self = shared_from_this();
+    auto self = selfRef();
     return sourceType->isSubclassOf(self) || sourceType->isSubtypeOf(self);
 }
 
@@ -152,15 +166,34 @@ bool Value::isSubtypeOf(const ValuePtr &targetSupertype)
 ValuePtr Value::coerceIntoExpectedTypeAt(const ValuePtr &targetType, const SourcePositionPtr &coercionLocation)
 {
     auto myType = getTypeOrClass();
+    if(myType->isSemanticLiteralValue() && myType->asTypeValue())
+        myType = myType->asTypeValue();
     if(myType == targetType || myType->isGradualType() || targetType->isGradualType())
-        return shared_from_this();
+        return selfRef();
+
+    // References decay into their loaded value.
+    if(myType->isReferenceLikeType() && !targetType->isReferenceLikeType())
+    {
+        auto loadValue = makeRef<SemanticLoadValue> ();
+        loadValue->sourcePosition = getSourcePosition();
+        loadValue->pointer = selfRef();
+        loadValue->type = myType->getDecayedType();
+        return loadValue->coerceIntoExpectedTypeAt(targetType, coercionLocation);
+    }
+
+    // Type expressions that were analyzed into literals stand for their value.
+    auto expectedType = targetType;
+    if(expectedType->isSemanticLiteralValue() && expectedType->asTypeValue())
+        expectedType = expectedType->asTypeValue();
+    if(myType == expectedType)
+        return selfRef();
 
-    if(!targetType->isSatisfiedByType(myType))
+    if(!expectedType->isSatisfiedByType(myType))
     {
         throwExceptionWithMessageAt(("Cannot coerce value of type " + myType->printString() + " into " + targetType->printString()).c_str(), coercionLocation);
     }
 
-    return shared_from_this();
+    return selfRef();
 }
 
 bool Value::isSymbolWithValue(const char *expectedValue)
@@ -171,7 +204,7 @@ bool Value::isSymbolWithValue(const char *expectedValue)
 
 ValuePtr Value::analyzeSyntaxMessageSendOfInstance(const SyntaxMessageSendPtr &messageSend, const EnvironmentPtr &environment, const ValuePtr &analyzedReceiver, const ValuePtr &analyzedSelector)
 {
-    return messageSend->analyzeOrdinarySendWithReceiverTypeAndSelector(shared_from_this(), environment, analyzedReceiver, analyzedSelector);
+    return messageSend->analyzeOrdinarySendWithReceiverTypeAndSelector(selfRef(), environment, analyzedReceiver, analyzedSelector);
 }
 
 
@@ -182,7 +215,7 @@ ValuePtr Value::getClass() const
 
 ArgumentTypeAnalysisContextPtr Value::createArgumentTypeAnalysisContext()
 {
-    return std::make_shared<ArgumentTypeAnalysisContext> ();
+    return makeRef<ArgumentTypeAnalysisContext> ();
 }
 
 ValuePtr ArgumentTypeAnalysisContext::coerceArgumentWithIndex(size_t index, ValuePtr argument)
@@ -209,26 +242,87 @@ ValuePtr LambdaValue::getType() const
     return type;
 }
 
+static ValuePtr tailCallMarker = makeRef<Value> ();
+static ValuePtr pendingTailCallFunctional;
+static std::vector<ValuePtr> pendingTailCallArguments;
+static size_t activeLambdaApplicationCount = 0;
+
+ValuePtr LambdaValue::requestTailCall(const ValuePtr &functional, std::vector<ValuePtr> &&arguments)
+{
+    // The marker can only be returned to a lambda application, which performs the pending call before the next one.
+    sysmelAssert(activeLambdaApplicationCount > 0 && !pendingTailCallFunctional);
+    pendingTailCallFunctional = functional;
+    pendingTailCallArguments = std::move(arguments);
+    return tailCallMarker;
+}
+
+// I count the lambda applications in the stack, including the ones that are left by an exception.
+struct LambdaApplicationScope
+{
+    LambdaApplicationScope()
+    {
+        ++activeLambdaApplicationCount;
+    }
+
+    ~LambdaApplicationScope()
+    {
+        --activeLambdaApplicationCount;
+    }
+};
+
 ValuePtr LambdaValue::applyWithArguments(const std::vector<ValuePtr> &arguments)
+{
+    auto lambda = LambdaValuePtr(this);
+    FunctionalActivationEnvironmentPtr activationEnvironment;
+    std::vector<ValuePtr> tailCallArguments;
+    auto currentArguments = &arguments;
+    LambdaApplicationScope applicationScope;
+    for(;;)
+    {
+        GarbageCollector::safepoint();
+
+        auto result = lambda->evaluateBodyWithArguments(*currentArguments, activationEnvironment);
+        if(result != tailCallMarker)
+        {
+            sysmelAssert(!pendingTailCallFunctional);
+            return result;
+        }
+
+        // The activation can be reused by a tail call onto the same lambda, unless a closure captured it.
+        if(pendingTailCallFunctional != lambda || activationEnvironment->getReferenceCount() != 1)
+            activationEnvironment.reset();
+
+        auto nextFunctional = std::move(pendingTailCallFunctional);
+        tailCallArguments = std::move(pendingTailCallArguments);
+        currentArguments = &tailCallArguments;
+        if(!nextFunctional->isLambdaValue())
+            return nextFunctional->applyWithArguments(tailCallArguments);
+
+        lambda = staticRefCast<LambdaValue> (std::move(nextFunctional));
+    }
+}
+
+ValuePtr LambdaValue::evaluateBodyWithArguments(const std::vector<ValuePtr> &arguments, FunctionalActivationEnvironmentPtr &activationEnvironment)
 {
     auto expectedArgumentCount = argumentBindings.size();
     auto receivedArgumentCount = arguments.size();
     if(expectedArgumentCount != receivedArgumentCount)
         throwExceptionWithMessage("Lambda argument count mismatch.");
 
-    auto activationEnvironment = std::make_shared<FunctionalActivationEnvironment> (closure, sourcePosition);
-    if(fixpointBinding)
-        activationEnvironment->setFixpointBindingValue(fixpointBinding, shared_from_this());
+    if(activationEnvironment)
+        std::fill(activationEnvironment->slots.begin(), activationEnvironment->slots.end(), nullptr);
+    else
+        activationEnvironment = makeRef<FunctionalActivationEnvironment> (closure, sourcePosition, frameSize);
+
     for(size_t i = 0; i < argumentBindings.size(); ++i)
-    {
-        auto binding = argumentBindings[i];
-        auto argument = arguments[i];
-        activationEnvironment->forArgumentBindingSetValue(binding, argument);
-    }
+        activationEnvironment->slots[argumentBindings[i]->frameSlotIndex] = arguments[i];
+    if(fixpointBinding)
+        activationEnvironment->slots[fixpointBinding->frameSlotIndex] = selfRef();
+
+    if(bytecode)
+        return evaluateBytecodeFunctionInEnvironment(*bytecode, activationEnvironment);
 
-    auto lexicalEnvironment = std::make_shared<LexicalEnvironment> (activationEnvironment, sourcePosition);
-    auto result = body->evaluateInEnvironment(lexicalEnvironment);
-    return result;
+    return body->evaluateInEnvironment(activationEnvironment);
 }
 
 } // End of namespace Sysmel
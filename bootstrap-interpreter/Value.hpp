@@ -4,39 +4,142 @@
 #pragma once
 
 #include "Source.hpp"
-#include <memory>
+#include "Ref.hpp"
+#include "GarbageCollector.hpp"
 #include <string>
-#include <functional>
 #include <vector>
+#include <algorithm>
 #include <sstream>
 
 namespace Sysmel
 {
 
-typedef std::shared_ptr<class Value> ValuePtr;
-typedef std::shared_ptr<class Class> ClassPtr;
-typedef std::weak_ptr<class Class> ClassWeakPtr;
-typedef std::shared_ptr<class Type> TypePtr;
-typedef std::shared_ptr<class Object> ObjectPtr;
-typedef std::shared_ptr<class Symbol> SymbolPtr;
-typedef std::shared_ptr<class Environment> EnvironmentPtr;
-typedef std::shared_ptr<class SyntacticValue> SyntacticValuePtr;
-typedef std::shared_ptr<class SourcePosition> SourcePositionPtr; 
-typedef std::shared_ptr<class SyntaxError> SyntaxErrorPtr; 
-typedef std::shared_ptr<class SyntaxMessageSend> SyntaxMessageSendPtr;
-typedef std::shared_ptr<class SyntaxMessageCascade> SyntaxMessageCascadePtr;
-typedef std::shared_ptr<class SymbolArgumentBinding> SymbolArgumentBindingPtr;
-typedef std::shared_ptr<class SymbolFixpointBinding> SymbolFixpointBindingPtr;
-typedef std::shared_ptr<class ArgumentTypeAnalysisContext> ArgumentTypeAnalysisContextPtr;
-typedef std::shared_ptr<class MacroContext> MacroContextPtr;
-typedef std::shared_ptr<class SimpleFunctionType> SimpleFunctionTypePtr;
-
-class Value : public std::enable_shared_from_this<Value>
+typedef Ref<class Value> ValuePtr;
+typedef Ref<class Class> ClassPtr;
+typedef Ref<class Type> TypePtr;
+typedef Ref<class Object> ObjectPtr;
+typedef Ref<class Symbol> SymbolPtr;
+typedef Ref<class Environment> EnvironmentPtr;
+typedef Ref<class SyntacticValue> SyntacticValuePtr;
+typedef Ref<class SourcePosition> SourcePositionPtr; 
+typedef Ref<class SyntaxError> SyntaxErrorPtr; 
+typedef Ref<class SyntaxMessageSend> SyntaxMessageSendPtr;
+typedef Ref<class SyntaxMessageCascade> SyntaxMessageCascadePtr;
+typedef Ref<class SymbolArgumentBinding> SymbolArgumentBindingPtr;
+typedef Ref<class SymbolFixpointBinding> SymbolFixpointBindingPtr;
+typedef Ref<class ArgumentTypeAnalysisContext> ArgumentTypeAnalysisContextPtr;
+typedef Ref<class MacroContext> MacroContextPtr;
+typedef Ref<class SimpleFunctionType> SimpleFunctionTypePtr;
+typedef Ref<class BytecodeFunction> BytecodeFunctionPtr;
+typedef Ref<class LambdaValue> LambdaValuePtr;
+typedef Ref<class FunctionalActivationEnvironment> FunctionalActivationEnvironmentPtr;
+
+class BytecodeCompiler;
+enum class PrimitiveNumberKind : uint8_t;
+
+/**
+ * I collect the children of a syntax or a semantic node. The nodes only append
+ * their direct children, as plain pointers, so that no reference count is
+ * touched. The walks over a whole tree are built on top of me by
+ * Value::traverseChildren, which calls its function without any indirection.
+ */
+class ChildList
 {
 public:
-    Value() = default;
-    Value(const Value &other) = default;
-    virtual ~Value() = default;
+    ChildList(std::vector<Value*> &initialNodes)
+        : nodes(initialNodes) {}
+
+    template<typename T>
+    void add(const Ref<T> &child)
+    {
+        if(child)
+            nodes.push_back(child.get());
+    }
+
+    template<typename T>
+    void add(const std::vector<Ref<T>> &children)
+    {
+        for(auto &child : children)
+            add(child);
+    }
+
+private:
+    std::vector<Value*> &nodes;
+};
+
+/**
+ * I am the root of the object model. I carry an intrusive reference count
+ * that is manipulated through Ref, so that every value is a single allocation.
+ * The cycles that are left behind by the reference count are found by the GarbageCollector.
+ */
+class Value
+{
+public:
+    Value()
+    {
+        ++allocatedInstanceCount;
+        GarbageCollector::registerValue(this);
+    }
+
+    Value(const Value &other)
+        : sourcePosition(other.sourcePosition)
+    {
+        ++allocatedInstanceCount;
+        GarbageCollector::registerValue(this);
+    }
+
+    virtual ~Value()
+    {
+        GarbageCollector::unregisterValue(this);
+    }
+
+    static void *operator new(size_t size)
+    {
+        return GarbageCollector::allocate(size);
+    }
+
+    static void operator delete(void *pointer, size_t size)
+    {
+        GarbageCollector::deallocate(pointer, size);
+    }
+
+    Value &operator=(const Value &other)
+    {
+        sourcePosition = other.sourcePosition;
+        return *this;
+    }
+
+    void retainReference()
+    {
+        ++referenceCount;
+    }
+
+    void releaseReference()
+    {
+        if(--referenceCount == 0)
+            delete this;
+    }
+
+    uint32_t getReferenceCount() const
+    {
+        return referenceCount;
+    }
+
+    ValuePtr selfRef()
+    {
+        return ValuePtr(this);
+    }
+
+    static size_t getAllocatedInstanceCount()
+    {
+        return allocatedInstanceCount;
+    }
+
+    // Reports every slot that holds a counted reference onto another value.
+    virtual void visitSlots(SlotVisitor &visitor)
+    {
+        visitor.visit(sourcePosition);
+    }
 
     virtual ValuePtr getType() const;
     virtual ValuePtr getClass() const;
@@ -61,6 +164,8 @@ public:
     virtual bool isObject() const { return false; }
     virtual bool isEnvironment() const { return false; }
     virtual bool isSemanticValue() const { return false; }
+    virtual bool isSemanticLiteralValue() const { return false; }
+    virtual bool isSemanticValueSequence() const { return false; }
     virtual bool isSyntacticValue() const { return false; }
     virtual bool isSyntaxError() const { return false; }
     virtual bool isBindableName() const { return false; }
@@ -70,9 +175,12 @@ public:
     virtual bool isFunctionalDependentTypeNode() const { return false; }
     virtual bool isGradualType() const { return false; }
     virtual bool isMacro() const { return false; }
+    virtual bool isPureFunction() const { return false; }
     virtual bool isPointerLikeType() const {return false;}
     virtual bool isReferenceLikeType() const {return false;}
-    virtual ValuePtr getDecayedType() {return shared_from_this();}
+    virtual bool isPrimitiveNumberType() const {return false;}
+    virtual bool isLambdaValue() const {return false;}
+    virtual ValuePtr getDecayedType() {return selfRef();}
 
     virtual ValuePtr mutableLoadValue()
     {
@@ -93,6 +201,16 @@ public:
     virtual ValuePtr evaluateInEnvironment(const EnvironmentPtr &environment);
     virtual ValuePtr analyzeAndEvaluateInEnvironment(const EnvironmentPtr &environment);
     virtual ValuePtr analyzeIdentifierReferenceInEnvironment(const ValuePtr &syntaxNode, const EnvironmentPtr &environment);
+    virtual void compileBytecodeInto(BytecodeCompiler &compiler, uint16_t resultRegister);
+    virtual void compileBytecodeForEffect(BytecodeCompiler &compiler);
+    virtual void compileUnboxedBytecodeInto(BytecodeCompiler &compiler, uint16_t unboxedRegister, PrimitiveNumberKind kind);
+
+    // Evaluates ahead of time the parts of an analyzed tree that only depend on literals, and returns the replacement of this node.
+    virtual ValuePtr foldConstants();
+
+    // Marks the calls whose result is the result of the enclosing lambda, and returns the replacement of this node.
+    // The marked nodes are copies, because a node can also be the shared value of a binding that is evaluated elsewhere.
+    virtual ValuePtr markTailPosition();
 
     virtual bool parseAndUnpackArgumentsPattern(std::vector<ValuePtr> &argumentNodes, bool &isExistential, bool &isVariadic);
 
@@ -162,9 +280,30 @@ public:
     
     virtual SyntaxMessageCascadePtr asMessageCascade() const { return nullptr; }
 
-    virtual void traverseChildren(const std::function<void (ValuePtr)> &function) const
+    virtual void collectChildren(ChildList &children) const
+    {
+        (void)children;
+    }
+
+    // Calls the function on every node below me, in pre-order. The pending nodes are kept
+    // in an explicit stack, so finding the children of a node is its only virtual call.
+    template<typename FT>
+    void traverseChildren(const FT &function) const
     {
-        (void)function;
+        std::vector<Value*> pendingNodes;
+        ChildList pendingChildren(pendingNodes);
+        collectChildren(pendingChildren);
+        std::reverse(pendingNodes.begin(), pendingNodes.end());
+        while(!pendingNodes.empty())
+        {
+            auto node = pendingNodes.back();
+            pendingNodes.pop_back();
+            function(node);
+
+            auto firstChildIndex = pendingNodes.size();
+            node->collectChildren(pendingChildren);
+            std::reverse(pendingNodes.begin() + firstChildIndex, pendingNodes.end());
+        }
     }
 
     virtual ArgumentTypeAnalysisContextPtr createArgumentTypeAnalysisContext();
@@ -173,16 +312,40 @@ public:
     {
         std::vector<SyntaxErrorPtr> errors;
         if(isSyntaxError())
-            errors.push_back(std::static_pointer_cast<SyntaxError> (shared_from_this()));
+            errors.push_back(staticRefCast<SyntaxError> (selfRef()));
 
-        traverseChildren([&](ValuePtr value){
-            if(value->isSyntaxError())
-                errors.push_back(std::static_pointer_cast<SyntaxError> (value));
+        traverseChildren([&](Value *node){
+            if(node->isSyntaxError())
+                errors.push_back(staticRefCast<SyntaxError> (node->selfRef()));
         });
         return errors;
     }
 
     SourcePositionPtr sourcePosition;
+
+private:
+    friend class GarbageCollector;
+    friend class SlotVisitor;
+
+    enum class GCGeneration : uint8_t
+    {
+        Nursery,
+        Old,
+    };
+
+    enum class GCState : uint8_t
+    {
+        None,
+        Candidate,
+        Reachable,
+    };
+
+    static thread_local size_t allocatedInstanceCount;
+    uint32_t referenceCount = 0;
+    uint32_t gcIndex = 0;
+    uint32_t gcCount = 0;
+    GCGeneration gcGeneration = GCGeneration::Nursery;
+    GCState gcState = GCState::None;
 };
 
 class ArgumentTypeAnalysisContext : public Value
@@ -206,14 +369,38 @@ class LambdaValue : public Value
 public:
     virtual void printStringOn(std::ostream &out) const;
     virtual ValuePtr getType() const override;
+    virtual bool isLambdaValue() const override { return true; }
     virtual ValuePtr applyWithArguments(const std::vector<ValuePtr> &arguments);
 
+    /**
+     * A call in tail position stores itself as the pending tail call, and it returns the tail call marker instead of its result.
+     * The lambda application below it in the stack unwinds into a loop that performs the pending call.
+     */
+    static ValuePtr requestTailCall(const ValuePtr &functional, std::vector<ValuePtr> &&arguments);
+
+    virtual void visitSlots(SlotVisitor &visitor) override
+    {
+        Value::visitSlots(visitor);
+        visitor.visit(name);
+        visitor.visit(type);
+        visitor.visit(closure);
+        visitor.visit(fixpointBinding);
+        visitor.visit(argumentBindings);
+        visitor.visit(body);
+        visitor.visit(bytecode);
+    }
+
     SymbolPtr name;
     ValuePtr type;
     EnvironmentPtr closure;
     SymbolFixpointBindingPtr fixpointBinding;
     std::vector<SymbolArgumentBindingPtr> argumentBindings;
+    size_t frameSize = 0;
     ValuePtr body; 
+    BytecodeFunctionPtr bytecode;
+
+private:
+    ValuePtr evaluateBodyWithArguments(const std::vector<ValuePtr> &arguments, FunctionalActivationEnvironmentPtr &activationEnvironment);
 };
 
 